@@ -0,0 +1,206 @@
+#include "ToolLibraryGenerator.h"
+
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+
+namespace
+{
+enum class Malformation
+{
+    None,
+    BadIndent,
+    UnclosedQuote,
+    TabIndent,
+    ParamsNotSequence,
+    MissingEntry,
+};
+
+QByteArray quoted(const QString &value)
+{
+    QString escaped = value;
+    escaped.replace('\\', QStringLiteral("\\\\")).replace('"', QStringLiteral("\\\""));
+    return '"' + escaped.toUtf8() + '"';
+}
+
+int paramCountFor(QRandomGenerator &rng, int maxParams)
+{
+    // Most real tools take a handful of params; a long tail has dozens.
+    if (maxParams <= 0)
+    {
+        return 0;
+    }
+    if (rng.bounded(10) == 0)
+    {
+        return rng.bounded(maxParams / 2, maxParams + 1);
+    }
+    return rng.bounded(qMin(8, maxParams) + 1);
+}
+
+int optionCountFor(QRandomGenerator &rng, int maxOptions)
+{
+    if (maxOptions <= 2)
+    {
+        return qMax(1, maxOptions);
+    }
+    if (rng.bounded(20) == 0)
+    {
+        return rng.bounded(maxOptions / 2, maxOptions + 1);
+    }
+    return rng.bounded(2, qMin(12, maxOptions) + 1);
+}
+
+QByteArray renderManifest(const QString &id, int index, const GeneratorOptions &options, Malformation malformation,
+                          QRandomGenerator &rng, int &paramCount, int &optionCount)
+{
+    static const char *const kRuntimes[] = {"python", "r", "generic"};
+    static const char *const kTypes[] = {"text", "int", "double", "bool", "choice", "multi", "file", "dir"};
+
+    const char *runtime = kRuntimes[rng.bounded(3)];
+    QByteArray y;
+    y += "id: " + quoted(id) + '\n';
+    y += "name: " + quoted(QStringLiteral("合成工具 %1").arg(index)) + '\n';
+    y += "category: " + quoted(QStringLiteral("分类 %1").arg(rng.bounded(qMax(1, options.categories)))) + '\n';
+    y += "thumbnail: \"cover.png\"\n";
+    y += "version: \"1." + QByteArray::number(index % 10) + "\"\n";
+    if (malformation == Malformation::UnclosedQuote)
+    {
+        y += "description: \"synthetic tool without closing quote\n";
+    }
+    else
+    {
+        y += "description: " + quoted(QStringLiteral("Synthetic tool %1 for scan benchmarks.").arg(index)) + '\n';
+    }
+    y += "tags:\n  - synthetic\n  - " + QByteArray(runtime) + "\n  - t" + QByteArray::number(index % 50) + "\n\n";
+
+    y += "runtime:\n";
+    y += "  type: " + QByteArray(runtime) + '\n';
+    if (malformation != Malformation::MissingEntry)
+    {
+        y += "  entry: \"scripts/main.py\"\n";
+    }
+    y += "  args:\n";
+
+    paramCount = paramCountFor(rng, options.maxParams);
+    for (int p = 0; p < paramCount; ++p)
+    {
+        y += "    - \"--p" + QByteArray::number(p) + "\"\n";
+        y += "    - \"{{params.p" + QByteArray::number(p) + "}}\"\n";
+    }
+    if (malformation == Malformation::BadIndent)
+    {
+        y += "   shell: false\n";
+    }
+    else
+    {
+        y += "  shell: false\n";
+    }
+    y += "  timeout: 0\n\n";
+
+    y += "env:\n  strategy: none\n  dependencies:\n    - numpy\n    - pandas\n\n";
+
+    if (malformation == Malformation::ParamsNotSequence)
+    {
+        y += "params:\n  key: \"p0\"\n  - label: \"broken\"\n";
+        return y;
+    }
+
+    optionCount = 0;
+    y += "params:\n";
+    for (int p = 0; p < paramCount; ++p)
+    {
+        const char *type = kTypes[rng.bounded(8)];
+        y += "  - key: \"p" + QByteArray::number(p) + "\"\n";
+        if (malformation == Malformation::TabIndent && p == 0)
+        {
+            y += "\tlabel: \"tabbed\"\n";
+        }
+        else
+        {
+            y += "    label: " + quoted(QStringLiteral("参数 %1").arg(p)) + '\n';
+        }
+        y += "    type: " + QByteArray(type) + '\n';
+        y += "    required: " + QByteArray(rng.bounded(4) == 0 ? "true" : "false") + '\n';
+        y += "    description: \"Synthetic parameter used to pad the params block.\"\n";
+        if (qstrcmp(type, "choice") == 0 || qstrcmp(type, "multi") == 0)
+        {
+            const int count = optionCountFor(rng, options.maxOptions);
+            optionCount += count;
+            y += "    options:\n";
+            for (int o = 0; o < count; ++o)
+            {
+                if (o % 2 == 0)
+                {
+                    y += "      - \"option_" + QByteArray::number(o) + "\"\n";
+                }
+                else
+                {
+                    y += "      - label: \"Option " + QByteArray::number(o) + "\"\n";
+                    y += "        value: \"v" + QByteArray::number(o) + "\"\n";
+                }
+            }
+        }
+        else if (qstrcmp(type, "int") == 0 || qstrcmp(type, "double") == 0)
+        {
+            y += "    default: 1\n    min: 0\n    max: 100\n";
+        }
+    }
+    if (malformation == Malformation::TabIndent && paramCount == 0)
+    {
+        y += "\t- key: \"tabbed\"\n";
+    }
+    return y;
+}
+} // namespace
+
+bool ToolLibraryGenerator::generate(const QString &root, const GeneratorOptions &options, GeneratedLibrary &library, QString &error)
+{
+    QDir rootDir(root);
+    if (!rootDir.mkpath(QStringLiteral(".")))
+    {
+        error = QStringLiteral("Cannot create %1").arg(root);
+        return false;
+    }
+
+    library = GeneratedLibrary{};
+    library.root = rootDir.absolutePath();
+
+    QRandomGenerator rng(options.seed);
+    const int width = QString::number(qMax(1, options.toolCount - 1)).size();
+    for (int i = 0; i < options.toolCount; ++i)
+    {
+        const QString id = QStringLiteral("synth_%1").arg(i, width, 10, QChar('0'));
+        QString toolDir = options.groups > 0
+                              ? rootDir.filePath(QStringLiteral("group_%1/%2").arg(i % options.groups).arg(id))
+                              : rootDir.filePath(id);
+        if (!QDir().mkpath(toolDir))
+        {
+            error = QStringLiteral("Cannot create %1").arg(toolDir);
+            return false;
+        }
+
+        Malformation malformation = Malformation::None;
+        if (rng.generateDouble() < options.malformedRatio)
+        {
+            malformation = static_cast<Malformation>(1 + rng.bounded(5));
+            ++library.malformed;
+        }
+
+        int paramCount = 0;
+        int optionCount = 0;
+        const QByteArray manifest = renderManifest(id, i, options, malformation, rng, paramCount, optionCount);
+
+        QFile file(QDir(toolDir).filePath(QStringLiteral("tool.yaml")));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(manifest) != manifest.size())
+        {
+            error = QStringLiteral("Cannot write %1").arg(file.fileName());
+            return false;
+        }
+
+        library.toolDirs << toolDir;
+        library.totalParams += paramCount;
+        library.totalOptions += optionCount;
+        library.bytes += manifest.size();
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+// Writes a synthetic tools/ tree for scan benchmarks. Output is fully
+// determined by the options (seeded RNG), so two runs with the same options
+// produce byte-identical manifests.
+struct GeneratorOptions
+{
+    int toolCount{1000};
+    quint32 seed{1};
+    double malformedRatio{0.02}; // fraction of manifests that must fail to parse
+    int maxParams{40};
+    int maxOptions{200}; // upper bound for choice/multi option lists
+    int categories{12};
+    int groups{0}; // 0 = flat layout, otherwise tools are spread over group_N/ folders
+};
+
+struct GeneratedLibrary
+{
+    QString root;
+    QStringList toolDirs;
+    int malformed{0};
+    int totalParams{0};
+    int totalOptions{0};
+    qint64 bytes{0};
+};
+
+class ToolLibraryGenerator
+{
+public:
+    static bool generate(const QString &root, const GeneratorOptions &options, GeneratedLibrary &library, QString &error);
+};
@@ -0,0 +1,405 @@
+// Scan benchmark: generates a synthetic tools/ library (or uses an existing
+// one) and reports ScanWorker::scan wall time, per-manifest parse latency
+// percentiles, catalog footprint with and without string interning, search
+// latency per keystroke and peak memory.
+//
+//   scanbench --tools 5000 --malformed 0.02 --repeat 5
+//   scanbench --dir D:/shared/tools --depth 3 --json
+
+#include "ToolLibraryGenerator.h"
+
+#include "core/StringPool.h"
+#include "core/ToolFootprint.h"
+#include "core/ToolManifest.h"
+#include "core/ToolSearchIndex.h"
+#include "core/workers/ScanWorker.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+qint64 peakRssBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return static_cast<qint64>(counters.PeakWorkingSetSize);
+    }
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+#if defined(Q_OS_MACOS)
+    return static_cast<qint64>(usage.ru_maxrss); // bytes on macOS
+#else
+    return static_cast<qint64>(usage.ru_maxrss) * 1024; // KiB elsewhere
+#endif
+#else
+    return -1;
+#endif
+}
+
+struct LatencyStats
+{
+    int samples{0};
+    double p50{0};
+    double p90{0};
+    double p99{0};
+    double max{0};
+    double totalMs{0};
+
+    QJsonObject toJson() const
+    {
+        return {{QStringLiteral("samples"), samples},
+                {QStringLiteral("p50_us"), p50},
+                {QStringLiteral("p90_us"), p90},
+                {QStringLiteral("p99_us"), p99},
+                {QStringLiteral("max_us"), max},
+                {QStringLiteral("total_ms"), totalMs}};
+    }
+};
+
+LatencyStats summarize(std::vector<qint64> nanos)
+{
+    LatencyStats stats;
+    if (nanos.empty())
+    {
+        return stats;
+    }
+    std::sort(nanos.begin(), nanos.end());
+    auto percentile = [&nanos](double p) {
+        const size_t index = std::min(nanos.size() - 1, static_cast<size_t>(p * (nanos.size() - 1) + 0.5));
+        return nanos[index] / 1000.0;
+    };
+    stats.samples = static_cast<int>(nanos.size());
+    stats.p50 = percentile(0.50);
+    stats.p90 = percentile(0.90);
+    stats.p99 = percentile(0.99);
+    stats.max = nanos.back() / 1000.0;
+    qint64 total = 0;
+    for (qint64 n : nanos)
+    {
+        total += n;
+    }
+    stats.totalMs = total / 1e6;
+    return stats;
+}
+
+// Per-manifest latency of one decode phase, in library order.
+LatencyStats timeManifests(const QStringList &toolDirs, bool full, int &errors)
+{
+    std::vector<qint64> nanos;
+    nanos.reserve(toolDirs.size());
+    errors = 0;
+    QElapsedTimer timer;
+    for (const QString &dir : toolDirs)
+    {
+        QString error;
+        timer.start();
+        const ToolDTO tool = full ? ToolManifest::loadFull(dir, error) : ToolManifest::loadHeader(dir, error);
+        nanos.push_back(timer.nsecsElapsed());
+        Q_UNUSED(tool);
+        if (!error.isEmpty())
+        {
+            ++errors;
+        }
+    }
+    return summarize(std::move(nanos));
+}
+
+// Decodes every manifest and measures what the resulting catalog holds.
+ToolFootprint measureFootprint(const QStringList &toolDirs, bool full, bool interned)
+{
+    StringPool &pool = StringPool::instance();
+    pool.clear();
+    pool.setEnabled(interned);
+
+    QList<ToolHandle> tools;
+    tools.reserve(toolDirs.size());
+    for (const QString &dir : toolDirs)
+    {
+        QString error;
+        tools << ToolHandle::create(full ? ToolManifest::loadFull(dir, error) : ToolManifest::loadHeader(dir, error));
+    }
+    const ToolFootprint footprint = ToolFootprint::estimate(tools);
+    pool.setEnabled(true);
+    return footprint;
+}
+
+QJsonObject footprintJson(const ToolFootprint &f)
+{
+    return {{QStringLiteral("tools"), f.tools},
+            {QStringLiteral("total_bytes"), f.totalBytes},
+            {QStringLiteral("string_bytes"), f.stringBytes},
+            {QStringLiteral("bytes_per_tool"), f.bytesPerTool()},
+            {QStringLiteral("unique_buffers"), f.uniqueBuffers}};
+}
+
+QString formatFootprint(const ToolFootprint &plain, const ToolFootprint &interned)
+{
+    const double saved = plain.totalBytes > 0 ? 100.0 * (plain.totalBytes - interned.totalBytes) / plain.totalBytes : 0.0;
+    return QStringLiteral("%1 B/tool plain, %2 B/tool interned (-%3%)")
+        .arg(plain.bytesPerTool(), 0, 'f', 0)
+        .arg(interned.bytesPerTool(), 0, 'f', 0)
+        .arg(saved, 0, 'f', 1);
+}
+
+// Replays typing a few queries one keystroke at a time (including a typo that
+// only fuzzy matching resolves) against an index of the header catalog.
+LatencyStats measureSearch(const QStringList &toolDirs, qint64 &buildMs)
+{
+    QList<ToolHandle> tools;
+    tools.reserve(toolDirs.size());
+    for (const QString &dir : toolDirs)
+    {
+        QString error;
+        tools << ToolHandle::create(ToolManifest::loadHeader(dir, error));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    ToolSearchIndex index;
+    index.rebuild(tools);
+    buildMs = timer.elapsed();
+
+    static const QStringList queries{
+        QStringLiteral("synthetic tool"),
+        QStringLiteral("python table"),
+        QStringLiteral("pyhton"),
+        QStringLiteral("合成工具 12"),
+        QStringLiteral("分类 3"),
+        QStringLiteral("synth_0042"),
+    };
+    std::vector<qint64> nanos;
+    for (const QString &query : queries)
+    {
+        for (int length = 1; length <= query.size(); ++length)
+        {
+            timer.start();
+            const auto hits = index.search(query.left(length));
+            nanos.push_back(timer.nsecsElapsed());
+            Q_UNUSED(hits);
+        }
+    }
+    return summarize(std::move(nanos));
+}
+
+QStringList collectToolDirs(const ScanResultDTO &result)
+{
+    QStringList dirs;
+    for (const ToolHandle &tool : result.tools)
+    {
+        dirs << tool->toolDir;
+    }
+    return dirs;
+}
+
+QString formatBytes(qint64 bytes)
+{
+    if (bytes < 0)
+    {
+        return QStringLiteral("n/a");
+    }
+    return QStringLiteral("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+QString formatLatency(const LatencyStats &s)
+{
+    return QStringLiteral("p50 %1 us  p90 %2 us  p99 %3 us  max %4 us  (n=%5, total %6 ms)")
+        .arg(s.p50, 0, 'f', 1)
+        .arg(s.p90, 0, 'f', 1)
+        .arg(s.p99, 0, 'f', 1)
+        .arg(s.max, 0, 'f', 1)
+        .arg(s.samples)
+        .arg(s.totalMs, 0, 'f', 1);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName(QStringLiteral("ScriptToolbox"));
+    QCoreApplication::setApplicationName(QStringLiteral("ScriptToolboxBench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Benchmark ScanWorker against a synthetic or existing tools library."));
+    parser.addHelpOption();
+    const QCommandLineOption toolsOpt(QStringLiteral("tools"), QStringLiteral("Number of synthetic tools to generate."), QStringLiteral("n"), QStringLiteral("1000"));
+    const QCommandLineOption seedOpt(QStringLiteral("seed"), QStringLiteral("Generator seed."), QStringLiteral("seed"), QStringLiteral("1"));
+    const QCommandLineOption malformedOpt(QStringLiteral("malformed"), QStringLiteral("Fraction of malformed manifests."), QStringLiteral("ratio"), QStringLiteral("0.02"));
+    const QCommandLineOption maxParamsOpt(QStringLiteral("max-params"), QStringLiteral("Upper bound of params per tool."), QStringLiteral("n"), QStringLiteral("40"));
+    const QCommandLineOption maxOptionsOpt(QStringLiteral("max-options"), QStringLiteral("Upper bound of options per choice param."), QStringLiteral("n"), QStringLiteral("200"));
+    const QCommandLineOption groupsOpt(QStringLiteral("groups"), QStringLiteral("Spread tools over N group folders (scanned with depth 2)."), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption dirOpt(QStringLiteral("dir"), QStringLiteral("Benchmark an existing tools root instead of generating one."), QStringLiteral("path"));
+    const QCommandLineOption outOpt(QStringLiteral("out"), QStringLiteral("Generate into this folder and keep it."), QStringLiteral("path"));
+    const QCommandLineOption depthOpt(QStringLiteral("depth"), QStringLiteral("Scan depth below the root."), QStringLiteral("n"));
+    const QCommandLineOption repeatOpt(QStringLiteral("repeat"), QStringLiteral("Number of timed scans."), QStringLiteral("n"), QStringLiteral("3"));
+    const QCommandLineOption serialOpt(QStringLiteral("serial"), QStringLiteral("Disable parallel manifest parsing."));
+    const QCommandLineOption generateOnlyOpt(QStringLiteral("generate-only"), QStringLiteral("Write the library and exit."));
+    const QCommandLineOption jsonOpt(QStringLiteral("json"), QStringLiteral("Print results as JSON."));
+    parser.addOptions({toolsOpt, seedOpt, malformedOpt, maxParamsOpt, maxOptionsOpt, groupsOpt, dirOpt, outOpt, depthOpt,
+                       repeatOpt, serialOpt, generateOnlyOpt, jsonOpt});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    GeneratorOptions genOptions;
+    genOptions.toolCount = qMax(0, parser.value(toolsOpt).toInt());
+    genOptions.seed = parser.value(seedOpt).toUInt();
+    genOptions.malformedRatio = qBound(0.0, parser.value(malformedOpt).toDouble(), 1.0);
+    genOptions.maxParams = qMax(0, parser.value(maxParamsOpt).toInt());
+    genOptions.maxOptions = qMax(1, parser.value(maxOptionsOpt).toInt());
+    genOptions.groups = qMax(0, parser.value(groupsOpt).toInt());
+
+    ScanOptionsDTO scanOptions;
+    scanOptions.maxDepth = genOptions.groups > 0 ? 2 : 1;
+    if (parser.isSet(depthOpt))
+    {
+        scanOptions.maxDepth = qMax(1, parser.value(depthOpt).toInt());
+    }
+
+    QTemporaryDir tempDir;
+    GeneratedLibrary library;
+    qint64 generateMs = -1;
+    if (parser.isSet(dirOpt))
+    {
+        scanOptions.roots << parser.value(dirOpt);
+    }
+    else
+    {
+        const QString root = parser.isSet(outOpt) ? parser.value(outOpt) : tempDir.filePath(QStringLiteral("tools"));
+        if (!parser.isSet(outOpt) && !tempDir.isValid())
+        {
+            err << "Cannot create temporary directory\n";
+            return 1;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        QString error;
+        if (!ToolLibraryGenerator::generate(root, genOptions, library, error))
+        {
+            err << error << '\n';
+            return 1;
+        }
+        generateMs = timer.elapsed();
+        scanOptions.roots << library.root;
+        if (parser.isSet(generateOnlyOpt))
+        {
+            out << "Generated " << library.toolDirs.size() << " tools (" << library.malformed << " malformed) in "
+                << library.root << '\n';
+            return 0;
+        }
+    }
+
+    const qint64 baselineRss = peakRssBytes();
+
+    // Wall time of the full scan as the app runs it, minus the persistent
+    // catalog cache so every repetition parses every manifest.
+    const int repeat = qMax(1, parser.value(repeatOpt).toInt());
+    std::vector<qint64> scanMs;
+    ScanResultDTO lastResult;
+    for (int r = 0; r < repeat; ++r)
+    {
+        ScanWorker worker;
+        worker.setCacheEnabled(false);
+        worker.setParallel(!parser.isSet(serialOpt));
+        QObject::connect(&worker, &ScanWorker::scanFinished, [&lastResult](const ScanResultDTO &result)
+                         { lastResult = result; });
+        QElapsedTimer timer;
+        timer.start();
+        worker.scan(scanOptions);
+        scanMs.push_back(timer.elapsed());
+    }
+    const qint64 scanPeakRss = peakRssBytes();
+    std::sort(scanMs.begin(), scanMs.end());
+
+    const QStringList toolDirs = library.toolDirs.isEmpty() ? collectToolDirs(lastResult) : library.toolDirs;
+    int headerErrors = 0;
+    int fullErrors = 0;
+    const LatencyStats header = timeManifests(toolDirs, false, headerErrors);
+    const LatencyStats full = timeManifests(toolDirs, true, fullErrors);
+    const ToolFootprint headerPlain = measureFootprint(toolDirs, false, false);
+    const ToolFootprint headerInterned = measureFootprint(toolDirs, false, true);
+    const ToolFootprint fullPlain = measureFootprint(toolDirs, true, false);
+    const ToolFootprint fullInterned = measureFootprint(toolDirs, true, true);
+    qint64 indexBuildMs = 0;
+    const LatencyStats search = measureSearch(toolDirs, indexBuildMs);
+    const int scanErrors = lastResult.error.isEmpty() ? 0 : lastResult.error.count('\n') + 1;
+
+    if (parser.isSet(jsonOpt))
+    {
+        QJsonObject report;
+        report.insert(QStringLiteral("roots"), QJsonArray::fromStringList(scanOptions.roots));
+        report.insert(QStringLiteral("manifests"), toolDirs.size());
+        report.insert(QStringLiteral("generated_malformed"), library.malformed);
+        report.insert(QStringLiteral("generated_params"), library.totalParams);
+        report.insert(QStringLiteral("generated_options"), library.totalOptions);
+        report.insert(QStringLiteral("generate_ms"), generateMs);
+        report.insert(QStringLiteral("parallel"), !parser.isSet(serialOpt));
+        QJsonArray runs;
+        for (qint64 ms : scanMs)
+        {
+            runs.append(ms);
+        }
+        report.insert(QStringLiteral("scan_ms"), runs);
+        report.insert(QStringLiteral("scan_tools"), lastResult.tools.size());
+        report.insert(QStringLiteral("scan_errors"), scanErrors);
+        report.insert(QStringLiteral("header_parse"), header.toJson());
+        report.insert(QStringLiteral("header_errors"), headerErrors);
+        report.insert(QStringLiteral("full_parse"), full.toJson());
+        report.insert(QStringLiteral("full_errors"), fullErrors);
+        report.insert(QStringLiteral("footprint_header_plain"), footprintJson(headerPlain));
+        report.insert(QStringLiteral("footprint_header_interned"), footprintJson(headerInterned));
+        report.insert(QStringLiteral("footprint_full_plain"), footprintJson(fullPlain));
+        report.insert(QStringLiteral("footprint_full_interned"), footprintJson(fullInterned));
+        report.insert(QStringLiteral("search_index_build_ms"), indexBuildMs);
+        report.insert(QStringLiteral("search_keystroke"), search.toJson());
+        report.insert(QStringLiteral("peak_rss_baseline"), baselineRss);
+        report.insert(QStringLiteral("peak_rss_scan"), scanPeakRss);
+        report.insert(QStringLiteral("peak_rss_end"), peakRssBytes());
+        out << QJsonDocument(report).toJson(QJsonDocument::Indented);
+        return 0;
+    }
+
+    out << "Library      " << scanOptions.roots.join(QStringLiteral(", ")) << '\n';
+    if (generateMs >= 0)
+    {
+        out << "Generated    " << library.toolDirs.size() << " tools, " << library.malformed << " malformed, "
+            << library.totalParams << " params, " << library.totalOptions << " options, "
+            << formatBytes(library.bytes) << " in " << generateMs << " ms\n";
+    }
+    out << "Scan         min " << scanMs.front() << " ms  median " << scanMs[scanMs.size() / 2] << " ms  max "
+        << scanMs.back() << " ms  (" << repeat << " runs, " << (parser.isSet(serialOpt) ? "serial" : "parallel") << ")\n";
+    out << "Scan result  " << lastResult.tools.size() << " tools, " << scanErrors << " errors\n";
+    out << "Header parse " << formatLatency(header) << ", " << headerErrors << " errors\n";
+    out << "Full parse   " << formatLatency(full) << ", " << fullErrors << " errors\n";
+    out << "Header size  " << formatFootprint(headerPlain, headerInterned) << '\n';
+    out << "Full size    " << formatFootprint(fullPlain, fullInterned) << '\n';
+    out << "Search       index " << indexBuildMs << " ms, per keystroke " << formatLatency(search) << '\n';
+    out << "Peak RSS     baseline " << formatBytes(baselineRss) << "  after scan " << formatBytes(scanPeakRss)
+        << "  end " << formatBytes(peakRssBytes()) << '\n';
+    return 0;
+}
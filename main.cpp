@@ -1,8 +1,9 @@
+#include "core/AppSettings.h"
 #include "core/CoreService.h"
 #include "ui/MainWindow.h"
 
 #include <QApplication>
-#include <QDir>
+#include <QSettings>
 
 int main(int argc, char *argv[])
 {
@@ -15,31 +16,14 @@ int main(int argc, char *argv[])
 #endif
     QCoreApplication::setApplicationVersion(QStringLiteral(APP_VERSION));
 
+    QSettings settings;
     CoreService core;
     core.start();
+    const QString toolsRoot = AppSettings::defaultToolsRoot();
+    AppSettings::apply(settings, toolsRoot, core);
+    const ScanOptionsDTO scanOptions = AppSettings::scanOptions(settings, toolsRoot);
 
-    QDir exeDir(QCoreApplication::applicationDirPath());
-    QStringList candidates;
-    candidates << QDir(exeDir).filePath(QStringLiteral("tools"));
-    QDir parentDir(exeDir);
-    parentDir.cdUp();
-    candidates << parentDir.filePath(QStringLiteral("tools"));
-
-    QString toolsRoot;
-    for (const QString &c : candidates)
-    {
-        if (QDir(c).exists())
-        {
-            toolsRoot = c;
-            break;
-        }
-    }
-    if (toolsRoot.isEmpty())
-    {
-        toolsRoot = candidates.value(0);
-    }
-
-    MainWindow window(&core, toolsRoot);
+    MainWindow window(&core, scanOptions);
     window.resize(960, 640);
     window.setWindowTitle(QStringLiteral("Script Toolbox"));
     window.show();
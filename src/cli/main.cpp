@@ -0,0 +1,705 @@
+// Headless runner over corelib: scans the tool library and lists, validates
+// or runs tools without a display, for cron jobs and CI. Results are printed
+// as JSON on stdout; notes and (with --stream) tool output go to stderr,
+// while the full output stays in each run's logs/ as with the GUI.
+//
+//   toolboxcli list
+//   toolboxcli validate python_plot_demo --param title=Demo --param points=120
+//   toolboxcli run python_plot_demo --param points=120 --stream
+//   toolboxcli batch python_plot_demo --sweep points=16..720:16 --max-concurrent 8
+//   toolboxcli batch r_table_demo --csv rows.csv --root /srv/tools
+//
+// Exit status: 0 success, 1 failed runs, invalid params or manifest errors,
+// 2 usage errors or no tool library.
+
+#include "core/AppSettings.h"
+#include "core/CoreService.h"
+#include "core/ParamSweep.h"
+#include "core/ParamValidator.h"
+#include "core/RunMetadata.h"
+#include "core/RunProgress.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QSettings>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <csignal>
+#include <functional>
+
+namespace
+{
+enum ExitCode
+{
+    kExitOk = 0,
+    kExitFailed = 1,
+    kExitUsage = 2
+};
+
+volatile std::sig_atomic_t g_interrupted = 0;
+
+void handleSignal(int)
+{
+    g_interrupted = 1;
+}
+
+QTextStream &errStream()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+void note(const QString &text)
+{
+    errStream() << text << Qt::endl;
+}
+
+struct Options
+{
+    bool compact{false};
+    bool stream{false};
+    bool noEnv{false};
+    bool details{false};
+};
+
+void printJson(const QJsonDocument &doc, const Options &options)
+{
+    QFile out;
+    if (!out.open(stdout, QIODevice::WriteOnly))
+    {
+        return;
+    }
+    out.write(doc.toJson(options.compact ? QJsonDocument::Compact : QJsonDocument::Indented));
+    if (options.compact)
+    {
+        out.write("\n");
+    }
+}
+
+// Spins loop until it is quit; SIGINT/SIGTERM call onInterrupt once, after
+// which the loop still waits for the cancelled work to report back.
+void waitFor(QEventLoop &loop, const std::function<void()> &onInterrupt)
+{
+    QTimer poll;
+    poll.setInterval(200);
+    bool interrupted = false;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]()
+                     {
+        if (g_interrupted && !interrupted)
+        {
+            interrupted = true;
+            note(QStringLiteral("Interrupted; cancelling"));
+            onInterrupt();
+        } });
+    poll.start();
+    loop.exec();
+}
+
+QString paramTypeName(ParamType type)
+{
+    switch (type)
+    {
+    case ParamType::File:
+        return QStringLiteral("file");
+    case ParamType::Dir:
+        return QStringLiteral("dir");
+    case ParamType::Select:
+        return QStringLiteral("select");
+    case ParamType::Int:
+        return QStringLiteral("int");
+    case ParamType::Float:
+        return QStringLiteral("float");
+    case ParamType::Text:
+        return QStringLiteral("text");
+    case ParamType::Bool:
+        return QStringLiteral("bool");
+    case ParamType::Unknown:
+        break;
+    }
+    return QStringLiteral("unknown");
+}
+
+QJsonObject paramToJson(const ParamDTO &param)
+{
+    QJsonObject obj;
+    obj.insert(QStringLiteral("key"), param.key);
+    obj.insert(QStringLiteral("label"), param.label);
+    obj.insert(QStringLiteral("type"), paramTypeName(param.type));
+    obj.insert(QStringLiteral("required"), param.required);
+    obj.insert(QStringLiteral("multi"), param.multi);
+    if (!param.defaultValue.isEmpty())
+    {
+        obj.insert(QStringLiteral("default"), param.defaultValue);
+    }
+    if (param.max > param.min)
+    {
+        obj.insert(QStringLiteral("min"), param.min);
+        obj.insert(QStringLiteral("max"), param.max);
+    }
+    if (!param.options.isEmpty())
+    {
+        QJsonArray options;
+        for (const ParamOption &option : param.options)
+        {
+            options.append(option.value);
+        }
+        obj.insert(QStringLiteral("options"), options);
+    }
+    if (!param.pattern.isEmpty())
+    {
+        obj.insert(QStringLiteral("pattern"), param.pattern);
+    }
+    return obj;
+}
+
+QJsonObject toolToJson(const ToolDTO &tool, bool details)
+{
+    QJsonObject obj;
+    obj.insert(QStringLiteral("id"), tool.id);
+    obj.insert(QStringLiteral("name"), tool.name);
+    obj.insert(QStringLiteral("version"), tool.version);
+    obj.insert(QStringLiteral("category"), tool.category);
+    obj.insert(QStringLiteral("description"), tool.description);
+    obj.insert(QStringLiteral("tags"), QJsonArray::fromStringList(tool.tags));
+    obj.insert(QStringLiteral("runtime"), tool.runtime.type);
+    obj.insert(QStringLiteral("toolDir"), tool.toolDir);
+    if (details)
+    {
+        QJsonArray params;
+        for (const ParamDTO &param : tool.params)
+        {
+            params.append(paramToJson(param));
+        }
+        obj.insert(QStringLiteral("params"), params);
+    }
+    return obj;
+}
+
+// "key=value"; a key given several times collects several values.
+bool parseParams(const QStringList &specs, QList<RunParamValueDTO> &params, QString &error)
+{
+    for (const QString &spec : specs)
+    {
+        const qsizetype eq = spec.indexOf(QLatin1Char('='));
+        if (eq <= 0)
+        {
+            error = QStringLiteral("Expected key=value, got '%1'").arg(spec);
+            return false;
+        }
+        const QString key = spec.left(eq).trimmed();
+        const QString value = spec.mid(eq + 1);
+        auto it = std::find_if(params.begin(), params.end(), [&key](const RunParamValueDTO &param)
+                               { return param.key == key; });
+        if (it == params.end())
+        {
+            params.append(RunParamValueDTO{key, {value}});
+        }
+        else
+        {
+            it->values << value;
+        }
+    }
+    return true;
+}
+
+const ParamDTO *findParam(const ToolDTO &tool, const QString &key)
+{
+    for (const ParamDTO &param : tool.params)
+    {
+        if (param.key == key)
+        {
+            return &param;
+        }
+    }
+    return nullptr;
+}
+
+class Runner
+{
+public:
+    Runner(CoreService &core, const Options &options)
+        : m_core(core), m_options(options)
+    {
+    }
+
+    bool scan(const ScanOptionsDTO &scanOptions, ScanResultDTO &result)
+    {
+        QEventLoop loop;
+        QObject::connect(&m_core, &CoreService::scanFinished, &loop, [&](const ScanResultDTO &finished)
+                         {
+            result = finished;
+            loop.quit(); });
+        m_core.startScan(scanOptions);
+        waitFor(loop, [&loop]()
+                { loop.quit(); });
+        return !g_interrupted;
+    }
+
+    int list(const QList<ToolHandle> &tools)
+    {
+        QJsonArray array;
+        int status = kExitOk;
+        for (const ToolHandle &header : tools)
+        {
+            QString error;
+            const ToolHandle tool = m_options.details ? m_core.loadToolDetails(header->toolsRoot, header, error) : header;
+            QJsonObject obj = toolToJson(*tool, m_options.details);
+            if (!error.isEmpty())
+            {
+                obj.insert(QStringLiteral("manifestError"), error);
+                status = kExitFailed;
+            }
+            array.append(obj);
+        }
+        printJson(QJsonDocument(array), m_options);
+        return status;
+    }
+
+    int validate(const ToolHandle &tool, const QString &manifestError, QList<RunParamValueDTO> params)
+    {
+        QStringList errors;
+        const bool valid = ParamValidator::validate(tool->params, params, errors) && manifestError.isEmpty();
+        QJsonObject obj;
+        obj.insert(QStringLiteral("toolId"), tool->id);
+        obj.insert(QStringLiteral("valid"), valid);
+        obj.insert(QStringLiteral("errors"), QJsonArray::fromStringList(errors));
+        if (!manifestError.isEmpty())
+        {
+            obj.insert(QStringLiteral("manifestError"), manifestError);
+        }
+        obj.insert(QStringLiteral("params"), RunMetadata::paramsToJson(params));
+        printJson(QJsonDocument(obj), m_options);
+        return valid ? kExitOk : kExitFailed;
+    }
+
+    int run(const ToolHandle &tool, const RunRequestDTO &request)
+    {
+        QEventLoop loop;
+        QString runId;
+        QString runDirectory;
+        int exitCode = -1;
+        QString message;
+        RunMetricsDTO metrics;
+        bool haveMetrics = false;
+        RunProgressDTO progress;
+        bool haveProgress = false;
+        bool cancelled = false;
+
+        QObject::connect(&m_core, &CoreService::jobStarted, &loop, [&](const QString &id, const QString &, const QString &directory)
+                         {
+            if (id == runId)
+            {
+                runDirectory = directory;
+            } });
+        if (m_options.stream)
+        {
+            QObject::connect(&m_core, &CoreService::jobOutput, &loop, [&](const QString &id, const QString &, const QStringList &lines, bool)
+                             {
+                if (id == runId)
+                {
+                    for (const QString &line : lines)
+                    {
+                        errStream() << line << '\n';
+                    }
+                    errStream().flush();
+                } });
+        }
+        QObject::connect(&m_core, &CoreService::jobMetrics, &loop, [&](const QString &id, const QString &, const RunMetricsDTO &reported)
+                         {
+            if (id == runId)
+            {
+                metrics = reported;
+                haveMetrics = true;
+            } });
+        QObject::connect(&m_core, &CoreService::jobProgress, &loop, [&](const QString &id, const QString &, const RunProgressDTO &reported)
+                         {
+            if (id == runId)
+            {
+                progress = reported;
+                haveProgress = true;
+            } });
+        QObject::connect(&m_core, &CoreService::jobFinished, &loop, [&](const QString &id, const QString &, int code, const QString &text)
+                         {
+            if (id == runId)
+            {
+                exitCode = code;
+                message = text;
+                loop.quit();
+            } });
+
+        QElapsedTimer clock;
+        clock.start();
+        runId = m_options.noEnv ? m_core.runJob(tool->toolsRoot, tool, request) : m_core.runTool(tool->toolsRoot, tool, request);
+        if (runId.isEmpty())
+        {
+            note(QStringLiteral("Cannot start %1").arg(tool->id));
+            return kExitFailed;
+        }
+        waitFor(loop, [&]()
+                {
+            cancelled = true;
+            m_core.cancelRun(runId); });
+
+        QJsonObject obj;
+        obj.insert(QStringLiteral("runId"), runId);
+        obj.insert(QStringLiteral("toolId"), tool->id);
+        obj.insert(QStringLiteral("status"), cancelled ? QStringLiteral("cancelled") : exitCode == 0 ? QStringLiteral("succeeded")
+                                                                                                  : QStringLiteral("failed"));
+        obj.insert(QStringLiteral("exitCode"), exitCode);
+        obj.insert(QStringLiteral("message"), message);
+        obj.insert(QStringLiteral("runDirectory"), runDirectory);
+        obj.insert(QStringLiteral("durationMs"), clock.elapsed());
+        obj.insert(QStringLiteral("params"), RunMetadata::paramsToJson(request.params));
+        if (haveMetrics)
+        {
+            obj.insert(QStringLiteral("metrics"), RunMetadata::metricsToJson(metrics));
+        }
+        if (haveProgress)
+        {
+            obj.insert(QStringLiteral("progress"), RunProgress::toJson(progress));
+        }
+        printJson(QJsonDocument(obj), m_options);
+        return exitCode == 0 && !cancelled ? kExitOk : kExitFailed;
+    }
+
+    int batch(const ToolHandle &tool, const BatchRequestDTO &request)
+    {
+        QEventLoop loop;
+        QString batchId;
+        BatchSummaryDTO summary;
+
+        if (m_options.stream)
+        {
+            // Only this batch runs here, so every run's output belongs to it.
+            QObject::connect(&m_core, &CoreService::jobOutput, &loop, [](const QString &id, const QString &, const QStringList &lines, bool)
+                             {
+                for (const QString &line : lines)
+                {
+                    errStream() << '[' << id << "] " << line << '\n';
+                }
+                errStream().flush(); });
+        }
+        QObject::connect(&m_core, &CoreService::batchProgress, &loop, [&](const QString &id, int finished, int total)
+                         {
+            const int step = qMax(1, total / 20);
+            if (id == batchId && finished % step == 0 && finished != total)
+            {
+                note(QStringLiteral("%1/%2 runs finished").arg(finished).arg(total));
+            } });
+        QObject::connect(&m_core, &CoreService::batchFinished, &loop, [&](const BatchSummaryDTO &finished)
+                         {
+            if (finished.batchId == batchId)
+            {
+                summary = finished;
+                loop.quit();
+            } });
+
+        QString error;
+        batchId = m_core.runBatch(tool->toolsRoot, tool, request, error);
+        if (batchId.isEmpty())
+        {
+            note(QStringLiteral("Cannot start batch: %1").arg(error));
+            return kExitFailed;
+        }
+        note(QStringLiteral("Batch %1: %2 runs").arg(batchId).arg(ParamSweep::runCount(request)));
+        waitFor(loop, [&]()
+                { m_core.cancelBatch(batchId); });
+
+        QJsonArray runs;
+        for (const BatchRunResultDTO &run : summary.runs)
+        {
+            runs.append(RunMetadata::batchRunToJson(run));
+        }
+        QJsonObject obj;
+        obj.insert(QStringLiteral("batchId"), summary.batchId);
+        obj.insert(QStringLiteral("toolId"), summary.toolId);
+        obj.insert(QStringLiteral("total"), summary.total);
+        obj.insert(QStringLiteral("succeeded"), summary.succeeded);
+        obj.insert(QStringLiteral("failed"), summary.failed);
+        obj.insert(QStringLiteral("cancelled"), summary.cancelled);
+        obj.insert(QStringLiteral("wallMs"), summary.wallMs);
+        obj.insert(QStringLiteral("summaryPath"), summary.summaryPath);
+        obj.insert(QStringLiteral("runs"), runs);
+        printJson(QJsonDocument(obj), m_options);
+        return summary.failed == 0 && summary.cancelled == 0 ? kExitOk : kExitFailed;
+    }
+
+private:
+    CoreService &m_core;
+    Options m_options;
+};
+
+int usage(const QCommandLineParser &parser, const QString &error)
+{
+    if (!error.isEmpty())
+    {
+        note(error);
+    }
+    note(parser.helpText());
+    return kExitUsage;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // Same settings (and catalog cache) as the GUI.
+    QCoreApplication::setOrganizationName(QStringLiteral("ScriptToolbox"));
+    QCoreApplication::setApplicationName(QStringLiteral("ScriptToolbox"));
+#ifndef APP_VERSION
+#define APP_VERSION "0.0.0-dev"
+#endif
+    QCoreApplication::setApplicationVersion(QStringLiteral(APP_VERSION));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Script Toolbox command-line runner"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument(QStringLiteral("command"), QStringLiteral("scan | list | validate | run | batch"));
+    parser.addPositionalArgument(QStringLiteral("tool"), QStringLiteral("Tool id (validate, run, batch)"), QStringLiteral("[tool]"));
+    const QCommandLineOption rootOption(QStringLiteral("root"), QStringLiteral("Tools root; repeatable. Default: tools/ next to the executable plus scan/extraRoots."), QStringLiteral("dir"));
+    const QCommandLineOption depthOption(QStringLiteral("depth"), QStringLiteral("Levels below each root searched for tool.yaml."), QStringLiteral("n"));
+    const QCommandLineOption paramOption(QStringLiteral("param"), QStringLiteral("Parameter value; repeat a key for multi-value params."), QStringLiteral("key=value"));
+    const QCommandLineOption sweepOption(QStringLiteral("sweep"), QStringLiteral("Batch axis: comma separated values, start..end[:step] or *."), QStringLiteral("key=spec"));
+    const QCommandLineOption csvOption(QStringLiteral("csv"), QStringLiteral("Batch rows: one column per param key, one run per row."), QStringLiteral("file"));
+    const QCommandLineOption concurrentOption(QStringLiteral("max-concurrent"), QStringLiteral("Runs of the batch in flight at once (0 = global limit)."), QStringLiteral("n"));
+    const QCommandLineOption jobsOption(QStringLiteral("jobs"), QStringLiteral("Global limit of concurrent runs (default: jobs/maxConcurrent, else CPU cores)."), QStringLiteral("n"));
+    const QCommandLineOption runDirOption(QStringLiteral("run-dir"), QStringLiteral("Run directory instead of runs/<timestamp>_<tool>_<n>."), QStringLiteral("dir"));
+    const QCommandLineOption noEnvOption(QStringLiteral("no-env"), QStringLiteral("Run without preparing the tool's environment."));
+    const QCommandLineOption streamOption(QStringLiteral("stream"), QStringLiteral("Echo tool output to stderr."));
+    const QCommandLineOption detailsOption(QStringLiteral("details"), QStringLiteral("list: decode full manifests and include params."));
+    const QCommandLineOption compactOption(QStringLiteral("compact"), QStringLiteral("Print JSON on one line."));
+    const QCommandLineOption verboseOption(QStringLiteral("verbose"), QStringLiteral("Log core activity to stderr."));
+    parser.addOptions({rootOption, depthOption, paramOption, sweepOption, csvOption, concurrentOption, jobsOption, runDirOption,
+                       noEnvOption, streamOption, detailsOption, compactOption, verboseOption});
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    const QString command = positional.value(0);
+    const QString toolId = positional.value(1);
+    static const QStringList commands{QStringLiteral("scan"), QStringLiteral("list"), QStringLiteral("validate"), QStringLiteral("run"), QStringLiteral("batch")};
+    if (!commands.contains(command))
+    {
+        return usage(parser, command.isEmpty() ? QString() : QStringLiteral("Unknown command '%1'").arg(command));
+    }
+    const bool needsTool = command != QStringLiteral("scan") && command != QStringLiteral("list");
+    if (needsTool && toolId.isEmpty())
+    {
+        return usage(parser, QStringLiteral("'%1' needs a tool id").arg(command));
+    }
+
+    if (!parser.isSet(verboseOption))
+    {
+        QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false\n*.info=false"));
+    }
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    Options options;
+    options.compact = parser.isSet(compactOption);
+    options.stream = parser.isSet(streamOption);
+    options.noEnv = parser.isSet(noEnvOption);
+    options.details = parser.isSet(detailsOption);
+
+    QSettings settings;
+    const QStringList roots = parser.values(rootOption);
+    const QString toolsRoot = roots.isEmpty() ? AppSettings::defaultToolsRoot() : roots.first();
+    ScanOptionsDTO scanOptions = AppSettings::scanOptions(settings, toolsRoot);
+    if (!roots.isEmpty())
+    {
+        scanOptions.roots = roots;
+    }
+    if (parser.isSet(depthOption))
+    {
+        scanOptions.maxDepth = qMax(1, parser.value(depthOption).toInt());
+    }
+
+    CoreService core;
+    core.start();
+    AppSettings::apply(settings, toolsRoot, core);
+    if (const int jobs = parser.value(jobsOption).toInt(); jobs > 0)
+    {
+        core.setMaxConcurrentJobs(jobs);
+    }
+    Runner runner(core, options);
+
+    QElapsedTimer scanClock;
+    scanClock.start();
+    ScanResultDTO scanned;
+    if (!runner.scan(scanOptions, scanned))
+    {
+        core.shutdown();
+        return kExitFailed;
+    }
+    const QStringList scanErrors = scanned.error.isEmpty() ? QStringList() : scanned.error.split(QLatin1Char('\n'));
+    if (scanned.tools.isEmpty() && !scanErrors.isEmpty())
+    {
+        for (const QString &error : scanErrors)
+        {
+            note(error);
+        }
+        core.shutdown();
+        return kExitUsage;
+    }
+
+    int status = kExitOk;
+    if (command == QStringLiteral("scan"))
+    {
+        QJsonObject obj;
+        obj.insert(QStringLiteral("roots"), QJsonArray::fromStringList(scanOptions.roots));
+        obj.insert(QStringLiteral("depth"), scanOptions.maxDepth);
+        obj.insert(QStringLiteral("tools"), scanned.tools.size());
+        obj.insert(QStringLiteral("errors"), QJsonArray::fromStringList(scanErrors));
+        obj.insert(QStringLiteral("elapsedMs"), scanClock.elapsed());
+        printJson(QJsonDocument(obj), options);
+        status = scanErrors.isEmpty() ? kExitOk : kExitFailed;
+    }
+    else if (command == QStringLiteral("list"))
+    {
+        status = runner.list(scanned.tools);
+    }
+    else
+    {
+        ToolHandle header;
+        for (const ToolHandle &tool : std::as_const(scanned.tools))
+        {
+            if (tool->id == toolId)
+            {
+                header = tool;
+                break;
+            }
+        }
+        if (!header)
+        {
+            note(QStringLiteral("No tool '%1' under %2").arg(toolId, scanOptions.roots.join(QStringLiteral(", "))));
+            core.shutdown();
+            return kExitUsage;
+        }
+        QString manifestError;
+        const ToolHandle tool = core.loadToolDetails(header->toolsRoot, header, manifestError);
+
+        RunRequestDTO request;
+        request.toolId = tool->id;
+        request.toolVersion = tool->version;
+        request.runDirectory = parser.value(runDirOption);
+        QString error;
+        if (!parseParams(parser.values(paramOption), request.params, error))
+        {
+            core.shutdown();
+            return usage(parser, error);
+        }
+
+        if (command == QStringLiteral("validate"))
+        {
+            status = runner.validate(tool, manifestError, request.params);
+        }
+        else if (command == QStringLiteral("run"))
+        {
+            QStringList errors;
+            if (!ParamValidator::validate(tool->params, request.params, errors))
+            {
+                for (const QString &problem : errors)
+                {
+                    note(problem);
+                }
+                core.shutdown();
+                return kExitFailed;
+            }
+            if (!manifestError.isEmpty())
+            {
+                note(manifestError);
+            }
+            status = runner.run(tool, request);
+        }
+        else
+        {
+            BatchRequestDTO batch;
+            batch.maxConcurrent = qMax(0, parser.value(concurrentOption).toInt());
+            for (const QString &spec : parser.values(sweepOption))
+            {
+                const qsizetype eq = spec.indexOf(QLatin1Char('='));
+                const ParamDTO *param = eq > 0 ? findParam(*tool, spec.left(eq).trimmed()) : nullptr;
+                SweepAxisDTO axis;
+                if (!param)
+                {
+                    error = QStringLiteral("Expected key=spec with a param of %1, got '%2'").arg(tool->id, spec);
+                }
+                else if (ParamSweep::parseAxis(*param, spec.mid(eq + 1), axis.values, error))
+                {
+                    axis.key = param->key;
+                    batch.axes.append(axis);
+                    continue;
+                }
+                core.shutdown();
+                return usage(parser, error);
+            }
+            if (parser.isSet(csvOption))
+            {
+                QFile csv(parser.value(csvOption));
+                if (!csv.open(QIODevice::ReadOnly) || !ParamSweep::parseCsv(QString::fromUtf8(csv.readAll()), tool->params, batch.rows, error))
+                {
+                    core.shutdown();
+                    return usage(parser, error.isEmpty() ? QStringLiteral("Cannot read %1: %2").arg(csv.fileName(), csv.errorString()) : error);
+                }
+            }
+
+            // Swept values are checked by ParamSweep; check the rest with the
+            // first run's values standing in for the swept ones.
+            QList<RunParamValueDTO> sample = request.params;
+            const auto setSample = [&sample](const QString &key, const QStringList &values)
+            {
+                auto it = std::find_if(sample.begin(), sample.end(), [&key](const RunParamValueDTO &param)
+                                       { return param.key == key; });
+                if (it == sample.end())
+                {
+                    sample.append(RunParamValueDTO{key, values});
+                }
+                else
+                {
+                    it->values = values;
+                }
+            };
+            if (!batch.rows.isEmpty())
+            {
+                for (const RunParamValueDTO &value : batch.rows.first())
+                {
+                    setSample(value.key, value.values);
+                }
+            }
+            else
+            {
+                for (const SweepAxisDTO &axis : std::as_const(batch.axes))
+                {
+                    setSample(axis.key, {axis.values.first()});
+                }
+            }
+            QStringList errors;
+            if (!ParamValidator::validate(tool->params, sample, errors))
+            {
+                for (const QString &problem : errors)
+                {
+                    note(problem);
+                }
+                core.shutdown();
+                return kExitFailed;
+            }
+            // Defaults are filled in here once rather than by every run.
+            QStringList ignored;
+            ParamValidator::validate(tool->params, request.params, ignored);
+            batch.base = request;
+            status = runner.batch(tool, batch);
+        }
+    }
+
+    core.shutdown();
+    return status;
+}
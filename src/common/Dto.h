@@ -3,9 +3,13 @@
 #include <QList>
 #include <QMap>
 #include <QMetaType>
+#include <QPair>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 
+class ArgTemplate;
+
 enum class ParamType
 {
     File,
@@ -55,16 +59,71 @@ struct SetupCommandDTO
     QString workdir{"."};
 };
 
+// runtime.shard: split one file param into record-aligned pieces, run the tool
+// once per piece and merge the results into the run's outputs/.
+struct ShardConfigDTO
+{
+    QString param;              // file param whose input is split; empty = not shardable
+    QString recordStart;        // records begin at lines starting with this prefix; empty = every line
+    bool header{false};         // repeat the first line in every shard (and keep it once when concatenating)
+    int maxShards{0};           // 0 = global concurrency limit
+    qint64 minShardBytes{8 * 1024 * 1024};
+    QString mergeEntry;         // merge step run in the parent run dir; empty = concatenate outputs
+    QStringList mergeArgs;      // templated like runtime.args, plus {{shard.outputs}}
+    QSharedPointer<const ArgTemplate> mergeArgTemplate; // mergeArgs compiled by ToolManifest
+
+    bool enabled() const { return !param.isEmpty(); }
+};
+
+// limits: per-run resource caps; 0 = unlimited. Applied as rlimits on Unix,
+// or through a transient systemd scope (cgroup v2) when cgroup is set.
+struct LimitsDTO
+{
+    int cpuSeconds{0};     // limits.cpu: CPU time
+    double cpuCores{0};    // limits.cpu_cores: CPU quota, cgroup only
+    qint64 memoryBytes{0}; // limits.memory: "512M", "2G"; a bare number is MB
+    int openFiles{0};      // limits.nofile
+    int processes{0};      // limits.nproc
+    bool cgroup{false};    // limits.cgroup
+
+    bool any() const { return cpuSeconds > 0 || cpuCores > 0 || memoryBytes > 0 || openFiles > 0 || processes > 0; }
+};
+
+// runtime.warm: run in a pre-started interpreter that has already imported
+// the heavy modules (see WarmPool). `warm: true` enables it without preload.
+struct WarmConfigDTO
+{
+    bool enabled{false};
+    QStringList preload; // Python modules / R packages
+    int size{1};         // interpreters kept ready per environment
+};
+
+// runtime.mode: server: started once and kept alive, every run is a request
+// on its stdin (see ToolServer).
+struct ServerConfigDTO
+{
+    bool enabled{false};
+    int idleTimeoutSeconds{300};   // runtime.server.idle_timeout; 0 = keep running
+    int healthIntervalSeconds{30}; // runtime.server.health_interval; 0 = no pings
+    int startTimeoutSeconds{120};  // runtime.server.start_timeout: until it reports ready
+};
+
 struct RuntimeConfigDTO
 {
     QString type;          // "python" | "r" | "generic"
     QString entry;         // script or executable
     QStringList args;      // templated args
+    QSharedPointer<const ArgTemplate> argTemplate; // args compiled by ToolManifest; null = compiled on use
     bool shellWrap{false}; // whether to wrap with shell
     QString workdir{"."};  // relative to tool root
     QMap<QString, QString> extraEnv;
     int timeoutSeconds{0}; // 0 = unlimited
+    LimitsDTO limits;
+    bool cache{false};     // reuse the result of an identical earlier run (see RunCache)
+    WarmConfigDTO warm;
+    ServerConfigDTO server;
     QList<ExpectedOutputDTO> expectedOutputs;
+    ShardConfigDTO shard;
 };
 
 struct EnvConfigDTO
@@ -88,8 +147,15 @@ struct ToolDTO
     RuntimeConfigDTO runtime;
     EnvConfigDTO env;
     QList<ParamDTO> params;
+    QString toolDir;   // directory holding tool.yaml
+    QString toolsRoot; // root the tool was discovered under; runs/ lives here
+    bool detailsLoaded{false}; // false = header only (scan); runtime/env/params need a full decode
 };
 
+// A scanned tool is never modified in place; past the parser everything holds
+// this shared handle, so passing a tool around costs one reference count.
+using ToolHandle = QSharedPointer<const ToolDTO>;
+
 struct RunParamValueDTO
 {
     QString key;
@@ -103,11 +169,98 @@ struct RunRequestDTO
     QList<RunParamValueDTO> params;
     QString runDirectory; // optional override
     QString interpreterOverride; // optional override for interpreter/executable
+    int priority{0};             // higher starts first when runs are queued
+    QStringList shardOutputs;    // shard output dirs handed to a merge step ({{shard.outputs}})
+};
+
+// One swept parameter; every value becomes its own run.
+struct SweepAxisDTO
+{
+    QString key;
+    QStringList values;
+};
+
+struct BatchRequestDTO
+{
+    RunRequestDTO base;                  // values for everything that is not swept
+    QList<SweepAxisDTO> axes;            // expanded as a cartesian product
+    QList<QList<RunParamValueDTO>> rows; // explicit parameter rows (CSV); replaces axes when set
+    int maxConcurrent{0};                // runs of this batch in flight at once; 0 = global limit
+};
+
+struct BatchRunResultDTO
+{
+    QString runId;
+    QList<RunParamValueDTO> params; // the swept values only
+    QString runDirectory;
+    QString status; // succeeded | failed | cancelled
+    int exitCode{-1};
+    QString message;
+    qint64 durationMs{0};
+};
+
+struct BatchSummaryDTO
+{
+    QString batchId;
+    QString toolId;
+    int total{0};
+    int succeeded{0};
+    int failed{0};
+    int cancelled{0};
+    qint64 wallMs{0};
+    QString summaryPath; // JSON copy of this summary under runs/
+    QList<BatchRunResultDTO> runs;
+};
+
+// Resource use of one run, child processes included. CPU, memory, context
+// switch and I/O figures come from sampling /proc on Linux (sampled == true);
+// elsewhere only wallMs is known.
+struct RunMetricsDTO
+{
+    qint64 wallMs{0};
+    qint64 userCpuMs{0};
+    qint64 systemCpuMs{0};
+    qint64 peakRssBytes{0};
+    qint64 voluntaryCtxSwitches{0};
+    qint64 involuntaryCtxSwitches{0};
+    qint64 readBytes{0};  // storage I/O, as /proc/<pid>/io read_bytes
+    qint64 writeBytes{0};
+    int processes{0};     // distinct processes observed
+    bool sampled{false};
+};
+
+// What a run reported through the progress side channel (see RunProgress),
+// folded into its latest state.
+struct RunProgressDTO
+{
+    double fraction{-1.0}; // 0..1; < 0 = unknown
+    qint64 done{-1};       // items processed; < 0 = not reported
+    qint64 total{-1};
+    QString stage;
+    QString message;
+    QMap<QString, double> counters;
+    QList<QPair<QString, qint64>> stages; // stage markers with ms since start
+};
+
+struct ScanOptionsDTO
+{
+    QStringList roots;
+    int maxDepth{1};            // levels below each root searched for tool.yaml; 1 = direct children
+    QStringList ignorePatterns; // wildcards matched against folder names, or root-relative paths when containing '/'
+};
+
+struct LogOptionsDTO
+{
+    qint64 maxBytes{50LL * 1024 * 1024}; // per log file; <= 0 disables the cap
+    qint64 bufferBytes{1024 * 1024};     // buffered per file before a write is forced
+    int flushIntervalMs{250};            // buffered output older than this is written out
+    bool rotate{false};                  // at the cap: rotate to .1, .2, ... instead of truncating
+    int keepRotated{2};
 };
 
 struct ScanResultDTO
 {
-    QList<ToolDTO> tools;
+    QList<ToolHandle> tools;
     QString error;
 
     bool ok() const { return error.isEmpty(); }
@@ -132,6 +285,12 @@ Q_DECLARE_METATYPE(RuntimeConfigDTO)
 Q_DECLARE_METATYPE(ExpectedOutputDTO)
 Q_DECLARE_METATYPE(SetupCommandDTO)
 Q_DECLARE_METATYPE(ToolDTO)
+Q_DECLARE_METATYPE(ToolHandle)
 Q_DECLARE_METATYPE(RunParamValueDTO)
 Q_DECLARE_METATYPE(RunRequestDTO)
+Q_DECLARE_METATYPE(BatchRequestDTO)
+Q_DECLARE_METATYPE(BatchSummaryDTO)
+Q_DECLARE_METATYPE(RunMetricsDTO)
+Q_DECLARE_METATYPE(RunProgressDTO)
+Q_DECLARE_METATYPE(ScanOptionsDTO)
 Q_DECLARE_METATYPE(ScanResultDTO)
@@ -0,0 +1,85 @@
+#include "AppSettings.h"
+
+#include "core/CoreService.h"
+#include "core/JobScheduler.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSettings>
+
+QString AppSettings::defaultToolsRoot()
+{
+    QDir exeDir(QCoreApplication::applicationDirPath());
+    QStringList candidates;
+    candidates << QDir(exeDir).filePath(QStringLiteral("tools"));
+    QDir parentDir(exeDir);
+    parentDir.cdUp();
+    candidates << parentDir.filePath(QStringLiteral("tools"));
+
+    for (const QString &c : candidates)
+    {
+        if (QDir(c).exists())
+        {
+            return c;
+        }
+    }
+    return candidates.value(0);
+}
+
+void AppSettings::apply(const QSettings &settings, const QString &toolsRoot, CoreService &core)
+{
+    // Defaults to one concurrent run per core; 0 or unset keeps the default.
+    if (const int maxJobs = settings.value(QStringLiteral("jobs/maxConcurrent"), 0).toInt(); maxJobs > 0)
+    {
+        core.setMaxConcurrentJobs(maxJobs);
+    }
+    // "fifo" disables duration-based ordering; explicit priorities still apply.
+    core.setSchedulingPolicy(JobScheduler::policyFromString(settings.value(QStringLiteral("jobs/scheduling")).toString()));
+    if (const int budgetMb = settings.value(QStringLiteral("jobs/outputBudgetMb"), 0).toInt(); budgetMb > 0)
+    {
+        core.setOutputBudget(qint64(budgetMb) * 1024 * 1024);
+    }
+    LogOptionsDTO logOptions;
+    if (settings.contains(QStringLiteral("logs/maxSizeMb")))
+    {
+        logOptions.maxBytes = settings.value(QStringLiteral("logs/maxSizeMb")).toLongLong() * 1024 * 1024;
+    }
+    logOptions.flushIntervalMs = settings.value(QStringLiteral("logs/flushIntervalMs"), logOptions.flushIntervalMs).toInt();
+    logOptions.rotate = settings.value(QStringLiteral("logs/overflow")).toString() == QStringLiteral("rotate");
+    core.setLogOptions(logOptions);
+    if (settings.contains(QStringLiteral("cache/maxSizeMb")))
+    {
+        core.setResultCacheLimit(settings.value(QStringLiteral("cache/maxSizeMb")).toLongLong() * 1024 * 1024);
+    }
+
+    core.setToolLibraryDir(QDir(toolsRoot).filePath(QStringLiteral("_lib")));
+    // extras/paths/<name>=<program> backs {{config.bin.<name>}} in tool.yaml.
+    QMap<QString, QString> binaryPaths;
+    const QString prefix = QStringLiteral("extras/paths/");
+    for (const QString &key : settings.allKeys())
+    {
+        if (key.startsWith(prefix))
+        {
+            binaryPaths.insert(key.mid(prefix.size()), settings.value(key).toString());
+        }
+    }
+    core.setBinaryPaths(binaryPaths);
+}
+
+ScanOptionsDTO AppSettings::scanOptions(const QSettings &settings, const QString &toolsRoot)
+{
+    // Additional roots (e.g. a shared network folder) and the discovery depth
+    // come from the settings file; the bundled tools/ folder always comes first.
+    ScanOptionsDTO scanOptions;
+    scanOptions.roots << toolsRoot;
+    for (const QString &root : settings.value(QStringLiteral("scan/extraRoots")).toStringList())
+    {
+        if (!root.trimmed().isEmpty() && !scanOptions.roots.contains(root.trimmed()))
+        {
+            scanOptions.roots << root.trimmed();
+        }
+    }
+    scanOptions.maxDepth = qMax(1, settings.value(QStringLiteral("scan/maxDepth"), 1).toInt());
+    scanOptions.ignorePatterns = settings.value(QStringLiteral("scan/ignore")).toStringList();
+    return scanOptions;
+}
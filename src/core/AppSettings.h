@@ -0,0 +1,22 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QString>
+
+class CoreService;
+class QSettings;
+
+// Settings shared by the GUI and the command-line runner; both read the
+// same QSettings (organisation and application "ScriptToolbox").
+class AppSettings
+{
+public:
+    // tools/ next to the executable, else next to its parent directory.
+    static QString defaultToolsRoot();
+    // jobs/*, logs/*, cache/maxSizeMb and extras/paths/*, plus tools/_lib
+    // of toolsRoot as TOOLBOX_LIB. Call before the first run.
+    static void apply(const QSettings &settings, const QString &toolsRoot, CoreService &core);
+    // toolsRoot followed by scan/extraRoots; scan/maxDepth, scan/ignore.
+    static ScanOptionsDTO scanOptions(const QSettings &settings, const QString &toolsRoot);
+};
@@ -0,0 +1,256 @@
+#include "ArgTemplate.h"
+
+#include <utility>
+
+namespace
+{
+bool isNameChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_') || c == QLatin1Char('-');
+}
+
+bool isName(QStringView name)
+{
+    if (name.isEmpty())
+    {
+        return false;
+    }
+    for (const QChar c : name)
+    {
+        if (!isNameChar(c))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+ArgTemplate ArgTemplate::compile(const QStringList &templates, const QString &field, const QStringList &paramKeys, bool shardOutputs, QStringList &errors)
+{
+    return compileWith(templates, field, &paramKeys, shardOutputs, errors);
+}
+
+QStringList ArgTemplate::check(const QStringList &templates, const QString &field, bool shardOutputs)
+{
+    QStringList errors;
+    compileWith(templates, field, nullptr, shardOutputs, errors);
+    return errors;
+}
+
+ArgTemplate ArgTemplate::compileWith(const QStringList &templates, const QString &field, const QStringList *paramKeys, bool shardOutputs, QStringList &errors)
+{
+    ArgTemplate compiled;
+    compiled.m_args.reserve(templates.size());
+    for (qsizetype index = 0; index < templates.size(); ++index)
+    {
+        const QString &tpl = templates.at(index);
+        Arg arg;
+        QString literal;
+        const auto flushLiteral = [&arg, &literal]()
+        {
+            if (!literal.isEmpty())
+            {
+                arg.pieces.append({Source::Literal, std::exchange(literal, QString()), false, QString()});
+            }
+        };
+
+        qsizetype pos = 0;
+        while (pos < tpl.size())
+        {
+            const qsizetype open = tpl.indexOf(QStringLiteral("{{"), pos);
+            const qsizetype close = open < 0 ? -1 : tpl.indexOf(QStringLiteral("}}"), open + 2);
+            if (close < 0)
+            {
+                literal += QStringView(tpl).sliced(pos);
+                break;
+            }
+            literal += QStringView(tpl).sliced(pos, open - pos);
+            Piece piece;
+            QString problem;
+            if (parsePlaceholder(QStringView(tpl).sliced(open + 2, close - open - 2), shardOutputs, paramKeys, piece, problem))
+            {
+                flushLiteral();
+                arg.pieces.append(piece);
+            }
+            else
+            {
+                literal += QStringView(tpl).sliced(open, close + 2 - open);
+            }
+            if (!problem.isEmpty())
+            {
+                errors << QStringLiteral("%1[%2] \"%3\": %4").arg(field).arg(index).arg(tpl, problem);
+            }
+            pos = close + 2;
+        }
+        flushLiteral();
+
+        if (arg.pieces.size() == 1)
+        {
+            const Piece &only = arg.pieces.constFirst();
+            arg.spread = !only.join && (only.source == Source::Param || only.source == Source::ShardOutputs);
+        }
+        compiled.m_args.append(arg);
+    }
+    return compiled;
+}
+
+bool ArgTemplate::parsePlaceholder(QStringView expression, bool shardOutputs, const QStringList *paramKeys, Piece &piece, QString &problem)
+{
+    QStringView name = expression;
+    const qsizetype bar = expression.indexOf(QLatin1Char('|'));
+    if (bar >= 0)
+    {
+        name = expression.first(bar);
+        QStringView filter = expression.sliced(bar + 1);
+        while (!filter.isEmpty() && filter.front().isSpace())
+        {
+            filter = filter.sliced(1);
+        }
+        if (filter.trimmed() == QStringLiteral("join"))
+        {
+            piece.join = true;
+            piece.separator = QStringLiteral(",");
+        }
+        else if (filter.startsWith(QStringLiteral("join:")))
+        {
+            piece.join = true;
+            piece.separator = filter.sliced(5).toString();
+        }
+        else
+        {
+            problem = QStringLiteral("unknown filter \"%1\"").arg(filter.trimmed());
+            return false;
+        }
+    }
+    name = name.trimmed();
+
+    if (name == QStringLiteral("run.outputs") || name == QStringLiteral("output.dir"))
+    {
+        piece.source = Source::RunOutputs;
+    }
+    else if (name == QStringLiteral("run.dir"))
+    {
+        piece.source = Source::RunDir;
+    }
+    else if (name == QStringLiteral("tool.root"))
+    {
+        piece.source = Source::ToolRoot;
+    }
+    else if (name == QStringLiteral("runtime.workdir"))
+    {
+        piece.source = Source::Workdir;
+    }
+    else if (name == QStringLiteral("shard.outputs"))
+    {
+        if (!shardOutputs)
+        {
+            problem = QStringLiteral("{{shard.outputs}} is only available to runtime.shard.merge.args");
+            return false;
+        }
+        piece.source = Source::ShardOutputs;
+    }
+    else if (name.startsWith(QStringLiteral("params.")) && isName(name.sliced(7)))
+    {
+        piece.source = Source::Param;
+        piece.text = name.sliced(7).toString();
+        if (paramKeys && !paramKeys->contains(piece.text))
+        {
+            problem = QStringLiteral("no parameter \"%1\" is declared; it expands to nothing").arg(piece.text);
+        }
+    }
+    else if (name.startsWith(QStringLiteral("config.bin.")) && isName(name.sliced(11)))
+    {
+        piece.source = Source::ConfigBin;
+        piece.text = name.sliced(11).toString();
+    }
+    else
+    {
+        problem = QStringLiteral("unknown placeholder {{%1}}").arg(name);
+        return false;
+    }
+
+    if (piece.join && piece.source != Source::Param && piece.source != Source::ShardOutputs)
+    {
+        problem = QStringLiteral("join only applies to params.* and shard.outputs");
+        piece.join = false;
+    }
+    return true;
+}
+
+QStringList ArgTemplate::valuesOf(const Piece &piece, const Context &context)
+{
+    if (piece.source == Source::ShardOutputs)
+    {
+        return context.shardOutputs;
+    }
+    const auto it = context.params.constFind(piece.text);
+    return it == context.params.cend() ? QStringList() : it.value();
+}
+
+QStringList ArgTemplate::expand(const Context &context) const
+{
+    QStringList args;
+    args.reserve(m_args.size());
+    for (const Arg &arg : m_args)
+    {
+        if (arg.spread)
+        {
+            const Piece &piece = arg.pieces.constFirst();
+            const QStringList values = valuesOf(piece, context);
+            // An unset param still takes its argument slot; no shard outputs
+            // means no arguments.
+            if (values.isEmpty() && piece.source == Source::Param)
+            {
+                args << QString();
+            }
+            else
+            {
+                args << values;
+            }
+            continue;
+        }
+
+        QString value;
+        for (const Piece &piece : arg.pieces)
+        {
+            switch (piece.source)
+            {
+            case Source::Literal:
+                value += piece.text;
+                break;
+            case Source::RunOutputs:
+                value += context.outputDir;
+                break;
+            case Source::RunDir:
+                value += context.runDir;
+                break;
+            case Source::ToolRoot:
+                value += context.toolDir;
+                break;
+            case Source::Workdir:
+                value += context.workdir;
+                break;
+            case Source::ConfigBin:
+                value += context.bins.value(piece.text, piece.text);
+                break;
+            case Source::Param:
+            case Source::ShardOutputs:
+            {
+                const QStringList values = valuesOf(piece, context);
+                if (piece.join)
+                {
+                    value += values.join(piece.separator);
+                }
+                else if (!values.isEmpty())
+                {
+                    value += values.constFirst();
+                }
+                break;
+            }
+            }
+        }
+        args << value;
+    }
+    return args;
+}
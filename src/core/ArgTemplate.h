@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// Compiled runtime.args (and runtime.shard.merge.args). Every template
+// argument is parsed once, when the manifest is decoded, into a list of
+// literal and placeholder pieces; expanding it for a run is then one pass
+// with no parsing. Placeholders:
+//
+//   {{run.outputs}} (alias {{output.dir}})  {{run.dir}}  {{tool.root}}
+//   {{runtime.workdir}}  {{params.<key>}}  {{config.bin.<name>}}
+//   {{shard.outputs}}  (merge args only)
+//
+// An argument that is exactly {{params.<key>}} or {{shard.outputs}} becomes
+// one argument per value. Inside a larger argument these give their first
+// value, unless joined: {{params.<key>|join:<sep>}} joins all values with
+// <sep>, taken verbatim up to the closing braces ("|join" alone uses ",").
+// {{config.bin.<name>}} is the path configured for <name>, or <name> itself
+// so that the program is looked up on PATH.
+class ArgTemplate
+{
+public:
+    struct Context
+    {
+        QMap<QString, QStringList> params;
+        QString runDir;
+        QString outputDir;
+        QString toolDir;
+        QString workdir;
+        QStringList shardOutputs;
+        QMap<QString, QString> bins; // config.bin.<name> -> path
+    };
+
+    // field names the templates in errors ("runtime.args"). Unknown
+    // placeholders are reported in errors and kept as literal text; unknown
+    // parameter keys are reported too and expand to nothing.
+    static ArgTemplate compile(const QStringList &templates, const QString &field, const QStringList &paramKeys, bool shardOutputs, QStringList &errors);
+    // Placeholder check for the scan, which has no params: reports what
+    // compile would, except parameter keys that are not declared.
+    static QStringList check(const QStringList &templates, const QString &field, bool shardOutputs);
+
+    QStringList expand(const Context &context) const;
+    bool isEmpty() const { return m_args.isEmpty(); }
+
+private:
+    enum class Source
+    {
+        Literal,
+        RunOutputs,
+        RunDir,
+        ToolRoot,
+        Workdir,
+        Param,
+        ConfigBin,
+        ShardOutputs
+    };
+
+    struct Piece
+    {
+        Source source{Source::Literal};
+        QString text; // literal text, param key or bin name
+        bool join{false};
+        QString separator;
+    };
+
+    struct Arg
+    {
+        QList<Piece> pieces;
+        bool spread{false}; // a lone multi-valued placeholder: one argument per value
+    };
+
+    // A null paramKeys skips the declared-parameter check.
+    static ArgTemplate compileWith(const QStringList &templates, const QString &field, const QStringList *paramKeys, bool shardOutputs, QStringList &errors);
+    static bool parsePlaceholder(QStringView expression, bool shardOutputs, const QStringList *paramKeys, Piece &piece, QString &problem);
+    static QStringList valuesOf(const Piece &piece, const Context &context);
+
+    QList<Arg> m_args;
+};
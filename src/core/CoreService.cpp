@@ -4,15 +4,76 @@
 #include "core/workers/ScanWorker.h"
 #include "core/workers/EnvWorker.h"
 #include "core/workers/SelfTestWorker.h"
+#include "core/workers/LogWriter.h"
 #include "core/LoggingBridge.h"
+#include "core/OutputFramer.h"
+#include "core/ParamSweep.h"
+#include "core/RunMetadata.h"
+#include "core/ShardPlanner.h"
 
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
 #include <QMetaObject>
 #include <QMetaType>
 #include <QThread>
 #include <QLoggingCategory>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
 
 Q_LOGGING_CATEGORY(logCore, "core.service")
 
+namespace
+{
+// Writes runs/batch_<timestamp>_<toolId>_<seq>.json next to the run
+// directories and returns its path (empty on failure).
+QString writeBatchSummary(const QString &toolsRoot, const QDateTime &startedAt, const BatchSummaryDTO &summary)
+{
+    const QDir runsDir(QDir(toolsRoot).filePath(QStringLiteral("runs")));
+    if (!runsDir.mkpath(QStringLiteral(".")))
+    {
+        return QString();
+    }
+    const QString stem = QStringLiteral("batch_%1_%2").arg(startedAt.toString(QStringLiteral("yyyy-MM-dd_hh-mm-ss")), summary.toolId);
+    QString path;
+    for (int seq = 1; path.isEmpty() || QFileInfo::exists(path); ++seq)
+    {
+        path = runsDir.filePath(QStringLiteral("%1_%2.json").arg(stem).arg(seq));
+    }
+
+    QJsonArray runs;
+    for (const BatchRunResultDTO &run : summary.runs)
+    {
+        runs.append(RunMetadata::batchRunToJson(run));
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("batchId"), summary.batchId);
+    root.insert(QStringLiteral("toolId"), summary.toolId);
+    root.insert(QStringLiteral("startedAt"), startedAt.toString(Qt::ISODate));
+    root.insert(QStringLiteral("total"), summary.total);
+    root.insert(QStringLiteral("succeeded"), summary.succeeded);
+    root.insert(QStringLiteral("failed"), summary.failed);
+    root.insert(QStringLiteral("cancelled"), summary.cancelled);
+    root.insert(QStringLiteral("wallMs"), summary.wallMs);
+    root.insert(QStringLiteral("runs"), runs);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning(logCore) << "Cannot write batch summary" << path << file.errorString();
+        return QString();
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return file.commit() ? path : QString();
+}
+} // namespace
+
 CoreService::CoreService(QObject *parent)
     : QObject(parent)
 {
@@ -23,8 +84,24 @@ CoreService::CoreService(QObject *parent)
 
     qRegisterMetaType<ScanResultDTO>("ScanResultDTO");
     qRegisterMetaType<ToolDTO>("ToolDTO");
+    qRegisterMetaType<ToolHandle>("ToolHandle");
+    qRegisterMetaType<QList<ToolHandle>>("QList<ToolHandle>");
+    qRegisterMetaType<ToolCatalog>("ToolCatalog");
+    qRegisterMetaType<ScanOptionsDTO>("ScanOptionsDTO");
     qRegisterMetaType<RunRequestDTO>("RunRequestDTO");
     qRegisterMetaType<RunParamValueDTO>("RunParamValueDTO");
+    qRegisterMetaType<BatchRequestDTO>("BatchRequestDTO");
+    qRegisterMetaType<BatchSummaryDTO>("BatchSummaryDTO");
+    qRegisterMetaType<RunMetricsDTO>("RunMetricsDTO");
+    qRegisterMetaType<RunProgressDTO>("RunProgressDTO");
+
+    m_maxConcurrentJobs = qMax(1, QThread::idealThreadCount());
+
+    m_runHistory.load();
+    m_historySaveTimer.setSingleShot(true);
+    m_historySaveTimer.setInterval(2000);
+    connect(&m_historySaveTimer, &QTimer::timeout, this, [this]()
+            { m_runHistory.save(); });
 
     LoggingBridge::instance();
 }
@@ -57,15 +134,32 @@ void CoreService::shutdown()
 
     if (m_jobThread.isRunning())
     {
+        m_pendingJobs.clear();
+        m_scheduler.clear();
+        QMetaObject::invokeMethod(m_jobWorker, "cancelAll", Qt::BlockingQueuedConnection);
         m_jobThread.quit();
         m_jobThread.wait();
     }
 
+    // After the job thread: every write it queued is delivered before this.
+    if (m_logThread.isRunning())
+    {
+        QMetaObject::invokeMethod(m_logWriter, "closeAll", Qt::BlockingQueuedConnection);
+        m_logThread.quit();
+        m_logThread.wait();
+    }
+
     if (m_envThread.isRunning())
     {
         m_envThread.quit();
         m_envThread.wait();
     }
+
+    if (m_runHistory.isDirty())
+    {
+        m_historySaveTimer.stop();
+        m_runHistory.save();
+    }
 }
 
 void CoreService::runSchedulingSelfTest(int taskCount)
@@ -88,42 +182,679 @@ void CoreService::runSchedulingSelfTest(int taskCount)
 }
 
 void CoreService::startScan(const QString &toolsRoot)
+{
+    ScanOptionsDTO options;
+    options.roots << toolsRoot;
+    startScan(options);
+}
+
+void CoreService::startScan(const ScanOptionsDTO &options)
 {
     ensureScanWorkerReady();
-    qInfo(logCore) << "Start scan" << toolsRoot;
-    QMetaObject::invokeMethod(m_scanWorker, "scan", Qt::QueuedConnection, Q_ARG(QString, toolsRoot));
+    qInfo(logCore) << "Start scan" << options.roots;
+    QMetaObject::invokeMethod(m_scanWorker, "scan", Qt::QueuedConnection, Q_ARG(ScanOptionsDTO, options));
 }
 
-void CoreService::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunRequestDTO &request)
+void CoreService::startStreamingScan(const QString &toolsRoot)
+{
+    ScanOptionsDTO options;
+    options.roots << toolsRoot;
+    startStreamingScan(options);
+}
+
+void CoreService::startStreamingScan(const ScanOptionsDTO &options)
+{
+    ensureScanWorkerReady();
+    m_catalogResetPending = true;
+    qInfo(logCore) << "Start streaming scan" << options.roots;
+    QMetaObject::invokeMethod(m_scanWorker, "scanStreaming", Qt::QueuedConnection, Q_ARG(ScanOptionsDTO, options));
+}
+
+void CoreService::setParallelScan(bool enabled)
+{
+    ensureScanWorkerReady();
+    QMetaObject::invokeMethod(m_scanWorker, "setParallel", Qt::QueuedConnection, Q_ARG(bool, enabled));
+}
+
+void CoreService::startWatching(const QString &toolsRoot)
+{
+    ScanOptionsDTO options;
+    options.roots << toolsRoot;
+    startWatching(options);
+}
+
+void CoreService::startWatching(const ScanOptionsDTO &options)
+{
+    ensureScanWorkerReady();
+    qInfo(logCore) << "Watch tools" << options.roots;
+    QMetaObject::invokeMethod(m_scanWorker, "startWatching", Qt::QueuedConnection, Q_ARG(ScanOptionsDTO, options));
+}
+
+void CoreService::stopWatching()
+{
+    if (!m_scanWorker)
+    {
+        return;
+    }
+    QMetaObject::invokeMethod(m_scanWorker, "stopWatching", Qt::QueuedConnection);
+}
+
+ToolHandle CoreService::loadToolDetails(const QString &toolsRoot, const ToolHandle &tool, QString &error)
+{
+    if (!tool)
+    {
+        return tool;
+    }
+    // Tools found by a scan know their own location; the root argument only
+    // covers DTOs built elsewhere (flat layout: <root>/<id>).
+    if (tool->toolDir.isEmpty() || tool->toolsRoot.isEmpty())
+    {
+        ToolDTO located = *tool;
+        if (located.toolsRoot.isEmpty())
+        {
+            located.toolsRoot = toolsRoot;
+        }
+        if (located.toolDir.isEmpty())
+        {
+            located.toolDir = QDir(located.toolsRoot).filePath(located.id);
+        }
+        return m_manifests.resolve(ToolHandle::create(std::move(located)), error);
+    }
+    return m_manifests.resolve(tool, error);
+}
+
+QString CoreService::runJob(const QString &toolsRoot, const ToolHandle &header, const RunRequestDTO &request)
 {
     ensureJobWorkerReady();
-    qInfo(logCore) << "Run job directly" << tool.id;
-    QMetaObject::invokeMethod(
-        m_jobWorker,
-        "runJob",
-        Qt::QueuedConnection,
-        Q_ARG(QString, toolsRoot),
-        Q_ARG(ToolDTO, tool),
-        Q_ARG(RunRequestDTO, request),
-        Q_ARG(QString, QString()));
+    QString error;
+    const ToolHandle tool = loadToolDetails(toolsRoot, header, error);
+    if (!tool)
+    {
+        return QString();
+    }
+    if (!error.isEmpty())
+    {
+        qWarning(logCore) << error;
+    }
+    qInfo(logCore) << "Run job directly" << tool->id;
+    return submitRun(tool, request, false);
 }
 
-void CoreService::runTool(const QString &toolsRoot, const ToolDTO &tool, const RunRequestDTO &request)
+QString CoreService::runTool(const QString &toolsRoot, const ToolHandle &header, const RunRequestDTO &request)
 {
     ensureEnvWorkerReady();
     ensureJobWorkerReady();
 
-    PendingJob pending{toolsRoot, tool, request};
-    m_pendingJobs.insert(tool.id, pending);
+    QString error;
+    const ToolHandle tool = loadToolDetails(toolsRoot, header, error);
+    if (!tool)
+    {
+        return QString();
+    }
+    if (!error.isEmpty())
+    {
+        qWarning(logCore) << error;
+    }
+    if (tool->runtime.shard.enabled())
+    {
+        const ShardConfigDTO &shard = tool->runtime.shard;
+        QString input;
+        for (const RunParamValueDTO &param : request.params)
+        {
+            if (param.key == shard.param && !param.values.isEmpty())
+            {
+                input = param.values.first();
+            }
+        }
+        // Inputs too small for two shards run as a plain job.
+        if (!input.isEmpty() && QFileInfo(input).size() >= 2 * shard.minShardBytes)
+        {
+            return startShardedRun(tool, request, input);
+        }
+    }
+    qInfo(logCore) << "Prepare env then run" << tool->id;
+    return submitRun(tool, request, true);
+}
 
-    emit envPreparing(tool.id);
-    qInfo(logCore) << "Prepare env then run" << tool.id;
+void CoreService::cancelRun(const QString &runId)
+{
+    if (const auto sharded = m_shardedRuns.find(runId); sharded != m_shardedRuns.end())
+    {
+        // While splitting or concatenating there is nothing to stop; the
+        // completion handlers see the flag and end the run as cancelled.
+        sharded->cancelled = true;
+        const QString batchId = sharded->batchId;
+        const QString mergeRunId = sharded->mergeRunId;
+        if (!batchId.isEmpty() && m_batches.contains(batchId))
+        {
+            cancelBatch(batchId);
+        }
+        else if (!mergeRunId.isEmpty())
+        {
+            cancelRun(mergeRunId);
+        }
+        return;
+    }
+    if (m_activeRuns.contains(runId))
+    {
+        QMetaObject::invokeMethod(m_jobWorker, "cancel", Qt::QueuedConnection, Q_ARG(QString, runId));
+        return;
+    }
+    if (!m_pendingJobs.contains(runId))
+    {
+        return;
+    }
+    const PendingJob pending = m_pendingJobs.take(runId);
+    m_scheduler.remove(runId);
+    qInfo(logCore) << "Cancelled queued run" << runId;
+    const QString message = QStringLiteral("Cancelled before start");
+    emit jobFinished(runId, pending.tool->id, -1, message);
+    recordBatchRun(runId, -1, message, 0, QString());
+}
+
+QString CoreService::runBatch(const QString &toolsRoot, const ToolHandle &header, const BatchRequestDTO &request, QString &error)
+{
+    ensureEnvWorkerReady();
+    ensureJobWorkerReady();
+
+    const ToolHandle tool = loadToolDetails(toolsRoot, header, error);
+    if (!tool || !error.isEmpty())
+    {
+        return QString();
+    }
+    const qint64 count = ParamSweep::runCount(request);
+    if (count <= 0 || count > ParamSweep::kMaxRuns)
+    {
+        error = count <= 0 ? QStringLiteral("Batch has no runs")
+                           : QStringLiteral("Batch expands to more than %1 runs").arg(ParamSweep::kMaxRuns);
+        return QString();
+    }
+    return startBatch(tool, request, QString());
+}
+
+QString CoreService::startBatch(const ToolHandle &tool, const BatchRequestDTO &request, const QString &shardParent)
+{
+    const QString batchId = QStringLiteral("batch-%1").arg(++m_batchCounter);
+    Batch batch;
+    batch.tool = tool;
+    batch.request = request;
+    batch.shardParent = shardParent;
+    batch.runs = ParamSweep::expand(request);
+    batch.startedAt = QDateTime::currentDateTime();
+    batch.clock.start();
+    batch.summary.batchId = batchId;
+    batch.summary.toolId = tool->id;
+    batch.summary.total = batch.runs.size();
+    batch.summary.runs.reserve(batch.runs.size());
+    for (const auto &params : std::as_const(batch.runs))
+    {
+        BatchRunResultDTO result;
+        result.params = ParamSweep::sweptValues(request, params);
+        batch.summary.runs.append(result);
+    }
+    m_batches.insert(batchId, batch);
+
+    qInfo(logCore) << "Start batch" << batchId << tool->id << "runs" << batch.runs.size();
+    if (shardParent.isEmpty())
+    {
+        emit batchStarted(batchId, tool->id, batch.runs.size());
+    }
+    emit envPreparing(tool->id);
+    QMetaObject::invokeMethod(
+        m_envWorker,
+        "prepareEnv",
+        Qt::QueuedConnection,
+        Q_ARG(QString, tool->toolsRoot),
+        Q_ARG(ToolHandle, tool));
+    return batchId;
+}
+
+void CoreService::cancelBatch(const QString &batchId)
+{
+    const auto it = m_batches.find(batchId);
+    if (it == m_batches.end() || it->cancelled)
+    {
+        return;
+    }
+    it->cancelled = true;
+    // Runs never handed to the queue are settled here; the submitted ones are
+    // cancelled individually and report back through recordBatchRun().
+    for (int i = it->next; i < it->runs.size(); ++i)
+    {
+        it->summary.runs[i].status = QStringLiteral("cancelled");
+        it->summary.runs[i].message = QStringLiteral("Batch cancelled");
+        ++it->finished;
+    }
+    it->next = it->runs.size();
+
+    QStringList submitted;
+    for (auto run = m_batchRuns.cbegin(); run != m_batchRuns.cend(); ++run)
+    {
+        if (run->first == batchId)
+        {
+            submitted << run.key();
+        }
+    }
+    qInfo(logCore) << "Cancel batch" << batchId << "in flight" << submitted.size();
+    for (const QString &runId : std::as_const(submitted))
+    {
+        cancelRun(runId);
+    }
+
+    const auto remaining = m_batches.constFind(batchId);
+    if (remaining != m_batches.cend() && remaining->finished == remaining->summary.total)
+    {
+        finishBatch(batchId);
+    }
+}
+
+void CoreService::setMaxConcurrentJobs(int count)
+{
+    m_maxConcurrentJobs = qMax(1, count);
+    dispatchQueuedJobs();
+}
+
+void CoreService::setOutputBudget(qint64 bytes)
+{
+    m_outputBudget = bytes;
+    if (m_jobWorker && bytes > 0)
+    {
+        QMetaObject::invokeMethod(m_jobWorker, "setOutputBudget", Qt::QueuedConnection, Q_ARG(qint64, bytes));
+    }
+}
+
+void CoreService::setResultCacheLimit(qint64 bytes)
+{
+    m_resultCacheLimit = bytes;
+    if (m_jobWorker && bytes >= 0)
+    {
+        QMetaObject::invokeMethod(m_jobWorker, "setResultCacheLimit", Qt::QueuedConnection, Q_ARG(qint64, bytes));
+    }
+}
+
+QString CoreService::submitRun(const ToolHandle &tool, const RunRequestDTO &request, bool prepareEnv, const QString &envPath)
+{
+    const quint64 seq = ++m_runCounter;
+    const QString runId = QStringLiteral("run-%1").arg(seq);
+    PendingJob pending{tool->toolsRoot, tool, request, seq, envPath, !prepareEnv};
+    m_pendingJobs.insert(runId, pending);
+
+    if (!prepareEnv)
+    {
+        enqueueRun(runId);
+        return runId;
+    }
+
+    emit envPreparing(tool->id);
     QMetaObject::invokeMethod(
         m_envWorker,
         "prepareEnv",
         Qt::QueuedConnection,
-        Q_ARG(QString, toolsRoot),
-        Q_ARG(ToolDTO, tool));
+        Q_ARG(QString, tool->toolsRoot),
+        Q_ARG(ToolHandle, tool));
+    return runId;
+}
+
+void CoreService::enqueueRun(const QString &runId)
+{
+    const PendingJob &pending = m_pendingJobs[runId];
+    qint64 expectedMs = m_runHistory.estimate(pending.tool->id, pending.tool->version);
+    if (expectedMs < 0)
+    {
+        expectedMs = m_runHistory.typicalDuration();
+    }
+    m_scheduler.enqueue(runId, pending.request.priority, expectedMs);
+    const QString toolId = pending.tool->id;
+
+    dispatchQueuedJobs();
+    if (const int position = m_scheduler.position(runId); position > 0)
+    {
+        emit jobQueued(runId, toolId, position);
+    }
+}
+
+void CoreService::dispatchQueuedJobs()
+{
+    while (m_activeRuns.size() < m_maxConcurrentJobs && !m_scheduler.isEmpty())
+    {
+        const QString runId = m_scheduler.takeNext();
+        const PendingJob pending = m_pendingJobs.take(runId);
+        m_activeRuns.insert(runId, ActiveRun{pending.tool->id, pending.tool->version, {}});
+        QMetaObject::invokeMethod(
+            m_jobWorker,
+            "runJob",
+            Qt::QueuedConnection,
+            Q_ARG(QString, runId),
+            Q_ARG(QString, pending.toolsRoot),
+            Q_ARG(ToolHandle, pending.tool),
+            Q_ARG(RunRequestDTO, pending.request),
+            Q_ARG(QString, pending.envPath));
+    }
+}
+
+void CoreService::feedBatch(Batch &batch)
+{
+    if (!batch.envReady || batch.cancelled)
+    {
+        return;
+    }
+    // Keep only as many runs queued as could start anyway, so a sweep of
+    // thousands of runs never floods the scheduler.
+    const int limit = batch.request.maxConcurrent > 0 ? qMin(batch.request.maxConcurrent, m_maxConcurrentJobs) : m_maxConcurrentJobs;
+    const int width = QString::number(batch.runs.size()).size();
+    while (batch.inFlight < limit && batch.next < batch.runs.size())
+    {
+        const int index = batch.next++;
+        RunRequestDTO request = batch.request.base;
+        request.params = batch.runs.at(index);
+        if (!request.runDirectory.isEmpty())
+        {
+            request.runDirectory = QDir(request.runDirectory).filePath(QStringLiteral("%1").arg(index + 1, width, 10, QLatin1Char('0')));
+        }
+        ++batch.inFlight;
+        const QString runId = submitRun(batch.tool, request, false, batch.envPath);
+        batch.summary.runs[index].runId = runId;
+        m_batchRuns.insert(runId, {batch.summary.batchId, index});
+    }
+}
+
+void CoreService::recordBatchRun(const QString &runId, int exitCode, const QString &message, qint64 durationMs, const QString &runDirectory)
+{
+    const auto owner = m_batchRuns.constFind(runId);
+    if (owner == m_batchRuns.cend())
+    {
+        return;
+    }
+    const auto [batchId, index] = owner.value();
+    m_batchRuns.erase(owner);
+    const auto it = m_batches.find(batchId);
+    if (it == m_batches.end())
+    {
+        return;
+    }
+
+    BatchRunResultDTO &result = it->summary.runs[index];
+    result.exitCode = exitCode;
+    result.message = message;
+    result.durationMs = durationMs;
+    result.runDirectory = runDirectory;
+    result.status = exitCode == 0 ? QStringLiteral("succeeded") : (it->cancelled ? QStringLiteral("cancelled") : QStringLiteral("failed"));
+    --it->inFlight;
+    ++it->finished;
+    emit batchProgress(batchId, it->finished, it->summary.total);
+
+    if (it->finished == it->summary.total)
+    {
+        finishBatch(batchId);
+        return;
+    }
+    feedBatch(*it);
+}
+
+void CoreService::finishBatch(const QString &batchId)
+{
+    Batch batch = m_batches.take(batchId);
+    BatchSummaryDTO &summary = batch.summary;
+    summary.wallMs = batch.clock.elapsed();
+    for (BatchRunResultDTO &run : summary.runs)
+    {
+        if (run.status.isEmpty())
+        {
+            run.status = QStringLiteral("cancelled");
+        }
+        if (run.status == QStringLiteral("succeeded"))
+        {
+            ++summary.succeeded;
+        }
+        else if (run.status == QStringLiteral("cancelled"))
+        {
+            ++summary.cancelled;
+        }
+        else
+        {
+            ++summary.failed;
+        }
+    }
+    if (!batch.shardParent.isEmpty())
+    {
+        handleShardsFinished(batch.shardParent, summary, batch.envPath);
+        return;
+    }
+    summary.summaryPath = writeBatchSummary(batch.tool->toolsRoot, batch.startedAt, summary);
+    qInfo(logCore) << "Batch finished" << batchId << "ok" << summary.succeeded << "failed" << summary.failed
+                   << "cancelled" << summary.cancelled << "wall ms" << summary.wallMs;
+    emit batchFinished(summary);
+}
+
+QString CoreService::startShardedRun(const ToolHandle &tool, const RunRequestDTO &request, const QString &inputPath)
+{
+    QString runDir = request.runDirectory.isEmpty() ? JobWorker::createRunDirectory(tool->toolsRoot, tool->id)
+                                                    : QDir(request.runDirectory).absolutePath();
+    if (runDir.isEmpty() || !QDir(runDir).mkpath(QStringLiteral("outputs")) || !QDir(runDir).mkpath(QStringLiteral("logs")))
+    {
+        // Let the regular path report the failure.
+        return submitRun(tool, request, true);
+    }
+
+    const QString runId = QStringLiteral("run-%1").arg(++m_runCounter);
+    ShardedRun sharded;
+    sharded.tool = tool;
+    sharded.request = request;
+    sharded.runDirectory = runDir;
+    sharded.startedAt = QDateTime::currentDateTime();
+    sharded.clock.start();
+    m_shardedRuns.insert(runId, sharded);
+
+    const ShardConfigDTO config = tool->runtime.shard;
+    const int maxShards = config.maxShards > 0 ? config.maxShards : m_maxConcurrentJobs;
+    const QString shardDir = QDir(runDir).filePath(QStringLiteral("shards"));
+    qInfo(logCore) << "Sharded run" << runId << tool->id << "input" << inputPath << "max shards" << maxShards;
+
+    // The caller learns the run id from the return value; queue the start
+    // notification so it is not delivered before that.
+    const QString toolId = tool->id;
+    QMetaObject::invokeMethod(this, [this, runId, toolId, runDir]()
+                              { emit jobStarted(runId, toolId, runDir); }, Qt::QueuedConnection);
+
+    using SplitResult = QPair<QStringList, QString>;
+    auto *watcher = new QFutureWatcher<SplitResult>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, runId, shardDir]()
+            {
+        const auto [files, error] = watcher->result();
+        watcher->deleteLater();
+        const auto it = m_shardedRuns.find(runId);
+        if (it == m_shardedRuns.end())
+        {
+            return;
+        }
+        if (it->cancelled || !error.isEmpty())
+        {
+            finishShardedRun(runId, -1, it->cancelled ? QStringLiteral("Cancelled") : error);
+            return;
+        }
+
+        shardedRunOutput(runId, QStringLiteral("Split input into %1 shards").arg(files.size()));
+        BatchRequestDTO batch;
+        batch.base = it->request;
+        batch.base.runDirectory = shardDir;
+        batch.maxConcurrent = files.size();
+        for (const QString &file : files)
+        {
+            batch.rows.append({RunParamValueDTO{it->tool->runtime.shard.param, {file}}});
+        }
+        const ToolHandle tool = it->tool;
+        const QString batchId = startBatch(tool, batch, runId);
+        m_shardedRuns[runId].batchId = batchId; });
+    watcher->setFuture(QtConcurrent::run([inputPath, config, maxShards, shardDir]()
+                                         {
+        ShardPlanner::Plan plan;
+        QStringList files;
+        QString error;
+        if (ShardPlanner::plan(inputPath, config, maxShards, plan, error))
+        {
+            ShardPlanner::split(plan, QDir(shardDir).filePath(QStringLiteral("input")), files, error);
+        }
+        return SplitResult(files, error); }));
+    return runId;
+}
+
+void CoreService::handleShardsFinished(const QString &parentRunId, const BatchSummaryDTO &summary, const QString &envPath)
+{
+    const auto it = m_shardedRuns.find(parentRunId);
+    if (it == m_shardedRuns.end())
+    {
+        return;
+    }
+    it->batchId.clear();
+    it->shards = summary.runs;
+    for (int i = 0; i < summary.runs.size(); ++i)
+    {
+        const BatchRunResultDTO &run = summary.runs.at(i);
+        it->log << QStringLiteral("Shard %1: %2 in %3 ms (%4)").arg(i + 1).arg(run.status).arg(run.durationMs).arg(run.runDirectory);
+    }
+    if (it->cancelled || summary.succeeded != summary.total)
+    {
+        QString message = QStringLiteral("Cancelled");
+        for (int i = 0; !it->cancelled && i < summary.runs.size(); ++i)
+        {
+            if (summary.runs.at(i).status != QStringLiteral("succeeded"))
+            {
+                message = QStringLiteral("Shard %1 failed: %2").arg(i + 1).arg(summary.runs.at(i).message);
+                break;
+            }
+        }
+        finishShardedRun(parentRunId, -1, message);
+        return;
+    }
+
+    QStringList outputs;
+    for (const BatchRunResultDTO &run : summary.runs)
+    {
+        outputs << QDir(run.runDirectory).filePath(QStringLiteral("outputs"));
+    }
+    const ShardConfigDTO &config = it->tool->runtime.shard;
+
+    if (!config.mergeEntry.isEmpty())
+    {
+        // The merge step is the tool itself with a different entry point,
+        // run in the parent run directory so its logs and outputs land there.
+        ToolDTO merge = *it->tool;
+        merge.runtime.entry = config.mergeEntry;
+        merge.runtime.args = config.mergeArgs;
+        merge.runtime.argTemplate = config.mergeArgTemplate;
+        merge.runtime.shard = ShardConfigDTO{};
+        RunRequestDTO request = it->request;
+        request.runDirectory = it->runDirectory;
+        request.shardOutputs = outputs;
+        shardedRunOutput(parentRunId, QStringLiteral("Merging %1 shard outputs").arg(outputs.size()));
+        const QString mergeRunId = submitRun(ToolHandle::create(std::move(merge)), request, false, envPath);
+        ShardedRun &sharded = m_shardedRuns[parentRunId];
+        sharded.mergeRunId = mergeRunId;
+        sharded.merged = true;
+        return;
+    }
+
+    const QString outputDir = QDir(it->runDirectory).filePath(QStringLiteral("outputs"));
+    const bool skipHeader = config.header;
+    shardedRunOutput(parentRunId, QStringLiteral("Concatenating %1 shard outputs").arg(outputs.size()));
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, parentRunId, outputs]()
+            {
+        const QString error = watcher->result();
+        watcher->deleteLater();
+        const bool cancelled = m_shardedRuns.value(parentRunId).cancelled;
+        if (cancelled || !error.isEmpty())
+        {
+            finishShardedRun(parentRunId, -1, cancelled ? QStringLiteral("Cancelled") : error);
+            return;
+        }
+        finishShardedRun(parentRunId, 0, QStringLiteral("exit 0 (%1 shards)").arg(outputs.size())); });
+    watcher->setFuture(QtConcurrent::run([outputs, outputDir, skipHeader]()
+                                         {
+        QString error;
+        ShardPlanner::concatenate(outputs, outputDir, skipHeader, error);
+        return error; }));
+}
+
+void CoreService::finishShardedRun(const QString &parentRunId, int exitCode, const QString &message)
+{
+    const ShardedRun sharded = m_shardedRuns.take(parentRunId);
+    if (!sharded.tool)
+    {
+        return;
+    }
+    qInfo(logCore) << "Sharded run finished" << parentRunId << sharded.tool->id << "exit" << exitCode << message;
+
+    QJsonObject metadata;
+    if (sharded.merged)
+    {
+        // The merge step wrote its own metadata.json here; keep it nested.
+        QFile file(QDir(sharded.runDirectory).filePath(QStringLiteral("metadata.json")));
+        if (file.open(QIODevice::ReadOnly))
+        {
+            metadata.insert(QStringLiteral("merge"), QJsonDocument::fromJson(file.readAll()).object());
+        }
+    }
+    metadata.insert(QStringLiteral("runId"), parentRunId);
+    metadata.insert(QStringLiteral("toolId"), sharded.tool->id);
+    metadata.insert(QStringLiteral("version"), sharded.tool->version);
+    metadata.insert(QStringLiteral("params"), RunMetadata::paramsToJson(sharded.request.params));
+    metadata.insert(QStringLiteral("startedAt"), sharded.startedAt.toString(Qt::ISODateWithMs));
+    metadata.insert(QStringLiteral("finishedAt"), QDateTime::currentDateTime().toString(Qt::ISODateWithMs));
+    metadata.insert(QStringLiteral("durationMs"), sharded.clock.elapsed());
+    metadata.insert(QStringLiteral("exitCode"), exitCode);
+    metadata.insert(QStringLiteral("message"), message);
+    QJsonArray shards;
+    for (const BatchRunResultDTO &run : sharded.shards)
+    {
+        shards.append(RunMetadata::batchRunToJson(run));
+    }
+    metadata.insert(QStringLiteral("shards"), shards);
+    RunMetadata::writeMetadata(sharded.runDirectory, metadata);
+
+    QStringList log = sharded.log;
+    log << QStringLiteral("Finished with exit code %1: %2").arg(exitCode).arg(message);
+    RunMetadata::writeLog(sharded.runDirectory, QStringLiteral("shard.log"), log);
+
+    emit jobFinished(parentRunId, sharded.tool->id, exitCode, message);
+}
+
+void CoreService::shardedRunOutput(const QString &parentRunId, const QString &line)
+{
+    const auto it = m_shardedRuns.find(parentRunId);
+    if (it == m_shardedRuns.end())
+    {
+        return;
+    }
+    it->log << line;
+    emit jobOutput(parentRunId, it->tool->id, QStringList{line}, false);
+}
+
+QString CoreService::shardParentOf(const QString &runId, QString &label) const
+{
+    if (m_shardedRuns.isEmpty())
+    {
+        return QString();
+    }
+    if (const auto owner = m_batchRuns.constFind(runId); owner != m_batchRuns.cend())
+    {
+        const auto batch = m_batches.constFind(owner->first);
+        if (batch != m_batches.cend() && !batch->shardParent.isEmpty())
+        {
+            label = QStringLiteral("shard %1").arg(owner->second + 1);
+            return batch->shardParent;
+        }
+        return QString();
+    }
+    for (auto it = m_shardedRuns.cbegin(); it != m_shardedRuns.cend(); ++it)
+    {
+        if (it->mergeRunId == runId)
+        {
+            label = QStringLiteral("merge");
+            return it.key();
+        }
+    }
+    return QString();
 }
 
 void CoreService::handleWorkFinished(int id, const QString &payload, const QString &threadName)
@@ -140,49 +871,206 @@ void CoreService::handleWorkFinished(int id, const QString &payload, const QStri
     }
 }
 
+void CoreService::handleCatalogRestored(const ScanResultDTO &result)
+{
+    m_catalog.reset(result.tools);
+    emit catalogRestored(result);
+}
+
 void CoreService::handleScanFinished(const ScanResultDTO &result)
 {
+    // Manifest errors only concern their own tools; everything that parsed
+    // still replaces the previous catalog, as in the streaming path.
+    m_catalog.reset(result.tools);
+    if (!result.ok())
+    {
+        qWarning(logCore) << "Scan finished with errors:" << result.error;
+    }
     emit scanFinished(result);
 }
 
-void CoreService::handleJobStarted(const QString &toolId, const QString &runDirectory)
+void CoreService::handleScanBatchReady(const QList<ToolHandle> &tools)
+{
+    if (m_catalogResetPending)
+    {
+        m_catalogResetPending = false;
+        m_catalog.reset(tools);
+    }
+    else
+    {
+        m_catalog.append(tools);
+    }
+    emit scanBatchReady(tools);
+}
+
+void CoreService::handleScanCompleted(int toolCount, const QString &errors)
+{
+    if (m_catalogResetPending)
+    {
+        // The scan found nothing, so no batch cleared the previous catalog.
+        m_catalogResetPending = false;
+        m_catalog.reset({});
+    }
+    emit scanCompleted(toolCount, errors);
+}
+
+void CoreService::handleToolAdded(const ToolHandle &tool)
+{
+    m_catalog.upsert(tool);
+    emit toolAdded(tool);
+}
+
+void CoreService::handleToolUpdated(const ToolHandle &tool)
+{
+    // Watch events arrive before the next open/run, so the stale full decode is
+    // dropped eagerly; the size/mtime check in resolve() covers the rest.
+    m_manifests.invalidate(tool->toolDir);
+    const ToolHandle previous = m_catalog.upsert(tool);
+    emit toolUpdated(tool, previous);
+}
+
+void CoreService::handleToolRemoved(const QString &toolId)
+{
+    const ToolHandle removed = m_catalog.remove(toolId);
+    if (removed)
+    {
+        m_manifests.invalidate(removed->toolDir);
+        emit toolRemoved(removed);
+    }
+}
+
+void CoreService::handleJobStarted(const QString &runId, const QString &toolId, const QString &runDirectory)
+{
+    const auto it = m_activeRuns.find(runId);
+    if (it != m_activeRuns.end())
+    {
+        it->started.start();
+        it->runDirectory = runDirectory;
+    }
+    emit jobStarted(runId, toolId, runDirectory);
+}
+
+void CoreService::handleJobOutput(const QString &runId, const QString &toolId, const QStringList &lines, bool isError)
 {
-    emit jobStarted(toolId, runDirectory);
+    emit jobOutput(runId, toolId, lines, isError);
+    // Receivers on this thread have handled the batch by now; let the worker
+    // count it against the run's output budget.
+    QMetaObject::invokeMethod(m_jobWorker, "outputConsumed", Qt::QueuedConnection, Q_ARG(QString, runId), Q_ARG(qint64, OutputFramer::byteSize(lines)));
+    QString label;
+    const QString parent = shardParentOf(runId, label);
+    if (!parent.isEmpty())
+    {
+        QStringList labelled;
+        labelled.reserve(lines.size());
+        for (const QString &line : lines)
+        {
+            labelled << QStringLiteral("[%1] %2").arg(label, line);
+        }
+        emit jobOutput(parent, toolId, labelled, isError);
+    }
 }
 
-void CoreService::handleJobOutput(const QString &toolId, const QString &line, bool isError)
+void CoreService::handleJobMetrics(const QString &runId, const QString &toolId, const RunMetricsDTO &metrics)
 {
-    emit jobOutput(toolId, line, isError);
+    emit jobMetrics(runId, toolId, metrics);
 }
 
-void CoreService::handleJobFinished(const QString &toolId, int exitCode, const QString &message)
+void CoreService::handleJobProgress(const QString &runId, const QString &toolId, const RunProgressDTO &progress)
 {
-    emit jobFinished(toolId, exitCode, message);
+    emit jobProgress(runId, toolId, progress);
+}
+
+void CoreService::handleJobFinished(const QString &runId, const QString &toolId, int exitCode, const QString &message)
+{
+    const ActiveRun run = m_activeRuns.take(runId);
+    // Only clean exits feed the estimate; failures and cancellations say
+    // little about how long the tool normally takes, and cache hits never
+    // ran the tool at all.
+    if (exitCode == 0 && run.started.isValid() && message != QLatin1String(JobWorker::kCachedMessage))
+    {
+        m_runHistory.record(toolId, run.toolVersion, run.started.elapsed());
+        m_historySaveTimer.start();
+    }
+    emit jobFinished(runId, toolId, exitCode, message);
+    recordBatchRun(runId, exitCode, message, run.started.isValid() ? run.started.elapsed() : 0, run.runDirectory);
+    QString label;
+    const QString parent = shardParentOf(runId, label);
+    if (!parent.isEmpty() && label == QStringLiteral("merge"))
+    {
+        finishShardedRun(parent, exitCode, message);
+    }
+    dispatchQueuedJobs();
 }
 
 void CoreService::handleEnvReady(const QString &toolId, const QString &envPath)
 {
     emit envReady(toolId, envPath);
 
-    if (!m_pendingJobs.contains(toolId))
+    // EnvWorker answers per tool, so one ready env releases every run of that
+    // tool still waiting for it, in submission order.
+    QStringList released;
+    for (auto it = m_pendingJobs.begin(); it != m_pendingJobs.end(); ++it)
     {
-        return;
+        if (!it->envReady && it->tool->id == toolId)
+        {
+            it->envReady = true;
+            it->envPath = envPath;
+            released << it.key();
+        }
+    }
+    std::sort(released.begin(), released.end(), [this](const QString &a, const QString &b)
+              { return m_pendingJobs.value(a).seq < m_pendingJobs.value(b).seq; });
+    for (const QString &runId : std::as_const(released))
+    {
+        enqueueRun(runId);
+    }
+
+    for (auto it = m_batches.begin(); it != m_batches.end(); ++it)
+    {
+        if (!it->envReady && it->tool->id == toolId)
+        {
+            it->envReady = true;
+            it->envPath = envPath;
+            feedBatch(*it);
+        }
     }
-    auto pending = m_pendingJobs.take(toolId);
-    QMetaObject::invokeMethod(
-        m_jobWorker,
-        "runJob",
-        Qt::QueuedConnection,
-        Q_ARG(QString, pending.toolsRoot),
-        Q_ARG(ToolDTO, pending.tool),
-        Q_ARG(RunRequestDTO, pending.request),
-        Q_ARG(QString, envPath));
 }
 
 void CoreService::handleEnvError(const QString &toolId, const QString &message)
 {
     emit envFailed(toolId, message);
-    m_pendingJobs.remove(toolId);
+
+    for (auto it = m_pendingJobs.begin(); it != m_pendingJobs.end();)
+    {
+        if (!it->envReady && it->tool->id == toolId)
+        {
+            const QString runId = it.key();
+            it = m_pendingJobs.erase(it);
+            emit jobFinished(runId, toolId, -1, QStringLiteral("Environment failed: %1").arg(message));
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    QStringList failedBatches;
+    for (auto it = m_batches.begin(); it != m_batches.end(); ++it)
+    {
+        if (!it->envReady && it->tool->id == toolId)
+        {
+            for (BatchRunResultDTO &run : it->summary.runs)
+            {
+                run.status = QStringLiteral("failed");
+                run.message = QStringLiteral("Environment failed: %1").arg(message);
+            }
+            failedBatches << it.key();
+        }
+    }
+    for (const QString &batchId : std::as_const(failedBatches))
+    {
+        finishBatch(batchId);
+    }
 }
 
 void CoreService::ensureWorkerReady()
@@ -210,7 +1098,13 @@ void CoreService::ensureScanWorkerReady()
         m_scanWorker->moveToThread(&m_scanThread);
 
         connect(&m_scanThread, &QThread::finished, m_scanWorker, &QObject::deleteLater);
+        connect(m_scanWorker, &ScanWorker::catalogRestored, this, &CoreService::handleCatalogRestored);
         connect(m_scanWorker, &ScanWorker::scanFinished, this, &CoreService::handleScanFinished);
+        connect(m_scanWorker, &ScanWorker::scanBatchReady, this, &CoreService::handleScanBatchReady);
+        connect(m_scanWorker, &ScanWorker::scanCompleted, this, &CoreService::handleScanCompleted);
+        connect(m_scanWorker, &ScanWorker::toolAdded, this, &CoreService::handleToolAdded);
+        connect(m_scanWorker, &ScanWorker::toolUpdated, this, &CoreService::handleToolUpdated);
+        connect(m_scanWorker, &ScanWorker::toolRemoved, this, &CoreService::handleToolRemoved);
     }
 
     if (!m_scanThread.isRunning())
@@ -221,14 +1115,39 @@ void CoreService::ensureScanWorkerReady()
 
 void CoreService::ensureJobWorkerReady()
 {
+    if (!m_logWriter)
+    {
+        m_logWriter = new LogWriter(m_logOptions);
+        m_logWriter->moveToThread(&m_logThread);
+        connect(&m_logThread, &QThread::finished, m_logWriter, &QObject::deleteLater);
+    }
+
+    if (!m_logThread.isRunning())
+    {
+        m_logThread.start();
+    }
+
     if (!m_jobWorker)
     {
         m_jobWorker = new JobWorker();
+        m_jobWorker->setLogWriter(m_logWriter);
+        if (m_outputBudget > 0)
+        {
+            m_jobWorker->setOutputBudget(m_outputBudget);
+        }
+        if (m_resultCacheLimit >= 0)
+        {
+            m_jobWorker->setResultCacheLimit(m_resultCacheLimit);
+        }
+        m_jobWorker->setToolLibraryDir(m_toolLibraryDir);
+        m_jobWorker->setBinaryPaths(m_binaryPaths);
         m_jobWorker->moveToThread(&m_jobThread);
 
         connect(&m_jobThread, &QThread::finished, m_jobWorker, &QObject::deleteLater);
         connect(m_jobWorker, &JobWorker::jobStarted, this, &CoreService::handleJobStarted);
         connect(m_jobWorker, &JobWorker::jobOutput, this, &CoreService::handleJobOutput);
+        connect(m_jobWorker, &JobWorker::jobMetrics, this, &CoreService::handleJobMetrics);
+        connect(m_jobWorker, &JobWorker::jobProgress, this, &CoreService::handleJobProgress);
         connect(m_jobWorker, &JobWorker::jobFinished, this, &CoreService::handleJobFinished);
     }
 
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "common/Dto.h"
+#include "core/JobScheduler.h"
+#include "core/RunHistory.h"
+#include "core/ToolCatalog.h"
+#include "core/ToolManifest.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QThread>
+#include <QTimer>
 #include <QStringList>
 #include <QHash>
 
@@ -11,6 +18,7 @@ class SelfTestWorker;
 class ScanWorker;
 class JobWorker;
 class EnvWorker;
+class LogWriter;
 
 class CoreService : public QObject
 {
@@ -25,26 +33,88 @@ public:
     void runSchedulingSelfTest(int taskCount = 3);
 
     void startScan(const QString &toolsRoot);
-    void runJob(const QString &toolsRoot, const ToolDTO &tool, const RunRequestDTO &request);
-    void runTool(const QString &toolsRoot, const ToolDTO &tool, const RunRequestDTO &request);
+    void startScan(const ScanOptionsDTO &options);
+    void startStreamingScan(const QString &toolsRoot);
+    void startStreamingScan(const ScanOptionsDTO &options);
+    void setParallelScan(bool enabled);
+    void startWatching(const QString &toolsRoot);
+    void startWatching(const ScanOptionsDTO &options);
+    void stopWatching();
+    // Current snapshot of the scanned tools; cheap to copy and never changes
+    // under the caller.
+    ToolCatalog catalog() const { return m_catalog; }
+    ToolHandle loadToolDetails(const QString &toolsRoot, const ToolHandle &tool, QString &error);
+    // Both return the run id used by the job* signals. A run is started once
+    // its environment is ready and fewer than maxConcurrentJobs() runs are
+    // active; until then it waits in the JobScheduler queue, ordered by
+    // RunRequestDTO::priority and the tool's recorded run durations.
+    QString runJob(const QString &toolsRoot, const ToolHandle &tool, const RunRequestDTO &request);
+    QString runTool(const QString &toolsRoot, const ToolHandle &tool, const RunRequestDTO &request);
+    void cancelRun(const QString &runId);
+    // Expands a parameter sweep (see ParamSweep) into runs of one tool. The
+    // environment is prepared once; runs are then fed to the queue so that at
+    // most batch.maxConcurrent of them are queued or running at a time.
+    // Returns the batch id, or an empty string with error set.
+    QString runBatch(const QString &toolsRoot, const ToolHandle &tool, const BatchRequestDTO &batch, QString &error);
+    void cancelBatch(const QString &batchId);
+    void setMaxConcurrentJobs(int count);
+    int maxConcurrentJobs() const { return m_maxConcurrentJobs; }
+    void setSchedulingPolicy(JobScheduler::Policy policy) { m_scheduler.setPolicy(policy); }
+    // Bytes of output per run that may be in flight to the UI before lines are
+    // dropped (see JobWorker); the log files are never affected.
+    void setOutputBudget(qint64 bytes);
+    // Buffering and size cap of run logs; takes effect if called before the
+    // first run.
+    void setLogOptions(const LogOptionsDTO &options) { m_logOptions = options; }
+    // Size bound of the runtime.cache result store.
+    void setResultCacheLimit(qint64 bytes);
+    // Helper modules for tool scripts (tools/_lib); passed to every run as
+    // TOOLBOX_LIB. Takes effect if called before the first run.
+    void setToolLibraryDir(const QString &dir) { m_toolLibraryDir = dir; }
+    // Paths behind {{config.bin.<name>}} in runtime.args. Takes effect if
+    // called before the first run.
+    void setBinaryPaths(const QMap<QString, QString> &paths) { m_binaryPaths = paths; }
+    int activeJobCount() const { return m_activeRuns.size(); }
+    int queuedJobCount() const { return m_scheduler.size(); }
+    const RunHistory &runHistory() const { return m_runHistory; }
 
 signals:
     void selfTestProgress(int finished, int total, const QString &threadName);
     void selfTestCompleted(bool success, const QStringList &threadNames);
+    void catalogRestored(const ScanResultDTO &result);
     void scanFinished(const ScanResultDTO &result);
-    void jobStarted(const QString &toolId, const QString &runDirectory);
-    void jobOutput(const QString &toolId, const QString &line, bool isError);
-    void jobFinished(const QString &toolId, int exitCode, const QString &message);
+    void scanBatchReady(const QList<ToolHandle> &tools);
+    void scanCompleted(int toolCount, const QString &errors);
+    void toolAdded(const ToolHandle &tool);
+    void toolUpdated(const ToolHandle &tool, const ToolHandle &previous);
+    void toolRemoved(const ToolHandle &tool);
+    void jobQueued(const QString &runId, const QString &toolId, int position);
+    void jobStarted(const QString &runId, const QString &toolId, const QString &runDirectory);
+    void jobOutput(const QString &runId, const QString &toolId, const QStringList &lines, bool isError);
+    void jobMetrics(const QString &runId, const QString &toolId, const RunMetricsDTO &metrics);
+    void jobProgress(const QString &runId, const QString &toolId, const RunProgressDTO &progress);
+    void jobFinished(const QString &runId, const QString &toolId, int exitCode, const QString &message);
+    void batchStarted(const QString &batchId, const QString &toolId, int total);
+    void batchProgress(const QString &batchId, int finished, int total);
+    void batchFinished(const BatchSummaryDTO &summary);
     void envPreparing(const QString &toolId);
     void envFailed(const QString &toolId, const QString &message);
     void envReady(const QString &toolId, const QString &envPath);
 
 private slots:
     void handleWorkFinished(int id, const QString &payload, const QString &threadName);
+    void handleCatalogRestored(const ScanResultDTO &result);
     void handleScanFinished(const ScanResultDTO &result);
-    void handleJobStarted(const QString &toolId, const QString &runDirectory);
-    void handleJobOutput(const QString &toolId, const QString &line, bool isError);
-    void handleJobFinished(const QString &toolId, int exitCode, const QString &message);
+    void handleScanBatchReady(const QList<ToolHandle> &tools);
+    void handleScanCompleted(int toolCount, const QString &errors);
+    void handleToolAdded(const ToolHandle &tool);
+    void handleToolUpdated(const ToolHandle &tool);
+    void handleToolRemoved(const QString &toolId);
+    void handleJobStarted(const QString &runId, const QString &toolId, const QString &runDirectory);
+    void handleJobOutput(const QString &runId, const QString &toolId, const QStringList &lines, bool isError);
+    void handleJobMetrics(const QString &runId, const QString &toolId, const RunMetricsDTO &metrics);
+    void handleJobProgress(const QString &runId, const QString &toolId, const RunProgressDTO &progress);
+    void handleJobFinished(const QString &runId, const QString &toolId, int exitCode, const QString &message);
     void handleEnvReady(const QString &toolId, const QString &envPath);
     void handleEnvError(const QString &toolId, const QString &message);
 
@@ -53,6 +123,23 @@ private:
     void ensureScanWorkerReady();
     void ensureJobWorkerReady();
     void ensureEnvWorkerReady();
+    QString submitRun(const ToolHandle &tool, const RunRequestDTO &request, bool prepareEnv, const QString &envPath = QString());
+    void enqueueRun(const QString &runId);
+    void dispatchQueuedJobs();
+    struct Batch;
+    QString startBatch(const ToolHandle &tool, const BatchRequestDTO &request, const QString &shardParent);
+    void feedBatch(Batch &batch);
+    void recordBatchRun(const QString &runId, int exitCode, const QString &message, qint64 durationMs, const QString &runDirectory);
+    void finishBatch(const QString &batchId);
+    QString startShardedRun(const ToolHandle &tool, const RunRequestDTO &request, const QString &inputPath);
+    void handleShardsFinished(const QString &parentRunId, const BatchSummaryDTO &summary, const QString &envPath);
+    void finishShardedRun(const QString &parentRunId, int exitCode, const QString &message);
+    // A line about the sharded run itself: shown as its output and kept for
+    // logs/shard.log.
+    void shardedRunOutput(const QString &parentRunId, const QString &line);
+    // Parent run id (and a "shard N"/"merge" label) of a run spawned by a
+    // sharded run; empty for ordinary runs.
+    QString shardParentOf(const QString &runId, QString &label) const;
 
     QThread m_workerThread;
     SelfTestWorker *m_worker{nullptr};
@@ -66,14 +153,81 @@ private:
     QThread m_envThread;
     EnvWorker *m_envWorker{nullptr};
 
+    QThread m_logThread;
+    LogWriter *m_logWriter{nullptr};
+    LogOptionsDTO m_logOptions;
+
+    ToolManifestCache m_manifests;
+    ToolCatalog m_catalog;
+    bool m_catalogResetPending{false}; // next streamed batch replaces the catalog
+
     int m_expectedTasks{0};
     QStringList m_completedThreadNames;
 
     struct PendingJob
     {
         QString toolsRoot;
-        ToolDTO tool;
+        ToolHandle tool;
+        RunRequestDTO request;
+        quint64 seq{0};
+        QString envPath;
+        bool envReady{false};
+    };
+    struct ActiveRun
+    {
+        QString toolId;
+        QString toolVersion;
+        QElapsedTimer started; // valid once jobStarted arrived
+        QString runDirectory;
+    };
+    QHash<QString, PendingJob> m_pendingJobs; // by run id, until the run starts
+    QHash<QString, ActiveRun> m_activeRuns;   // by run id
+    JobScheduler m_scheduler;                 // run ids with a ready env
+    RunHistory m_runHistory;
+    QTimer m_historySaveTimer;
+    int m_maxConcurrentJobs{1};
+    qint64 m_outputBudget{0};     // 0 keeps the JobWorker default
+    qint64 m_resultCacheLimit{-1}; // < 0 keeps the JobWorker default
+    QString m_toolLibraryDir;
+    QMap<QString, QString> m_binaryPaths;
+    quint64 m_runCounter{0};
+
+    struct Batch
+    {
+        ToolHandle tool;
+        BatchRequestDTO request;
+        QList<QList<RunParamValueDTO>> runs; // expanded parameter sets
+        int next{0};                         // first run not yet submitted
+        int inFlight{0};
+        int finished{0};
+        bool envReady{false};
+        bool cancelled{false};
+        QString envPath;
+        QDateTime startedAt;
+        QElapsedTimer clock;
+        BatchSummaryDTO summary;
+        QString shardParent; // run id of the sharded run this batch maps, if any
+    };
+    QHash<QString, Batch> m_batches;                 // by batch id
+    QHash<QString, QPair<QString, int>> m_batchRuns; // run id -> (batch id, run index)
+    quint64 m_batchCounter{0};
+
+    // A sharded run: split input -> one run per shard (an internal batch) ->
+    // merge step or concatenation. Reported under its own run id; its run
+    // directory gets metadata.json and logs/shard.log when it finishes.
+    struct ShardedRun
+    {
+        ToolHandle tool;
         RunRequestDTO request;
+        QString runDirectory;
+        QString batchId;    // while shards run
+        QString mergeRunId; // while the merge step runs
+        bool merged{false}; // a merge step ran in runDirectory
+        bool cancelled{false};
+        QDateTime startedAt;
+        QElapsedTimer clock;
+        QList<BatchRunResultDTO> shards;
+        QStringList log;
     };
-    QHash<QString, PendingJob> m_pendingJobs;
+    QHash<QString, ShardedRun> m_shardedRuns; // by parent run id
 };
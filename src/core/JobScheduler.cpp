@@ -0,0 +1,118 @@
+#include "JobScheduler.h"
+
+namespace
+{
+// Stand-in for runs without history: long enough that an unknown tool does
+// not overtake known short runs, short enough that it is not parked behind
+// known batch jobs.
+constexpr qint64 kUnknownExpectedMs = 60 * 1000;
+} // namespace
+
+JobScheduler::JobScheduler()
+{
+    m_clock.start();
+}
+
+void JobScheduler::enqueue(const QString &runId, int priority, qint64 expectedMs)
+{
+    m_entries.append(Entry{runId, priority, expectedMs, m_clock.elapsed(), ++m_seq});
+}
+
+bool JobScheduler::remove(const QString &runId)
+{
+    for (qsizetype i = 0; i < m_entries.size(); ++i)
+    {
+        if (m_entries.at(i).runId == runId)
+        {
+            m_entries.removeAt(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+QString JobScheduler::takeNext()
+{
+    if (m_entries.isEmpty())
+    {
+        return QString();
+    }
+    // Ranks change as runs wait, so the winner is picked at dispatch time with
+    // a linear scan instead of being kept in a sorted structure.
+    const qint64 now = m_clock.elapsed();
+    qsizetype best = 0;
+    for (qsizetype i = 1; i < m_entries.size(); ++i)
+    {
+        if (runsBefore(m_entries.at(i), m_entries.at(best), now))
+        {
+            best = i;
+        }
+    }
+    return m_entries.takeAt(best).runId;
+}
+
+int JobScheduler::position(const QString &runId) const
+{
+    const qint64 now = m_clock.elapsed();
+    const Entry *target = nullptr;
+    for (const Entry &entry : m_entries)
+    {
+        if (entry.runId == runId)
+        {
+            target = &entry;
+            break;
+        }
+    }
+    if (!target)
+    {
+        return 0;
+    }
+    int ahead = 0;
+    for (const Entry &entry : m_entries)
+    {
+        if (&entry != target && runsBefore(entry, *target, now))
+        {
+            ++ahead;
+        }
+    }
+    return ahead + 1;
+}
+
+JobScheduler::Policy JobScheduler::policyFromString(const QString &name)
+{
+    return name.trimmed().compare(QStringLiteral("fifo"), Qt::CaseInsensitive) == 0 ? Policy::Fifo : Policy::ShortestFirst;
+}
+
+bool JobScheduler::runsBefore(const Entry &a, const Entry &b, qint64 now) const
+{
+    const qint64 waitA = now - a.enqueuedMs;
+    const qint64 waitB = now - b.enqueuedMs;
+    const qint64 priorityA = a.priority + waitA / m_agingStepMs;
+    const qint64 priorityB = b.priority + waitB / m_agingStepMs;
+    if (priorityA != priorityB)
+    {
+        return priorityA > priorityB;
+    }
+
+    if (m_policy == Policy::ShortestFirst)
+    {
+        const double expectedA = static_cast<double>(expectedOf(a));
+        const double expectedB = static_cast<double>(expectedOf(b));
+        const double ratioA = (waitA + expectedA) / expectedA;
+        const double ratioB = (waitB + expectedB) / expectedB;
+        if (ratioA != ratioB)
+        {
+            return ratioA > ratioB;
+        }
+        if (expectedA != expectedB)
+        {
+            return expectedA < expectedB;
+        }
+    }
+    return a.seq < b.seq;
+}
+
+qint64 JobScheduler::expectedOf(const Entry &entry) const
+{
+    return entry.expectedMs > 0 ? entry.expectedMs : kUnknownExpectedMs;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+// Orders runs that are ready to start. Higher explicit priority always goes
+// first; every agingStepMs() spent waiting raises a run's priority by one so
+// low-priority work is not starved. Within a priority level the ShortestFirst
+// policy picks the highest response ratio (wait + expected) / expected, which
+// favours short runs but lets long runs catch up as they wait; Fifo keeps
+// submission order.
+class JobScheduler
+{
+public:
+    enum class Policy
+    {
+        ShortestFirst,
+        Fifo,
+    };
+
+    JobScheduler();
+
+    void setPolicy(Policy policy) { m_policy = policy; }
+    Policy policy() const { return m_policy; }
+    void setAgingStepMs(qint64 ms) { m_agingStepMs = qMax<qint64>(1, ms); }
+    qint64 agingStepMs() const { return m_agingStepMs; }
+
+    // expectedMs <= 0 means unknown; such runs are ranked with a neutral
+    // estimate instead of jumping ahead as "instant".
+    void enqueue(const QString &runId, int priority, qint64 expectedMs);
+    bool remove(const QString &runId);
+    QString takeNext();
+    void clear() { m_entries.clear(); }
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int size() const { return m_entries.size(); }
+    // 1-based rank of a queued run at this moment, or 0 if it is not queued.
+    int position(const QString &runId) const;
+
+    static Policy policyFromString(const QString &name);
+
+private:
+    struct Entry
+    {
+        QString runId;
+        int priority{0};
+        qint64 expectedMs{0};
+        qint64 enqueuedMs{0};
+        quint64 seq{0};
+    };
+
+    bool runsBefore(const Entry &a, const Entry &b, qint64 now) const;
+    qint64 expectedOf(const Entry &entry) const;
+
+    QList<Entry> m_entries;
+    QElapsedTimer m_clock;
+    Policy m_policy{Policy::ShortestFirst};
+    qint64 m_agingStepMs{10 * 60 * 1000};
+    quint64 m_seq{0};
+};
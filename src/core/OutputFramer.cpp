@@ -0,0 +1,86 @@
+#include "OutputFramer.h"
+
+#include <utility>
+
+namespace
+{
+void chopCarriageReturn(QString &line)
+{
+    if (line.endsWith(QLatin1Char('\r')))
+    {
+        line.chop(1);
+    }
+}
+} // namespace
+
+void OutputFramer::append(const QByteArray &data)
+{
+    // The stateful decoder keeps an incomplete multi-byte sequence at the end
+    // of data and prepends it to the next chunk.
+    const QString text = m_decoder.decode(data);
+    qsizetype start = 0;
+    while (start < text.size())
+    {
+        const qsizetype newline = text.indexOf(QLatin1Char('\n'), start);
+        if (newline < 0)
+        {
+            m_partial += QStringView(text).sliced(start);
+            break;
+        }
+        QString line = m_partial.isEmpty() ? text.sliced(start, newline - start)
+                                           : m_partial + QStringView(text).sliced(start, newline - start);
+        m_partial.clear();
+        chopCarriageReturn(line);
+        addLine(line);
+        start = newline + 1;
+    }
+
+    while (m_partial.size() >= kMaxLineLength)
+    {
+        addLine(m_partial.left(kMaxLineLength));
+        m_partial.remove(0, kMaxLineLength);
+    }
+}
+
+void OutputFramer::finish()
+{
+    m_partial += m_decoder.decode(QByteArray());
+    if (!m_partial.isEmpty())
+    {
+        chopCarriageReturn(m_partial);
+        addLine(m_partial);
+        m_partial.clear();
+    }
+}
+
+QStringList OutputFramer::takeLines()
+{
+    m_pendingBytes = 0;
+    return std::exchange(m_lines, QStringList());
+}
+
+QStringList OutputFramer::takeControlLines()
+{
+    return std::exchange(m_controlLines, QStringList());
+}
+
+qint64 OutputFramer::byteSize(const QStringList &lines)
+{
+    qint64 bytes = 0;
+    for (const QString &line : lines)
+    {
+        bytes += line.size() * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
+
+void OutputFramer::addLine(const QString &line)
+{
+    if (!m_controlPrefix.isEmpty() && line.startsWith(m_controlPrefix))
+    {
+        m_controlLines << line.mid(m_controlPrefix.size());
+        return;
+    }
+    m_lines << line;
+    m_pendingBytes += line.size() * qint64(sizeof(QChar));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringDecoder>
+#include <QStringList>
+
+// Turns the raw byte chunks of one process stream into text lines. UTF-8
+// sequences and lines split across chunks are carried over to the next
+// append(); complete lines accumulate until the owner takes them, so output
+// can be delivered in batches instead of one signal per line. Lines starting
+// with the control prefix are kept apart from the output (see RunProgress).
+class OutputFramer
+{
+public:
+    // A line that grows past this without a newline (progress bars redrawn
+    // with '\r', binary noise) is delivered in pieces of this size.
+    static constexpr qsizetype kMaxLineLength = 64 * 1024;
+
+    void setControlPrefix(const QString &prefix) { m_controlPrefix = prefix; }
+
+    void append(const QByteArray &data);
+    // End of stream: delivers a trailing unterminated line.
+    void finish();
+
+    bool hasLines() const { return !m_lines.isEmpty(); }
+    // Memory held by the complete lines not yet taken.
+    qint64 pendingBytes() const { return m_pendingBytes; }
+    QStringList takeLines();
+    bool hasControlLines() const { return !m_controlLines.isEmpty(); }
+    // Control lines with the prefix removed.
+    QStringList takeControlLines();
+
+    static qint64 byteSize(const QStringList &lines);
+
+private:
+    void addLine(const QString &line);
+
+    QStringDecoder m_decoder{QStringDecoder::Utf8};
+    QString m_partial;
+    QStringList m_lines;
+    qint64 m_pendingBytes{0};
+    QString m_controlPrefix;
+    QStringList m_controlLines;
+};
@@ -0,0 +1,420 @@
+#include "ParamSweep.h"
+
+#include "core/ParamValidator.h"
+
+#include <QSet>
+
+#include <cmath>
+
+namespace
+{
+bool isNumeric(const ParamDTO &param)
+{
+    return param.type == ParamType::Int || param.type == ParamType::Float;
+}
+
+QString formatFloat(double value)
+{
+    return QString::number(value, 'g', 12);
+}
+
+bool expandRange(const ParamDTO &param, const QString &token, QStringList &values, QString &error)
+{
+    const qsizetype dots = token.indexOf(QStringLiteral(".."));
+    const QString startText = token.left(dots).trimmed();
+    QString endText = token.mid(dots + 2).trimmed();
+    QString stepText;
+    if (const qsizetype colon = endText.indexOf(QLatin1Char(':')); colon >= 0)
+    {
+        stepText = endText.mid(colon + 1).trimmed();
+        endText = endText.left(colon).trimmed();
+    }
+
+    bool okStart = false;
+    bool okEnd = false;
+    bool okStep = true;
+    const double start = startText.toDouble(&okStart);
+    const double end = endText.toDouble(&okEnd);
+    double step = param.type == ParamType::Float && param.step > 0 ? param.step : 1.0;
+    if (!stepText.isEmpty())
+    {
+        step = stepText.toDouble(&okStep);
+    }
+    if (!okStart || !okEnd || !okStep || !(step > 0) || !std::isfinite(start) || !std::isfinite(end))
+    {
+        error = QStringLiteral("Invalid range '%1' for %2").arg(token, param.key);
+        return false;
+    }
+    if (param.type == ParamType::Int && (start != std::floor(start) || end != std::floor(end) || step != std::floor(step)))
+    {
+        error = QStringLiteral("Range '%1' for integer param %2 must use whole numbers").arg(token, param.key);
+        return false;
+    }
+
+    // Count steps up front (with a little slack for binary fractions) so
+    // float ranges do not drift and oversized sweeps are rejected early.
+    const double span = std::fabs(end - start);
+    const double count = std::floor(span / step + 1e-9) + 1;
+    if (count > ParamSweep::kMaxRuns)
+    {
+        error = QStringLiteral("Range '%1' for %2 expands to more than %3 values").arg(token, param.key).arg(ParamSweep::kMaxRuns);
+        return false;
+    }
+    const double direction = end >= start ? 1.0 : -1.0;
+    for (qint64 i = 0; i < static_cast<qint64>(count); ++i)
+    {
+        const double number = start + direction * step * static_cast<double>(i);
+        const QString text = param.type == ParamType::Int ? QString::number(qRound64(number)) : formatFloat(number);
+        QString value;
+        if (!ParamValidator::normalizeValue(param, text, value, error))
+        {
+            return false;
+        }
+        values << value;
+    }
+    return true;
+}
+
+// Minimal RFC 4180 reader: quoted fields may hold commas, doubled quotes and
+// line breaks. Returns the records with their 1-based starting line.
+QList<QPair<int, QStringList>> readCsvRecords(const QString &text)
+{
+    QList<QPair<int, QStringList>> records;
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    bool fieldStarted = false;
+    int line = 1;
+    int recordLine = 1;
+
+    auto endRecord = [&]() {
+        fields << field;
+        const bool blank = fields.size() == 1 && fields.first().trimmed().isEmpty() && !fieldStarted;
+        if (!blank)
+        {
+            records.append({recordLine, fields});
+        }
+        fields.clear();
+        field.clear();
+        fieldStarted = false;
+    };
+
+    for (qsizetype i = 0; i < text.size(); ++i)
+    {
+        const QChar c = text.at(i);
+        if (quoted)
+        {
+            if (c == QLatin1Char('"'))
+            {
+                if (i + 1 < text.size() && text.at(i + 1) == QLatin1Char('"'))
+                {
+                    field += c;
+                    ++i;
+                }
+                else
+                {
+                    quoted = false;
+                }
+            }
+            else
+            {
+                if (c == QLatin1Char('\n'))
+                {
+                    ++line;
+                }
+                field += c;
+            }
+            continue;
+        }
+
+        if (c == QLatin1Char('"') && field.trimmed().isEmpty())
+        {
+            quoted = true;
+            fieldStarted = true;
+            field.clear();
+        }
+        else if (c == QLatin1Char(','))
+        {
+            fields << field;
+            field.clear();
+            fieldStarted = true;
+        }
+        else if (c == QLatin1Char('\n'))
+        {
+            endRecord();
+            recordLine = ++line;
+        }
+        else if (c != QLatin1Char('\r'))
+        {
+            field += c;
+        }
+    }
+    if (!field.isEmpty() || !fields.isEmpty() || fieldStarted)
+    {
+        endRecord();
+    }
+    return records;
+}
+
+void setValues(QList<RunParamValueDTO> &params, const QString &key, const QStringList &values)
+{
+    for (RunParamValueDTO &param : params)
+    {
+        if (param.key == key)
+        {
+            param.values = values;
+            return;
+        }
+    }
+    params.append(RunParamValueDTO{key, values});
+}
+} // namespace
+
+bool ParamSweep::parseAxis(const ParamDTO &param, const QString &spec, QStringList &values, QString &error)
+{
+    values.clear();
+    const QString trimmed = spec.trimmed();
+    if (trimmed.isEmpty())
+    {
+        error = QStringLiteral("No values given for %1").arg(param.key);
+        return false;
+    }
+
+    if (trimmed == QStringLiteral("*"))
+    {
+        if (param.type == ParamType::Select)
+        {
+            for (const ParamOption &option : param.options)
+            {
+                values << option.value;
+            }
+        }
+        else if (param.type == ParamType::Bool)
+        {
+            values << QStringLiteral("true") << QStringLiteral("false");
+        }
+        if (values.isEmpty())
+        {
+            error = QStringLiteral("'*' needs a select or bool param with options (%1)").arg(param.key);
+            return false;
+        }
+        return true;
+    }
+
+    for (const QString &raw : trimmed.split(QLatin1Char(','), Qt::SkipEmptyParts))
+    {
+        const QString token = raw.trimmed();
+        if (isNumeric(param) && token.indexOf(QStringLiteral("..")) > 0)
+        {
+            if (!expandRange(param, token, values, error))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            QString value;
+            if (!ParamValidator::normalizeValue(param, token, value, error))
+            {
+                return false;
+            }
+            values << value;
+        }
+        if (values.size() > kMaxRuns)
+        {
+            error = QStringLiteral("Sweep of %1 has more than %2 values").arg(param.key).arg(kMaxRuns);
+            return false;
+        }
+    }
+    if (values.isEmpty())
+    {
+        error = QStringLiteral("No values given for %1").arg(param.key);
+        return false;
+    }
+    return true;
+}
+
+bool ParamSweep::parseCsv(const QString &text, const QList<ParamDTO> &params, QList<QList<RunParamValueDTO>> &rows, QString &error)
+{
+    rows.clear();
+    QString content = text;
+    if (content.startsWith(QChar(0xFEFF)))
+    {
+        content.remove(0, 1);
+    }
+    const auto records = readCsvRecords(content);
+    if (records.isEmpty())
+    {
+        error = QStringLiteral("CSV is empty");
+        return false;
+    }
+
+    QList<const ParamDTO *> columns;
+    QSet<QString> seen;
+    for (const QString &header : records.first().second)
+    {
+        const QString key = header.trimmed();
+        const ParamDTO *match = nullptr;
+        for (const ParamDTO &param : params)
+        {
+            if (param.key == key)
+            {
+                match = &param;
+                break;
+            }
+        }
+        if (!match)
+        {
+            error = QStringLiteral("Unknown parameter column '%1'").arg(key);
+            return false;
+        }
+        if (seen.contains(key))
+        {
+            error = QStringLiteral("Duplicate parameter column '%1'").arg(key);
+            return false;
+        }
+        seen.insert(key);
+        columns << match;
+    }
+
+    if (records.size() - 1 > kMaxRuns)
+    {
+        error = QStringLiteral("CSV has more than %1 rows").arg(kMaxRuns);
+        return false;
+    }
+    for (qsizetype r = 1; r < records.size(); ++r)
+    {
+        const auto &[line, cells] = records.at(r);
+        if (cells.size() != columns.size())
+        {
+            error = QStringLiteral("Line %1: expected %2 columns, found %3").arg(line).arg(columns.size()).arg(cells.size());
+            return false;
+        }
+        QList<RunParamValueDTO> row;
+        for (qsizetype c = 0; c < columns.size(); ++c)
+        {
+            const ParamDTO &param = *columns.at(c);
+            const QString cell = cells.at(c).trimmed();
+            if (cell.isEmpty())
+            {
+                continue; // keep the base value
+            }
+            // Multi-value params list their values separated by ';'.
+            const QStringList parts = param.multi ? cell.split(QLatin1Char(';'), Qt::SkipEmptyParts) : QStringList{cell};
+            QStringList values;
+            for (const QString &part : parts)
+            {
+                QString value;
+                if (!ParamValidator::normalizeValue(param, part, value, error))
+                {
+                    error = QStringLiteral("Line %1: %2").arg(line).arg(error);
+                    return false;
+                }
+                values << value;
+            }
+            row.append(RunParamValueDTO{param.key, values});
+        }
+        rows.append(row);
+    }
+    if (rows.isEmpty())
+    {
+        error = QStringLiteral("CSV has no parameter rows");
+        return false;
+    }
+    return true;
+}
+
+qint64 ParamSweep::runCount(const BatchRequestDTO &batch)
+{
+    if (!batch.rows.isEmpty())
+    {
+        return batch.rows.size();
+    }
+    qint64 count = 1;
+    for (const SweepAxisDTO &axis : batch.axes)
+    {
+        count *= axis.values.size();
+        if (count > kMaxRuns)
+        {
+            return kMaxRuns + 1;
+        }
+    }
+    return count;
+}
+
+QList<QList<RunParamValueDTO>> ParamSweep::expand(const BatchRequestDTO &batch)
+{
+    QList<QList<RunParamValueDTO>> runs;
+    const qint64 count = runCount(batch);
+    if (count <= 0 || count > kMaxRuns)
+    {
+        return runs;
+    }
+    runs.reserve(count);
+
+    if (!batch.rows.isEmpty())
+    {
+        for (const auto &row : batch.rows)
+        {
+            QList<RunParamValueDTO> params = batch.base.params;
+            for (const RunParamValueDTO &value : row)
+            {
+                setValues(params, value.key, value.values);
+            }
+            runs.append(params);
+        }
+        return runs;
+    }
+
+    // Odometer over the axes: the last axis turns fastest.
+    QList<qsizetype> index(batch.axes.size(), 0);
+    for (qint64 n = 0; n < count; ++n)
+    {
+        QList<RunParamValueDTO> params = batch.base.params;
+        for (qsizetype a = 0; a < batch.axes.size(); ++a)
+        {
+            const SweepAxisDTO &axis = batch.axes.at(a);
+            setValues(params, axis.key, {axis.values.at(index.at(a))});
+        }
+        runs.append(params);
+
+        for (qsizetype a = batch.axes.size() - 1; a >= 0; --a)
+        {
+            if (++index[a] < batch.axes.at(a).values.size())
+            {
+                break;
+            }
+            index[a] = 0;
+        }
+    }
+    return runs;
+}
+
+QList<RunParamValueDTO> ParamSweep::sweptValues(const BatchRequestDTO &batch, const QList<RunParamValueDTO> &params)
+{
+    QSet<QString> keys;
+    if (batch.rows.isEmpty())
+    {
+        for (const SweepAxisDTO &axis : batch.axes)
+        {
+            keys.insert(axis.key);
+        }
+    }
+    for (const auto &row : batch.rows)
+    {
+        for (const RunParamValueDTO &value : row)
+        {
+            keys.insert(value.key);
+        }
+    }
+
+    QList<RunParamValueDTO> swept;
+    for (const RunParamValueDTO &param : params)
+    {
+        if (keys.contains(param.key))
+        {
+            swept.append(param);
+        }
+    }
+    return swept;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Turns a batch description into concrete parameter sets. An axis spec is a
+// comma separated list of values; numeric params also accept ranges written
+// "start..end" or "start..end:step", and select/bool params accept "*" for
+// every option. A CSV has one column per param key and one run per row.
+class ParamSweep
+{
+public:
+    // Upper bound on the runs a single batch may expand to.
+    static constexpr int kMaxRuns = 100000;
+
+    static bool parseAxis(const ParamDTO &param, const QString &spec, QStringList &values, QString &error);
+    static bool parseCsv(const QString &text, const QList<ParamDTO> &params, QList<QList<RunParamValueDTO>> &rows, QString &error);
+
+    // Number of runs the batch expands to (saturating at kMaxRuns + 1).
+    static qint64 runCount(const BatchRequestDTO &batch);
+    // Full parameter lists, one per run: the base values with each row or
+    // axis combination applied on top. The first axis varies slowest.
+    static QList<QList<RunParamValueDTO>> expand(const BatchRequestDTO &batch);
+    // The values of one expanded run that differ per run (swept keys only).
+    static QList<RunParamValueDTO> sweptValues(const BatchRequestDTO &batch, const QList<RunParamValueDTO> &params);
+};
@@ -0,0 +1,174 @@
+#include "ParamValidator.h"
+
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+bool inBounds(const ParamDTO &param, double value)
+{
+    // min/max default to 0; only a real interval constrains the value.
+    return !(param.max > param.min) || (value >= param.min && value <= param.max);
+}
+
+const ParamDTO *findParam(const QList<ParamDTO> &params, const QString &key)
+{
+    for (const ParamDTO &param : params)
+    {
+        if (param.key == key)
+        {
+            return &param;
+        }
+    }
+    return nullptr;
+}
+
+bool hasValue(const RunParamValueDTO &value)
+{
+    for (const QString &text : value.values)
+    {
+        if (!text.trimmed().isEmpty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+bool ParamValidator::normalizeValue(const ParamDTO &param, const QString &raw, QString &value, QString &error)
+{
+    const QString text = raw.trimmed();
+    switch (param.type)
+    {
+    case ParamType::Int: {
+        bool ok = false;
+        const qlonglong number = text.toLongLong(&ok);
+        if (!ok || !inBounds(param, static_cast<double>(number)))
+        {
+            error = QStringLiteral("Invalid value '%1' for %2").arg(text, param.key);
+            return false;
+        }
+        value = QString::number(number);
+        return true;
+    }
+    case ParamType::Float: {
+        bool ok = false;
+        const double number = text.toDouble(&ok);
+        if (!ok || !std::isfinite(number) || !inBounds(param, number))
+        {
+            error = QStringLiteral("Invalid value '%1' for %2").arg(text, param.key);
+            return false;
+        }
+        value = QString::number(number, 'g', 12);
+        return true;
+    }
+    case ParamType::Bool: {
+        const QString lowered = text.toLower();
+        if (lowered == QStringLiteral("true") || lowered == QStringLiteral("1") || lowered == QStringLiteral("yes"))
+        {
+            value = QStringLiteral("true");
+            return true;
+        }
+        if (lowered == QStringLiteral("false") || lowered == QStringLiteral("0") || lowered == QStringLiteral("no"))
+        {
+            value = QStringLiteral("false");
+            return true;
+        }
+        error = QStringLiteral("Invalid value '%1' for %2").arg(text, param.key);
+        return false;
+    }
+    case ParamType::Select: {
+        if (param.options.isEmpty())
+        {
+            value = text;
+            return true;
+        }
+        for (const ParamOption &option : param.options)
+        {
+            if (option.value == text || option.label == text)
+            {
+                value = option.value;
+                return true;
+            }
+        }
+        error = QStringLiteral("'%1' is not an option of %2").arg(text, param.key);
+        return false;
+    }
+    default:
+        value = text;
+        return true;
+    }
+}
+
+bool ParamValidator::validate(const QList<ParamDTO> &params, QList<RunParamValueDTO> &values, QStringList &errors)
+{
+    const qsizetype errorsBefore = errors.size();
+    for (RunParamValueDTO &given : values)
+    {
+        const ParamDTO *param = findParam(params, given.key);
+        if (!param)
+        {
+            errors << QStringLiteral("Unknown param %1").arg(given.key);
+            continue;
+        }
+        if (given.values.size() > 1 && !param->multi)
+        {
+            errors << QStringLiteral("%1 takes a single value, got %2").arg(given.key).arg(given.values.size());
+        }
+        for (QString &text : given.values)
+        {
+            // An empty value stands for "not set"; required is checked below.
+            if (text.trimmed().isEmpty() && param->type != ParamType::Text)
+            {
+                text.clear();
+                continue;
+            }
+            QString value;
+            QString error;
+            if (!normalizeValue(*param, text, value, error))
+            {
+                errors << error;
+                continue;
+            }
+            text = value;
+            if (param->type == ParamType::Text && !param->pattern.isEmpty())
+            {
+                const QRegularExpression pattern(QRegularExpression::anchoredPattern(param->pattern));
+                if (pattern.isValid() && !pattern.match(text).hasMatch())
+                {
+                    errors << QStringLiteral("'%1' does not match the pattern of %2").arg(text, given.key);
+                }
+            }
+            else if (param->type == ParamType::File && !QFileInfo(text).isFile())
+            {
+                errors << QStringLiteral("%1: no such file %2").arg(given.key, text);
+            }
+            else if (param->type == ParamType::Dir && !QFileInfo(text).isDir())
+            {
+                errors << QStringLiteral("%1: no such directory %2").arg(given.key, text);
+            }
+        }
+    }
+
+    for (const ParamDTO &param : params)
+    {
+        auto it = std::find_if(values.begin(), values.end(), [&param](const RunParamValueDTO &value)
+                               { return value.key == param.key; });
+        if (it == values.end() && !param.defaultValue.isEmpty())
+        {
+            QString value;
+            QString error;
+            values.append(RunParamValueDTO{param.key, {normalizeValue(param, param.defaultValue, value, error) ? value : param.defaultValue}});
+            continue;
+        }
+        if (param.required && (it == values.end() || !hasValue(*it)))
+        {
+            errors << QStringLiteral("Missing required param %1").arg(param.key);
+        }
+    }
+    return errors.size() == errorsBefore;
+}
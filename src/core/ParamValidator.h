@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Checks run parameters against the tool's ParamDTO declarations, for
+// callers without a DynamicForm to constrain the input (batch sweeps, the
+// command-line runner).
+class ParamValidator
+{
+public:
+    // Checks one value and returns it in the form DynamicForm would produce
+    // (option value, "true"/"false", plain number).
+    static bool normalizeValue(const ParamDTO &param, const QString &raw, QString &value, QString &error);
+
+    // Normalizes values in place and fills in defaults for params that were
+    // not given. Reports unknown keys, missing required params, several
+    // values for a single-valued param, text not matching its pattern and
+    // file/dir params that do not exist. Returns true when errors is empty.
+    static bool validate(const QList<ParamDTO> &params, QList<RunParamValueDTO> &values, QStringList &errors);
+};
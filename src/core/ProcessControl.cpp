@@ -0,0 +1,168 @@
+#include "ProcessControl.h"
+
+#include <QLoggingCategory>
+#include <QProcess>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+Q_LOGGING_CATEGORY(logProcess, "core.process")
+
+#ifdef Q_OS_UNIX
+namespace
+{
+// Extra CPU seconds between SIGXCPU (soft limit) and SIGKILL (hard limit), so
+// a tool that handles SIGXCPU can still write out partial results.
+constexpr rlim_t kCpuGraceSeconds = 5;
+
+// Wraps program/args in `systemd-run --user --scope`: the scope is a cgroup v2
+// of its own, and systemd-run execs the command in place, so the QProcess pid
+// stays the tool's pid. Returns which limits the scope took over.
+bool wrapInScope(const LimitsDTO &limits, QString &program, QStringList &args, bool &memory, bool &tasks)
+{
+    const QString systemdRun = QStandardPaths::findExecutable(QStringLiteral("systemd-run"));
+    if (systemdRun.isEmpty())
+    {
+        qWarning(logProcess) << "limits.cgroup requested but systemd-run was not found; falling back to rlimits";
+        return false;
+    }
+
+    QStringList wrapped{QStringLiteral("--user"), QStringLiteral("--scope"), QStringLiteral("--quiet"), QStringLiteral("--collect")};
+    if (limits.memoryBytes > 0)
+    {
+        wrapped << QStringLiteral("-p") << QStringLiteral("MemoryMax=%1").arg(limits.memoryBytes);
+        wrapped << QStringLiteral("-p") << QStringLiteral("MemorySwapMax=0");
+        memory = true;
+    }
+    if (limits.processes > 0)
+    {
+        wrapped << QStringLiteral("-p") << QStringLiteral("TasksMax=%1").arg(limits.processes);
+        tasks = true;
+    }
+    if (limits.cpuCores > 0)
+    {
+        wrapped << QStringLiteral("-p") << QStringLiteral("CPUQuota=%1%").arg(qRound(limits.cpuCores * 100));
+    }
+    wrapped << QStringLiteral("--") << program << args;
+    program = systemdRun;
+    args = wrapped;
+    return true;
+}
+} // namespace
+#endif
+
+void ProcessControl::prepare(QProcess &process, const LimitsDTO &limits, QString &program, QStringList &args)
+{
+#ifdef Q_OS_UNIX
+    bool memoryInScope = false;
+    bool tasksInScope = false;
+    if (limits.cgroup && limits.any())
+    {
+        wrapInScope(limits, program, args, memoryInScope, tasksInScope);
+    }
+    else if (limits.cpuCores > 0)
+    {
+        qWarning(logProcess) << "limits.cpu_cores needs limits.cgroup; ignored";
+    }
+
+    const rlim_t cpu = static_cast<rlim_t>(qMax(0, limits.cpuSeconds));
+    // RLIMIT_AS caps address space, not RSS; runtimes that reserve large
+    // virtual ranges need headroom here, which is why the scope is preferred.
+    const rlim_t memory = memoryInScope ? 0 : static_cast<rlim_t>(qMax<qint64>(0, limits.memoryBytes));
+    const rlim_t files = static_cast<rlim_t>(qMax(0, limits.openFiles));
+    // RLIMIT_NPROC counts every process of the user, not just this run.
+    const rlim_t processes = tasksInScope ? 0 : static_cast<rlim_t>(qMax(0, limits.processes));
+
+    // Runs in the child between fork and exec: async-signal-safe calls only.
+    process.setChildProcessModifier([cpu, memory, files, processes]()
+                                    {
+        ::setpgid(0, 0);
+        struct rlimit limit;
+        if (cpu > 0)
+        {
+            limit.rlim_cur = cpu;
+            limit.rlim_max = cpu + kCpuGraceSeconds;
+            ::setrlimit(RLIMIT_CPU, &limit);
+        }
+        if (memory > 0)
+        {
+            limit.rlim_cur = limit.rlim_max = memory;
+            ::setrlimit(RLIMIT_AS, &limit);
+        }
+        if (files > 0)
+        {
+            limit.rlim_cur = limit.rlim_max = files;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+        if (processes > 0)
+        {
+            limit.rlim_cur = limit.rlim_max = processes;
+            ::setrlimit(RLIMIT_NPROC, &limit);
+        } });
+#else
+    Q_UNUSED(process);
+    Q_UNUSED(program);
+    Q_UNUSED(args);
+    if (limits.any())
+    {
+        qWarning(logProcess) << "Resource limits are not supported on this platform; only runtime.timeout applies";
+    }
+#endif
+}
+
+void ProcessControl::terminate(QProcess &process)
+{
+#ifdef Q_OS_UNIX
+    const qint64 pid = process.processId();
+    if (pid > 0 && ::kill(-static_cast<pid_t>(pid), SIGTERM) == 0)
+    {
+        // A suspended group only sees the SIGTERM once it runs again.
+        ::kill(-static_cast<pid_t>(pid), SIGCONT);
+        return;
+    }
+#endif
+    process.terminate();
+}
+
+void ProcessControl::kill(QProcess &process)
+{
+    const qint64 pid = process.processId();
+#ifdef Q_OS_UNIX
+    if (pid > 0 && ::kill(-static_cast<pid_t>(pid), SIGKILL) == 0)
+    {
+        return;
+    }
+#elif defined(Q_OS_WIN)
+    if (pid > 0)
+    {
+        QProcess::execute(QStringLiteral("taskkill"), {QStringLiteral("/T"), QStringLiteral("/F"), QStringLiteral("/PID"), QString::number(pid)});
+    }
+#endif
+    process.kill();
+}
+
+bool ProcessControl::suspend(QProcess &process)
+{
+#ifdef Q_OS_UNIX
+    const qint64 pid = process.processId();
+    return pid > 0 && ::kill(-static_cast<pid_t>(pid), SIGSTOP) == 0;
+#else
+    Q_UNUSED(process);
+    return false;
+#endif
+}
+
+bool ProcessControl::resume(QProcess &process)
+{
+#ifdef Q_OS_UNIX
+    const qint64 pid = process.processId();
+    return pid > 0 && ::kill(-static_cast<pid_t>(pid), SIGCONT) == 0;
+#else
+    Q_UNUSED(process);
+    return false;
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QString>
+#include <QStringList>
+
+class QProcess;
+
+// Process-tree handling and resource limits for tool runs. On Unix every run
+// gets its own process group, so stopping a run also reaches the children a
+// script spawned; on Windows the tree is killed with taskkill /T.
+class ProcessControl
+{
+public:
+    // Must be called before QProcess::start(). Installs the child setup
+    // (process group, rlimits) and, for limits.cgroup, rewrites program/args to
+    // start the run in a transient systemd scope with memory, task and CPU
+    // caps. Limits that cannot be applied on this platform are logged.
+    static void prepare(QProcess &process, const LimitsDTO &limits, QString &program, QStringList &args);
+
+    // Polite stop (SIGTERM to the group / WM_CLOSE) and forced stop.
+    static void terminate(QProcess &process);
+    static void kill(QProcess &process);
+
+    // Pauses and continues the run's process group (SIGSTOP / SIGCONT).
+    // Returns false where that is not supported (Windows).
+    static bool suspend(QProcess &process);
+    static bool resume(QProcess &process);
+};
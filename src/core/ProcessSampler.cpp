@@ -0,0 +1,222 @@
+#include "ProcessSampler.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QList>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef Q_OS_LINUX
+struct Stat
+{
+    qint64 processGroup{0};
+    qint64 userTicks{0};
+    qint64 systemTicks{0};
+    qint64 childUserTicks{0};
+    qint64 childSystemTicks{0};
+    qint64 startTime{0};
+    qint64 rssPages{0};
+};
+
+QByteArray readProcFile(const QString &path)
+{
+    QFile file(path);
+    // /proc files report size 0; read until EOF.
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+bool readStat(const QString &pidDir, Stat &stat)
+{
+    const QByteArray line = readProcFile(pidDir + QStringLiteral("/stat"));
+    // The command name (field 2) may itself contain spaces and ')'; the
+    // numeric fields start after the last ')'.
+    const qsizetype close = line.lastIndexOf(')');
+    if (close < 0)
+    {
+        return false;
+    }
+    const QList<QByteArray> fields = line.mid(close + 2).split(' ');
+    if (fields.size() < 22)
+    {
+        return false;
+    }
+    // fields[0] is field 3 (state) of proc(5).
+    stat.processGroup = fields.at(2).toLongLong();
+    stat.userTicks = fields.at(11).toLongLong();
+    stat.systemTicks = fields.at(12).toLongLong();
+    stat.childUserTicks = fields.at(13).toLongLong();
+    stat.childSystemTicks = fields.at(14).toLongLong();
+    stat.startTime = fields.at(19).toLongLong();
+    stat.rssPages = fields.at(21).toLongLong();
+    return true;
+}
+
+// "Key:   value [kB]" lines of /proc/<pid>/status and /proc/<pid>/io.
+qint64 fieldValue(const QByteArray &text, const QByteArray &key)
+{
+    const qsizetype at = text.startsWith(key) ? 0 : text.indexOf('\n' + key);
+    if (at < 0)
+    {
+        return -1;
+    }
+    const qsizetype start = at + key.size() + (at == 0 ? 0 : 1);
+    const qsizetype end = text.indexOf('\n', start);
+    QByteArray value = text.mid(start, end < 0 ? -1 : end - start).trimmed();
+    const bool kilobytes = value.endsWith(" kB");
+    if (kilobytes)
+    {
+        value.chop(3);
+    }
+    bool ok = false;
+    const qint64 number = value.trimmed().toLongLong(&ok);
+    return ok ? (kilobytes ? number * 1024 : number) : -1;
+}
+#endif
+} // namespace
+
+bool ProcessSampler::supported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ProcessSampler::watch(const QString &runId, qint64 processGroup)
+{
+    if (supported() && processGroup > 0)
+    {
+        m_trees.insert(runId, Tree{processGroup, {}, 0});
+    }
+}
+
+void ProcessSampler::sample()
+{
+#ifdef Q_OS_LINUX
+    if (m_trees.isEmpty())
+    {
+        return;
+    }
+    QHash<qint64, QString> runByGroup;
+    for (auto it = m_trees.cbegin(); it != m_trees.cend(); ++it)
+    {
+        runByGroup.insert(it->root, it.key());
+    }
+
+    static const qint64 pageSize = ::sysconf(_SC_PAGESIZE);
+    QHash<QString, qint64> liveRss;
+    const QStringList entries = QDir(QStringLiteral("/proc")).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::NoSort);
+    for (const QString &entry : entries)
+    {
+        bool isPid = false;
+        const qint64 pid = entry.toLongLong(&isPid);
+        if (!isPid)
+        {
+            continue;
+        }
+        const QString dir = QStringLiteral("/proc/") + entry;
+        Stat stat;
+        if (!readStat(dir, stat))
+        {
+            continue;
+        }
+        const auto run = runByGroup.constFind(stat.processGroup);
+        if (run == runByGroup.cend())
+        {
+            continue;
+        }
+
+        Tree &tree = m_trees[run.value()];
+        Process &process = tree.processes[qMakePair(pid, stat.startTime)];
+        process.userTicks = stat.userTicks;
+        process.systemTicks = stat.systemTicks;
+        if (pid == tree.root)
+        {
+            process.childUserTicks = stat.childUserTicks;
+            process.childSystemTicks = stat.childSystemTicks;
+        }
+        const qint64 rss = stat.rssPages * pageSize;
+        liveRss[run.value()] += rss;
+        process.peakRssBytes = qMax(process.peakRssBytes, rss);
+
+        const QByteArray status = readProcFile(dir + QStringLiteral("/status"));
+        process.peakRssBytes = qMax(process.peakRssBytes, fieldValue(status, "VmHWM:"));
+        process.voluntary = qMax(process.voluntary, fieldValue(status, "voluntary_ctxt_switches:"));
+        process.involuntary = qMax(process.involuntary, fieldValue(status, "nonvoluntary_ctxt_switches:"));
+
+        const QByteArray io = readProcFile(dir + QStringLiteral("/io"));
+        process.readBytes = qMax(process.readBytes, fieldValue(io, "read_bytes:"));
+        process.writeBytes = qMax(process.writeBytes, fieldValue(io, "write_bytes:"));
+    }
+
+    for (auto it = liveRss.cbegin(); it != liveRss.cend(); ++it)
+    {
+        Tree &tree = m_trees[it.key()];
+        tree.peakRssBytes = qMax(tree.peakRssBytes, it.value());
+    }
+#endif
+}
+
+RunMetricsDTO ProcessSampler::take(const QString &runId)
+{
+    RunMetricsDTO metrics;
+    const Tree tree = m_trees.take(runId);
+#ifdef Q_OS_LINUX
+    if (tree.processes.isEmpty())
+    {
+        return metrics;
+    }
+
+    // Two lower bounds per figure: the sum over every process seen, and the
+    // root's own counters, which the kernel credits with the CPU time and I/O
+    // of every child it reaped (sampled or not). Taking the larger avoids
+    // counting a reaped child twice.
+    qint64 user = 0;
+    qint64 system = 0;
+    qint64 readBytes = 0;
+    qint64 writeBytes = 0;
+    qint64 rootUser = 0;
+    qint64 rootSystem = 0;
+    qint64 rootRead = 0;
+    qint64 rootWrite = 0;
+    for (auto it = tree.processes.cbegin(); it != tree.processes.cend(); ++it)
+    {
+        const Process &process = it.value();
+        user += process.userTicks;
+        system += process.systemTicks;
+        metrics.voluntaryCtxSwitches += process.voluntary;
+        metrics.involuntaryCtxSwitches += process.involuntary;
+        metrics.peakRssBytes = qMax(metrics.peakRssBytes, process.peakRssBytes);
+        if (it.key().first == tree.root)
+        {
+            rootUser = process.userTicks + process.childUserTicks;
+            rootSystem = process.systemTicks + process.childSystemTicks;
+            rootRead = process.readBytes;
+            rootWrite = process.writeBytes;
+        }
+        else
+        {
+            readBytes += process.readBytes;
+            writeBytes += process.writeBytes;
+        }
+    }
+
+    static const double msPerTick = 1000.0 / static_cast<double>(::sysconf(_SC_CLK_TCK));
+    metrics.userCpuMs = qRound64(static_cast<double>(qMax(user, rootUser)) * msPerTick);
+    metrics.systemCpuMs = qRound64(static_cast<double>(qMax(system, rootSystem)) * msPerTick);
+    metrics.readBytes = qMax(readBytes, rootRead);
+    metrics.writeBytes = qMax(writeBytes, rootWrite);
+    metrics.peakRssBytes = qMax(metrics.peakRssBytes, tree.peakRssBytes);
+    metrics.processes = static_cast<int>(tree.processes.size());
+    metrics.sampled = true;
+#else
+    Q_UNUSED(tree);
+#endif
+    return metrics;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+
+// Accounts the resources of running process trees by polling /proc. A tree
+// is the process group a run was started in (see ProcessControl), so the
+// tool's children are included as long as they do not leave the group.
+//
+// Figures are sampled: a child that starts and exits between two samples is
+// missed, except where the kernel folds it into its parent's counters (CPU
+// time and I/O of reaped children). Does nothing outside Linux.
+class ProcessSampler
+{
+public:
+    static bool supported();
+
+    void watch(const QString &runId, qint64 processGroup);
+    bool isEmpty() const { return m_trees.isEmpty(); }
+    // One pass over /proc for all watched trees.
+    void sample();
+    // Stops watching and returns what was collected; wallMs is left to the caller.
+    RunMetricsDTO take(const QString &runId);
+
+private:
+    struct Process
+    {
+        qint64 userTicks{0};
+        qint64 systemTicks{0};
+        qint64 childUserTicks{0}; // reaped children, root process only
+        qint64 childSystemTicks{0};
+        qint64 voluntary{0};
+        qint64 involuntary{0};
+        qint64 readBytes{0};
+        qint64 writeBytes{0};
+        qint64 peakRssBytes{0};
+    };
+
+    struct Tree
+    {
+        qint64 root{0};
+        QHash<QPair<qint64, qint64>, Process> processes; // (pid, start time)
+        qint64 peakRssBytes{0};                          // largest sum over live members
+    };
+
+    QHash<QString, Tree> m_trees;
+};
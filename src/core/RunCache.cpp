@@ -0,0 +1,351 @@
+#include "RunCache.h"
+
+#include "core/ToolManifest.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QUuid>
+
+#include <algorithm>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+Q_LOGGING_CATEGORY(logRunCache, "core.runcache")
+
+namespace
+{
+// Bump when the key composition changes so old entries stop matching.
+constexpr int kKeyFormat = 1;
+const QStringList kCachedDirs{QStringLiteral("outputs"), QStringLiteral("logs")};
+
+void addField(QCryptographicHash &hash, const char *name, const QByteArray &value)
+{
+    // Length-prefixed so that adjacent fields cannot run into each other.
+    hash.addData(QByteArray(name) + ':' + QByteArray::number(value.size()) + ':');
+    hash.addData(value);
+}
+
+QByteArray hashFile(const QString &path)
+{
+    QFile file(path);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file))
+    {
+        return QByteArray();
+    }
+    return hash.result();
+}
+
+// Contents of a file, or of every file below a directory in path order;
+// a missing path contributes its name only.
+QByteArray hashPath(const QString &path)
+{
+    const QFileInfo info(path);
+    if (info.isFile())
+    {
+        return hashFile(path);
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!info.isDir())
+    {
+        addField(hash, "missing", path.toUtf8());
+        return hash.result();
+    }
+    const QDir base(path);
+    QStringList files;
+    QDirIterator it(path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        files << base.relativeFilePath(it.next());
+    }
+    files.sort();
+    for (const QString &relative : std::as_const(files))
+    {
+        addField(hash, "name", relative.toUtf8());
+        addField(hash, "data", hashFile(base.filePath(relative)));
+    }
+    return hash.result();
+}
+
+// Stable form of the inputs that determine the environment, as the design
+// document specifies for .env_hash: runtime type, strategy, interpreter,
+// sorted lower-cased dependencies and the setup command.
+QByteArray envFingerprint(const ToolDTO &tool)
+{
+    QStringList dependencies;
+    for (const QString &dependency : tool.env.dependencies)
+    {
+        dependencies << dependency.trimmed().toLower();
+    }
+    dependencies.sort();
+    const QStringList lines{tool.runtime.type.toLower(), tool.env.strategy.toLower(), tool.env.interpreterPath,
+                            dependencies.join(QLatin1Char('\n')), tool.env.setup.command};
+    return lines.join(QLatin1Char('\n')).toUtf8();
+}
+
+bool cloneFile(const QString &from, const QString &to, bool allowHardLink)
+{
+#ifdef Q_OS_LINUX
+    // Copy-on-write clone (btrfs, XFS): independent files that share blocks.
+    const int source = ::open(QFile::encodeName(from).constData(), O_RDONLY | O_CLOEXEC);
+    if (source >= 0)
+    {
+        const int target = ::open(QFile::encodeName(to).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        const bool cloned = target >= 0 && ::ioctl(target, FICLONE, source) == 0;
+        if (target >= 0)
+        {
+            ::close(target);
+            if (!cloned)
+            {
+                ::unlink(QFile::encodeName(to).constData());
+            }
+        }
+        ::close(source);
+        if (cloned)
+        {
+            return true;
+        }
+    }
+#endif
+    if (allowHardLink)
+    {
+#if defined(Q_OS_UNIX)
+        if (::link(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0)
+        {
+            return true;
+        }
+#elif defined(Q_OS_WIN)
+        if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()),
+                            reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()), nullptr))
+        {
+            return true;
+        }
+#endif
+    }
+    return QFile::copy(from, to);
+}
+
+// Mirrors every file below from into to. Returns the bytes placed, or -1.
+qint64 cloneTree(const QString &from, const QString &to, bool allowHardLink, bool readOnly)
+{
+    if (!QFileInfo(from).isDir())
+    {
+        return 0;
+    }
+    const QDir source(from);
+    const QDir target(to);
+    qint64 bytes = 0;
+    QDirIterator it(from, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        const QString path = it.next();
+        const QString relative = source.relativeFilePath(path);
+        const QString destination = target.filePath(relative);
+        if (!QDir().mkpath(QFileInfo(destination).absolutePath()))
+        {
+            return -1;
+        }
+        QFile::remove(destination);
+        if (!cloneFile(path, destination, allowHardLink))
+        {
+            qWarning(logRunCache) << "Cannot place" << path << "at" << destination;
+            return -1;
+        }
+        if (readOnly)
+        {
+            QFile::setPermissions(destination, QFileDevice::ReadOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther);
+        }
+        bytes += it.fileInfo().size();
+    }
+    return bytes;
+}
+
+QJsonObject readEntry(const QString &entryDir)
+{
+    QFile file(QDir(entryDir).filePath(QStringLiteral("entry.json")));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void touchEntry(const QString &entryDir)
+{
+    QFile file(QDir(entryDir).filePath(QStringLiteral("entry.json")));
+    if (file.open(QIODevice::ReadWrite))
+    {
+        file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    }
+}
+} // namespace
+
+QString RunCache::cacheRoot(const QString &toolsRoot)
+{
+    return QDir(toolsRoot).filePath(QStringLiteral("runs/.cache"));
+}
+
+QString RunCache::computeKey(const KeyInput &input)
+{
+    const ToolDTO &tool = *input.tool;
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    addField(hash, "format", QByteArray::number(kKeyFormat));
+    addField(hash, "tool", tool.id.toUtf8());
+    addField(hash, "version", tool.version.toUtf8());
+    addField(hash, "manifest", hashFile(ToolManifest::manifestPath(input.toolDir)));
+    addField(hash, "entry", hashPath(QDir(input.toolDir).filePath(tool.runtime.entry)));
+    addField(hash, "env", envFingerprint(tool));
+    addField(hash, "envPath", input.envPath.toUtf8());
+    for (const QString &arg : input.args)
+    {
+        addField(hash, "arg", arg.toUtf8());
+    }
+
+    for (const ParamDTO &param : tool.params)
+    {
+        if (param.type != ParamType::File && param.type != ParamType::Dir)
+        {
+            continue;
+        }
+        for (const RunParamValueDTO &value : input.params)
+        {
+            if (value.key != param.key)
+            {
+                continue;
+            }
+            addField(hash, "param", param.key.toUtf8());
+            for (const QString &path : value.values)
+            {
+                addField(hash, "content", hashPath(path));
+            }
+        }
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool RunCache::restore(const QString &cacheRoot, const QString &key, const QString &runDirectory, QJsonObject &entry)
+{
+    const QString entryDir = QDir(cacheRoot).filePath(key);
+    entry = readEntry(entryDir);
+    if (entry.isEmpty())
+    {
+        return false;
+    }
+    for (const QString &dir : kCachedDirs)
+    {
+        if (cloneTree(QDir(entryDir).filePath(dir), QDir(runDirectory).filePath(dir), true, false) < 0)
+        {
+            // Evicted underneath us, or unreadable: treat as a miss.
+            return false;
+        }
+    }
+    touchEntry(entryDir);
+    qInfo(logRunCache) << "Restored" << key << "into" << runDirectory;
+    return true;
+}
+
+bool RunCache::store(const QString &cacheRoot, const QString &key, const QString &runDirectory, QJsonObject entry, qint64 maxBytes)
+{
+    const QDir root(cacheRoot);
+    if (!root.mkpath(QStringLiteral(".")))
+    {
+        return false;
+    }
+    const QString target = root.filePath(key);
+    if (QFileInfo::exists(target))
+    {
+        touchEntry(target);
+        return true;
+    }
+
+    // Assemble under a private name and rename into place, so concurrent
+    // stores of the same key and concurrent lookups never see a partial entry.
+    const QString staging = root.filePath(QStringLiteral(".tmp-%1-%2").arg(key, QUuid::createUuid().toString(QUuid::Id128)));
+    qint64 bytes = 0;
+    for (const QString &dir : kCachedDirs)
+    {
+        const qint64 placed = cloneTree(QDir(runDirectory).filePath(dir), QDir(staging).filePath(dir), false, true);
+        if (placed < 0)
+        {
+            QDir(staging).removeRecursively();
+            return false;
+        }
+        bytes += placed;
+    }
+    entry.insert(QStringLiteral("bytes"), bytes);
+    entry.insert(QStringLiteral("storedAt"), QDateTime::currentDateTime().toString(Qt::ISODate));
+    QFile file(QDir(staging).filePath(QStringLiteral("entry.json")));
+    if (!QDir().mkpath(staging) || !file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(entry).toJson()) < 0)
+    {
+        QDir(staging).removeRecursively();
+        return false;
+    }
+    file.close();
+
+    if (!root.rename(QFileInfo(staging).fileName(), key))
+    {
+        QDir(staging).removeRecursively();
+        return QFileInfo::exists(target);
+    }
+    qInfo(logRunCache) << "Stored" << key << bytes << "bytes from" << runDirectory;
+    evict(cacheRoot, maxBytes);
+    return true;
+}
+
+void RunCache::evict(const QString &cacheRoot, qint64 maxBytes)
+{
+    struct Entry
+    {
+        QString path;
+        QDateTime lastUsed;
+        qint64 bytes{0};
+    };
+    QList<Entry> entries;
+    qint64 total = 0;
+    const QFileInfoList dirs = QDir(cacheRoot).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo &dir : dirs)
+    {
+        if (dir.fileName().startsWith(QLatin1Char('.')))
+        {
+            continue;
+        }
+        const QFileInfo entryFile(QDir(dir.filePath()).filePath(QStringLiteral("entry.json")));
+        Entry entry{dir.filePath(), entryFile.lastModified(), readEntry(dir.filePath()).value(QStringLiteral("bytes")).toInteger()};
+        total += entry.bytes;
+        entries.append(entry);
+    }
+    if (total <= maxBytes)
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+              { return a.lastUsed < b.lastUsed; });
+    for (const Entry &entry : std::as_const(entries))
+    {
+        if (total <= maxBytes)
+        {
+            break;
+        }
+        if (QDir(entry.path).removeRecursively())
+        {
+            total -= entry.bytes;
+            qInfo(logRunCache) << "Evicted" << entry.path << entry.bytes << "bytes";
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Content-addressed store of successful run results for tools that opt in
+// with runtime.cache. An entry lives in <toolsRoot>/runs/.cache/<key>/ -- on
+// the same filesystem as the run directories, so a hit can be hard-linked --
+// and holds outputs/, logs/ and entry.json, whose mtime is the LRU clock.
+// Cached files are read-only: a hard-linked result cannot be edited in place
+// and silently change the cache.
+// All of it is blocking file I/O meant for a pool thread.
+class RunCache
+{
+public:
+    struct KeyInput
+    {
+        ToolHandle tool;
+        QString toolDir;
+        QString envPath;
+        QStringList args; // expanded, with run paths replaced by their placeholders
+        QList<RunParamValueDTO> params;
+    };
+
+    static QString cacheRoot(const QString &toolsRoot);
+    // SHA-256 over tool id/version, tool.yaml, the entry script, the env
+    // fingerprint, the expanded args and the contents of file/dir params.
+    static QString computeKey(const KeyInput &input);
+    // Reflinks, hard-links or copies a cached result into runDirectory and
+    // returns its entry.json; false on a miss.
+    static bool restore(const QString &cacheRoot, const QString &key, const QString &runDirectory, QJsonObject &entry);
+    // Copies outputs/ and logs/ of a finished run into the cache (reflinked
+    // where the filesystem allows), then evicts least recently used entries
+    // until the cache fits maxBytes.
+    static bool store(const QString &cacheRoot, const QString &key, const QString &runDirectory, QJsonObject entry, qint64 maxBytes);
+    static void evict(const QString &cacheRoot, qint64 maxBytes);
+};
@@ -0,0 +1,161 @@
+#include "RunHistory.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+Q_LOGGING_CATEGORY(logHistory, "core.history")
+
+namespace
+{
+constexpr int kHistoryFormat = 1;
+// Weight of the newest run; recent runs dominate after a handful of samples
+// without a single outlier swinging the estimate.
+constexpr double kSmoothing = 0.3;
+} // namespace
+
+bool RunHistory::load(const QString &filePath)
+{
+    m_filePath = filePath;
+    m_stats.clear();
+    m_dirty = false;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject())
+    {
+        qWarning(logHistory) << "Ignoring unreadable run history" << filePath << parseError.errorString();
+        return false;
+    }
+    const QJsonObject root = doc.object();
+    if (root.value(QStringLiteral("format")).toInt() != kHistoryFormat)
+    {
+        return false;
+    }
+
+    const QJsonObject tools = root.value(QStringLiteral("tools")).toObject();
+    for (auto it = tools.constBegin(); it != tools.constEnd(); ++it)
+    {
+        const QJsonObject entry = it.value().toObject();
+        Stats stats;
+        stats.averageMs = entry.value(QStringLiteral("averageMs")).toDouble();
+        stats.lastMs = entry.value(QStringLiteral("lastMs")).toInteger();
+        stats.runs = entry.value(QStringLiteral("runs")).toInt();
+        if (stats.runs > 0 && stats.averageMs >= 0)
+        {
+            m_stats.insert(it.key(), stats);
+        }
+    }
+    return true;
+}
+
+bool RunHistory::save()
+{
+    if (m_filePath.isEmpty())
+    {
+        m_filePath = defaultFilePath();
+    }
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+
+    QJsonObject tools;
+    for (auto it = m_stats.cbegin(); it != m_stats.cend(); ++it)
+    {
+        QJsonObject entry;
+        entry.insert(QStringLiteral("averageMs"), it->averageMs);
+        entry.insert(QStringLiteral("lastMs"), it->lastMs);
+        entry.insert(QStringLiteral("runs"), it->runs);
+        tools.insert(it.key(), entry);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("format"), kHistoryFormat);
+    root.insert(QStringLiteral("tools"), tools);
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning(logHistory) << "Cannot write run history" << m_filePath << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+    {
+        qWarning(logHistory) << "Failed to commit run history" << m_filePath << file.errorString();
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+void RunHistory::record(const QString &toolId, const QString &version, qint64 durationMs)
+{
+    if (toolId.isEmpty() || durationMs < 0)
+    {
+        return;
+    }
+    update(keyFor(toolId, version), durationMs);
+    update(toolId, durationMs);
+    m_dirty = true;
+}
+
+qint64 RunHistory::estimate(const QString &toolId, const QString &version) const
+{
+    auto it = m_stats.constFind(keyFor(toolId, version));
+    if (it == m_stats.cend())
+    {
+        it = m_stats.constFind(toolId);
+    }
+    return it == m_stats.cend() ? -1 : qRound64(it->averageMs);
+}
+
+qint64 RunHistory::typicalDuration() const
+{
+    double total = 0;
+    int tools = 0;
+    for (auto it = m_stats.cbegin(); it != m_stats.cend(); ++it)
+    {
+        if (!it.key().contains(QLatin1Char('@')))
+        {
+            total += it->averageMs;
+            ++tools;
+        }
+    }
+    return tools == 0 ? -1 : qRound64(total / tools);
+}
+
+RunHistory::Stats RunHistory::stats(const QString &toolId, const QString &version) const
+{
+    return m_stats.value(version.isEmpty() ? toolId : keyFor(toolId, version));
+}
+
+QString RunHistory::defaultFilePath()
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (base.isEmpty())
+    {
+        base = QDir::temp().filePath(QStringLiteral("ScriptToolbox"));
+    }
+    return QDir(base).filePath(QStringLiteral("run_history.json"));
+}
+
+QString RunHistory::keyFor(const QString &toolId, const QString &version)
+{
+    return toolId + QLatin1Char('@') + version;
+}
+
+void RunHistory::update(const QString &key, qint64 durationMs)
+{
+    Stats &stats = m_stats[key];
+    stats.averageMs = stats.runs == 0 ? durationMs : kSmoothing * durationMs + (1.0 - kSmoothing) * stats.averageMs;
+    stats.lastMs = durationMs;
+    ++stats.runs;
+}
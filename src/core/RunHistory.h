@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+// Per-tool record of how long successful runs took, used to estimate queued
+// work. Durations are kept as an exponentially weighted moving average per
+// tool id and version (plus one per tool id as a fallback for new versions)
+// and persisted as a small JSON file in the application data directory.
+class RunHistory
+{
+public:
+    struct Stats
+    {
+        double averageMs{0};
+        qint64 lastMs{0};
+        int runs{0};
+    };
+
+    RunHistory() = default;
+
+    bool load(const QString &filePath = defaultFilePath());
+    bool save();
+    bool isDirty() const { return m_dirty; }
+
+    void record(const QString &toolId, const QString &version, qint64 durationMs);
+    // Expected duration of the next run, or -1 when the tool has never
+    // completed a run.
+    qint64 estimate(const QString &toolId, const QString &version) const;
+    // Mean of all per-tool averages; -1 when nothing has been recorded.
+    qint64 typicalDuration() const;
+    Stats stats(const QString &toolId, const QString &version = QString()) const;
+
+    static QString defaultFilePath();
+
+private:
+    static QString keyFor(const QString &toolId, const QString &version);
+    void update(const QString &key, qint64 durationMs);
+
+    QString m_filePath;
+    QHash<QString, Stats> m_stats; // "<id>@<version>" and "<id>"
+    bool m_dirty{false};
+};
@@ -0,0 +1,82 @@
+#include "RunMetadata.h"
+
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QSaveFile>
+
+Q_LOGGING_CATEGORY(logMetadata, "core.metadata")
+
+namespace
+{
+bool writeFile(const QString &path, const QByteArray &content)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning(logMetadata) << "Cannot write" << path << file.errorString();
+        return false;
+    }
+    file.write(content);
+    return file.commit();
+}
+} // namespace
+
+QJsonObject RunMetadata::paramsToJson(const QList<RunParamValueDTO> &params)
+{
+    QJsonObject obj;
+    for (const RunParamValueDTO &param : params)
+    {
+        obj.insert(param.key, param.values.size() == 1 ? QJsonValue(param.values.first()) : QJsonValue(QJsonArray::fromStringList(param.values)));
+    }
+    return obj;
+}
+
+QJsonObject RunMetadata::metricsToJson(const RunMetricsDTO &metrics)
+{
+    QJsonObject obj;
+    obj.insert(QStringLiteral("wallMs"), metrics.wallMs);
+    if (!metrics.sampled)
+    {
+        return obj;
+    }
+    obj.insert(QStringLiteral("userCpuMs"), metrics.userCpuMs);
+    obj.insert(QStringLiteral("systemCpuMs"), metrics.systemCpuMs);
+    obj.insert(QStringLiteral("peakRssBytes"), metrics.peakRssBytes);
+    obj.insert(QStringLiteral("voluntaryContextSwitches"), metrics.voluntaryCtxSwitches);
+    obj.insert(QStringLiteral("involuntaryContextSwitches"), metrics.involuntaryCtxSwitches);
+    obj.insert(QStringLiteral("readBytes"), metrics.readBytes);
+    obj.insert(QStringLiteral("writeBytes"), metrics.writeBytes);
+    obj.insert(QStringLiteral("processes"), metrics.processes);
+    return obj;
+}
+
+QJsonObject RunMetadata::batchRunToJson(const BatchRunResultDTO &run)
+{
+    QJsonObject obj;
+    obj.insert(QStringLiteral("runId"), run.runId);
+    obj.insert(QStringLiteral("params"), paramsToJson(run.params));
+    obj.insert(QStringLiteral("status"), run.status);
+    obj.insert(QStringLiteral("exitCode"), run.exitCode);
+    obj.insert(QStringLiteral("message"), run.message);
+    obj.insert(QStringLiteral("durationMs"), run.durationMs);
+    obj.insert(QStringLiteral("runDirectory"), run.runDirectory);
+    return obj;
+}
+
+bool RunMetadata::writeMetadata(const QString &runDirectory, const QJsonObject &metadata)
+{
+    return writeFile(QDir(runDirectory).filePath(QStringLiteral("metadata.json")), QJsonDocument(metadata).toJson(QJsonDocument::Indented));
+}
+
+bool RunMetadata::writeCommand(const QString &runDirectory, const QString &commandLine)
+{
+    return writeFile(QDir(runDirectory).filePath(QStringLiteral("command.txt")), commandLine.toUtf8() + '\n');
+}
+
+bool RunMetadata::writeLog(const QString &runDirectory, const QString &fileName, const QStringList &lines)
+{
+    QDir(runDirectory).mkpath(QStringLiteral("logs"));
+    return writeFile(QDir(runDirectory).filePath(QStringLiteral("logs/") + fileName), lines.join(QLatin1Char('\n')).toUtf8() + '\n');
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+// Files describing a run inside its run directory: command.txt (the command
+// line as started) and metadata.json (parameters, timing, exit status and
+// resource use). Both are replaced atomically.
+class RunMetadata
+{
+public:
+    static QJsonObject paramsToJson(const QList<RunParamValueDTO> &params);
+    static QJsonObject metricsToJson(const RunMetricsDTO &metrics);
+    // One run of a batch summary.
+    static QJsonObject batchRunToJson(const BatchRunResultDTO &run);
+
+    static bool writeMetadata(const QString &runDirectory, const QJsonObject &metadata);
+    static bool writeCommand(const QString &runDirectory, const QString &commandLine);
+    // Small logs written in one go, for runs without a process of their own.
+    static bool writeLog(const QString &runDirectory, const QString &fileName, const QStringList &lines);
+};
@@ -0,0 +1,106 @@
+#include "RunProgress.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+QString RunProgress::linePrefix()
+{
+    return QStringLiteral("##toolbox:");
+}
+
+bool RunProgress::apply(const QString &report, qint64 elapsedMs, RunProgressDTO &progress)
+{
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(report.toUtf8(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject())
+    {
+        return false;
+    }
+    const QJsonObject obj = doc.object();
+
+    if (obj.value(QStringLiteral("done")).isDouble())
+    {
+        progress.done = qMax<qint64>(0, qint64(obj.value(QStringLiteral("done")).toDouble()));
+    }
+    if (obj.value(QStringLiteral("total")).isDouble())
+    {
+        progress.total = qMax<qint64>(0, qint64(obj.value(QStringLiteral("total")).toDouble()));
+    }
+    if (obj.value(QStringLiteral("progress")).isDouble())
+    {
+        progress.fraction = qBound(0.0, obj.value(QStringLiteral("progress")).toDouble(), 1.0);
+    }
+    else if (obj.contains(QStringLiteral("done")) && progress.done >= 0 && progress.total > 0)
+    {
+        progress.fraction = qBound(0.0, double(progress.done) / double(progress.total), 1.0);
+    }
+
+    const QJsonValue stage = obj.value(QStringLiteral("stage"));
+    if (stage.isString() && stage.toString() != progress.stage)
+    {
+        progress.stage = stage.toString();
+        if (progress.stages.size() < kMaxStages)
+        {
+            progress.stages.append({progress.stage, elapsedMs});
+        }
+    }
+    const QJsonValue message = obj.value(QStringLiteral("message"));
+    if (message.isString())
+    {
+        progress.message = message.toString();
+    }
+    const QJsonObject counters = obj.value(QStringLiteral("counters")).toObject();
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it)
+    {
+        if (it.value().isDouble())
+        {
+            progress.counters.insert(it.key(), it.value().toDouble());
+        }
+    }
+    return true;
+}
+
+QJsonObject RunProgress::toJson(const RunProgressDTO &progress)
+{
+    QJsonObject obj;
+    if (progress.fraction >= 0)
+    {
+        obj.insert(QStringLiteral("fraction"), progress.fraction);
+    }
+    if (progress.done >= 0)
+    {
+        obj.insert(QStringLiteral("done"), progress.done);
+    }
+    if (progress.total >= 0)
+    {
+        obj.insert(QStringLiteral("total"), progress.total);
+    }
+    if (!progress.stage.isEmpty())
+    {
+        obj.insert(QStringLiteral("stage"), progress.stage);
+    }
+    if (!progress.message.isEmpty())
+    {
+        obj.insert(QStringLiteral("message"), progress.message);
+    }
+    if (!progress.counters.isEmpty())
+    {
+        QJsonObject counters;
+        for (auto it = progress.counters.cbegin(); it != progress.counters.cend(); ++it)
+        {
+            counters.insert(it.key(), it.value());
+        }
+        obj.insert(QStringLiteral("counters"), counters);
+    }
+    if (!progress.stages.isEmpty())
+    {
+        QJsonArray stages;
+        for (const auto &[name, atMs] : progress.stages)
+        {
+            stages.append(QJsonObject{{QStringLiteral("stage"), name}, {QStringLiteral("atMs"), atMs}});
+        }
+        obj.insert(QStringLiteral("stages"), stages);
+    }
+    return obj;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QJsonObject>
+#include <QString>
+
+// Progress side channel of a run. A script reports progress by printing a
+// line that starts with linePrefix() followed by a JSON object, to stdout or
+// stderr:
+//
+//   ##toolbox:{"progress":0.25,"done":250,"total":1000,"stage":"fit",
+//              "message":"..","counters":{"loss":0.31}}
+//
+// Every field is optional; a report updates only what it names. Without
+// "progress", the fraction follows from done/total. These lines reach the run's
+// log files but not its output in the UI. Scripts see TOOLBOX_PROGRESS=1 when
+// the channel is read; tools/_lib has helpers for Python and R.
+class RunProgress
+{
+public:
+    // Stage markers kept per run; later stage changes only update "stage".
+    static constexpr int kMaxStages = 256;
+
+    static QString linePrefix();
+
+    // Folds one report (the line without its prefix) into progress. Returns
+    // false for lines that are not a JSON object.
+    static bool apply(const QString &report, qint64 elapsedMs, RunProgressDTO &progress);
+
+    static QJsonObject toJson(const RunProgressDTO &progress);
+};
@@ -0,0 +1,259 @@
+#include "ShardPlanner.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+namespace
+{
+constexpr qint64 kScanBlock = 1 << 20;
+constexpr qint64 kCopyBlock = 4 << 20;
+
+// First offset >= from that starts a record: the byte before it is '\n' and
+// the line begins with prefix. Returns size when there is none.
+qint64 nextRecordStart(QFile &file, qint64 from, qint64 size, const QByteArray &prefix)
+{
+    // Start one byte early so a record beginning exactly at `from` is found.
+    qint64 pos = qMax<qint64>(0, from - 1);
+    while (pos < size)
+    {
+        if (!file.seek(pos))
+        {
+            return size;
+        }
+        // Over-read by the prefix length so a prefix straddling two blocks is
+        // still compared in one piece; newlines in the overlap are handled by
+        // the next block.
+        const QByteArray block = file.read(kScanBlock + prefix.size());
+        if (block.isEmpty())
+        {
+            return size;
+        }
+        const bool lastBlock = pos + block.size() >= size;
+        const qsizetype limit = lastBlock ? block.size() : kScanBlock;
+        for (qsizetype i = block.indexOf('\n'); i >= 0 && i < limit; i = block.indexOf('\n', i + 1))
+        {
+            const qint64 candidate = pos + i + 1;
+            if (candidate >= size)
+            {
+                return size;
+            }
+            if (candidate >= from && (prefix.isEmpty() || QByteArrayView(block).sliced(i + 1).startsWith(prefix)))
+            {
+                return candidate;
+            }
+        }
+        if (lastBlock)
+        {
+            return size;
+        }
+        pos += kScanBlock;
+    }
+    return size;
+}
+
+// Same heuristic as git: a NUL byte near the start means binary.
+bool looksLikeText(QFile &file)
+{
+    return !file.peek(8000).contains('\0');
+}
+
+bool copyRange(QFile &source, qint64 offset, qint64 length, QFile &target)
+{
+    if (!source.seek(offset))
+    {
+        return false;
+    }
+    qint64 remaining = length;
+    while (remaining > 0)
+    {
+        const QByteArray chunk = source.read(qMin(remaining, kCopyBlock));
+        if (chunk.isEmpty() || target.write(chunk) != chunk.size())
+        {
+            return false;
+        }
+        remaining -= chunk.size();
+    }
+    return true;
+}
+
+bool isCompressed(const QString &path)
+{
+    static const QStringList suffixes{QStringLiteral("gz"), QStringLiteral("bz2"), QStringLiteral("xz"), QStringLiteral("zst"), QStringLiteral("zip")};
+    return suffixes.contains(QFileInfo(path).suffix().toLower());
+}
+} // namespace
+
+bool ShardPlanner::plan(const QString &path, const ShardConfigDTO &config, int maxShards, Plan &plan, QString &error)
+{
+    plan = Plan{};
+    plan.source = path;
+    if (isCompressed(path))
+    {
+        error = QStringLiteral("Compressed input cannot be split on record boundaries: %1").arg(path);
+        return false;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QStringLiteral("Cannot open shard input %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    const qint64 size = file.size();
+
+    qint64 dataStart = 0;
+    if (config.header)
+    {
+        plan.header = file.readLine();
+        dataStart = plan.header.size();
+        if (!plan.header.endsWith('\n'))
+        {
+            plan.header.append('\n');
+        }
+    }
+
+    const qint64 dataBytes = size - dataStart;
+    const qint64 minBytes = qMax<qint64>(1, config.minShardBytes);
+    const int shards = static_cast<int>(qMin<qint64>(qMax(1, maxShards), dataBytes / minBytes));
+    if (shards < 2)
+    {
+        plan.ranges.append(Range{dataStart, dataBytes});
+        return true;
+    }
+
+    const QByteArray prefix = config.recordStart.toUtf8();
+    qint64 previous = dataStart;
+    for (int k = 1; k < shards; ++k)
+    {
+        const qint64 target = dataStart + dataBytes * k / shards;
+        if (target <= previous)
+        {
+            continue;
+        }
+        const qint64 boundary = nextRecordStart(file, target, size, prefix);
+        if (boundary <= previous || boundary >= size)
+        {
+            continue;
+        }
+        plan.ranges.append(Range{previous, boundary - previous});
+        previous = boundary;
+    }
+    plan.ranges.append(Range{previous, size - previous});
+    return true;
+}
+
+bool ShardPlanner::split(const Plan &plan, const QString &outputDir, QStringList &files, QString &error)
+{
+    files.clear();
+    if (!QDir().mkpath(outputDir))
+    {
+        error = QStringLiteral("Cannot create shard directory %1").arg(outputDir);
+        return false;
+    }
+
+    QFile source(plan.source);
+    if (!source.open(QIODevice::ReadOnly))
+    {
+        error = QStringLiteral("Cannot open shard input %1: %2").arg(plan.source, source.errorString());
+        return false;
+    }
+
+    // Keep the extension so tools that sniff the format still recognise it.
+    const QString suffix = QFileInfo(plan.source).completeSuffix();
+    const int width = qMax(3, static_cast<int>(QString::number(plan.ranges.size()).size()));
+    for (qsizetype i = 0; i < plan.ranges.size(); ++i)
+    {
+        const QString name = QStringLiteral("part-%1").arg(i + 1, width, 10, QLatin1Char('0')) + (suffix.isEmpty() ? QString() : QLatin1Char('.') + suffix);
+        const QString path = QDir(outputDir).filePath(name);
+        QFile target(path);
+        if (!target.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            error = QStringLiteral("Cannot write shard %1: %2").arg(path, target.errorString());
+            return false;
+        }
+        const Range &range = plan.ranges.at(i);
+        if ((!plan.header.isEmpty() && target.write(plan.header) != plan.header.size()) || !copyRange(source, range.offset, range.length, target))
+        {
+            error = QStringLiteral("Failed to write shard %1: %2").arg(path, target.errorString());
+            return false;
+        }
+        files << path;
+    }
+    return true;
+}
+
+bool ShardPlanner::concatenate(const QStringList &shardOutputDirs, const QString &outputDir, bool skipHeader, QString &error)
+{
+    // Relative path -> whether what was written so far ends mid-line.
+    QHash<QString, bool> started;
+    for (qsizetype shard = 0; shard < shardOutputDirs.size(); ++shard)
+    {
+        const QString &shardDir = shardOutputDirs.at(shard);
+        const QDir base(shardDir);
+        QStringList relativePaths;
+        QDirIterator it(shardDir, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            relativePaths << base.relativeFilePath(it.next());
+        }
+        relativePaths.sort();
+
+        for (const QString &relative : std::as_const(relativePaths))
+        {
+            QFile source(base.filePath(relative));
+            if (!source.open(QIODevice::ReadOnly))
+            {
+                error = QStringLiteral("Cannot read %1").arg(source.fileName());
+                return false;
+            }
+            if (!looksLikeText(source))
+            {
+                // Appending images or archives would only corrupt them; keep
+                // each shard's copy instead.
+                const QString targetPath = QDir(outputDir).filePath(QStringLiteral("shard-%1/%2").arg(shard + 1).arg(relative));
+                QDir().mkpath(QFileInfo(targetPath).absolutePath());
+                QFile::remove(targetPath);
+                if (!source.copy(targetPath))
+                {
+                    error = QStringLiteral("Cannot copy %1 to %2").arg(source.fileName(), targetPath);
+                    return false;
+                }
+                continue;
+            }
+
+            const QString targetPath = QDir(outputDir).filePath(relative);
+            const bool first = !started.contains(relative);
+            QDir().mkpath(QFileInfo(targetPath).absolutePath());
+            QFile target(targetPath);
+            if (!target.open(first ? (QIODevice::WriteOnly | QIODevice::Truncate) : QIODevice::Append))
+            {
+                error = QStringLiteral("Cannot merge %1 into %2").arg(source.fileName(), targetPath);
+                return false;
+            }
+            qint64 offset = 0;
+            if (skipHeader && !first)
+            {
+                offset = source.readLine().size();
+            }
+            const qint64 length = source.size() - offset;
+            // Keep the previous shard's last record off this one's first.
+            const bool openLine = !first && started.value(relative) && length > 0;
+            if ((openLine && target.write("\n", 1) != 1) || !copyRange(source, offset, length, target))
+            {
+                error = QStringLiteral("Failed to merge %1 into %2: %3").arg(source.fileName(), targetPath, target.errorString());
+                return false;
+            }
+            bool endsMidLine = started.value(relative);
+            if (length > 0)
+            {
+                char last = '\n';
+                endsMidLine = source.seek(source.size() - 1) && source.getChar(&last) && last != '\n';
+            }
+            started.insert(relative, endsMidLine);
+        }
+    }
+    return true;
+}
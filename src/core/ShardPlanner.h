@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// File work behind runtime.shard. plan() picks byte ranges that start on
+// record boundaries without reading the whole input; split() copies them
+// into shard files; concatenate() is the default merge of shard outputs.
+// All of it is blocking I/O meant for a pool thread.
+class ShardPlanner
+{
+public:
+    struct Range
+    {
+        qint64 offset{0};
+        qint64 length{0};
+    };
+
+    struct Plan
+    {
+        QString source;
+        QByteArray header; // first line (with newline) when config.header is set
+        QList<Range> ranges;
+    };
+
+    // Splits into at most maxShards ranges of at least config.minShardBytes;
+    // a plan with fewer than two ranges means sharding is not worthwhile.
+    static bool plan(const QString &path, const ShardConfigDTO &config, int maxShards, Plan &plan, QString &error);
+    // Writes shard i to <outputDir>/part-<i><suffix> and returns the paths.
+    static bool split(const Plan &plan, const QString &outputDir, QStringList &files, QString &error);
+    // Concatenates every text file found under the shard output dirs, in
+    // shard order, into the same relative path under outputDir. With
+    // skipHeader the first line of each file is dropped for every shard after
+    // the first; a piece that does not end in a newline gets one before the
+    // next piece is appended. Binary files cannot be appended and are copied to
+    // outputDir/shard-<n>/<relative path> instead.
+    static bool concatenate(const QStringList &shardOutputDirs, const QString &outputDir, bool skipHeader, QString &error);
+};
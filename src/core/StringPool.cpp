@@ -0,0 +1,213 @@
+#include "StringPool.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+template <typename Value, typename Equal>
+Value lookupOrInsert(QReadWriteLock &lock, QHash<size_t, QList<Value>> &buckets, size_t hash, const Value &value, Equal equal)
+{
+    {
+        QReadLocker locker(&lock);
+        const auto it = buckets.constFind(hash);
+        if (it != buckets.cend())
+        {
+            for (const Value &stored : it.value())
+            {
+                if (equal(stored, value))
+                {
+                    return stored;
+                }
+            }
+        }
+    }
+    QWriteLocker locker(&lock);
+    QList<Value> &bucket = buckets[hash];
+    for (const Value &stored : std::as_const(bucket))
+    {
+        if (equal(stored, value))
+        {
+            return stored;
+        }
+    }
+    bucket.append(value);
+    return value;
+}
+
+bool sameOptions(const QList<ParamOption> &a, const QList<ParamOption> &b)
+{
+    return std::equal(a.cbegin(), a.cend(), b.cbegin(), b.cend(), [](const ParamOption &x, const ParamOption &y)
+                      { return x.label == y.label && x.value == y.value; });
+}
+
+template <typename Value>
+qsizetype pruneBuckets(QHash<size_t, QList<Value>> &buckets)
+{
+    qsizetype removed = 0;
+    for (auto it = buckets.begin(); it != buckets.end();)
+    {
+        removed += it->removeIf([](const Value &stored) { return stored.isDetached(); });
+        if (it->isEmpty())
+        {
+            it = buckets.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+template <typename Value>
+qsizetype countBuckets(const QHash<size_t, QList<Value>> &buckets)
+{
+    qsizetype count = 0;
+    for (const QList<Value> &bucket : buckets)
+    {
+        count += bucket.size();
+    }
+    return count;
+}
+} // namespace
+
+StringPool &StringPool::instance()
+{
+    static StringPool pool;
+    return pool;
+}
+
+QString StringPool::intern(const QString &value)
+{
+    if (value.isEmpty() || !isEnabled())
+    {
+        return value;
+    }
+    {
+        QReadLocker locker(&m_lock);
+        const auto it = m_strings.constFind(value);
+        if (it != m_strings.cend())
+        {
+            return *it;
+        }
+    }
+    QWriteLocker locker(&m_lock);
+    const auto it = m_strings.constFind(value);
+    if (it != m_strings.cend())
+    {
+        return *it;
+    }
+    // Store a tight copy; the caller's buffer may carry YAML decoding slack.
+    QString stored = value;
+    stored.squeeze();
+    m_strings.insert(stored);
+    return stored;
+}
+
+QStringList StringPool::intern(const QStringList &values)
+{
+    if (values.isEmpty() || !isEnabled())
+    {
+        return values;
+    }
+    QStringList interned;
+    interned.reserve(values.size());
+    for (const QString &value : values)
+    {
+        interned << intern(value);
+    }
+    return lookupOrInsert(m_lock, m_lists, qHashRange(interned.cbegin(), interned.cend()), interned, std::equal_to<QStringList>());
+}
+
+QList<ParamOption> StringPool::intern(const QList<ParamOption> &options)
+{
+    if (options.isEmpty() || !isEnabled())
+    {
+        return options;
+    }
+    QList<ParamOption> interned;
+    interned.reserve(options.size());
+    size_t hash = 0;
+    for (const ParamOption &option : options)
+    {
+        interned.append({intern(option.label), intern(option.value)});
+        hash = qHashMulti(hash, option.label, option.value);
+    }
+    return lookupOrInsert(m_lock, m_optionLists, hash, interned, sameOptions);
+}
+
+void StringPool::internTool(ToolDTO &tool)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    tool.version = intern(tool.version);
+    tool.category = intern(tool.category);
+    tool.thumbnail = intern(tool.thumbnail);
+    tool.tags = intern(tool.tags);
+    tool.toolsRoot = intern(tool.toolsRoot);
+
+    RuntimeConfigDTO &rt = tool.runtime;
+    rt.type = intern(rt.type);
+    rt.entry = intern(rt.entry);
+    rt.workdir = intern(rt.workdir);
+    rt.args = intern(rt.args);
+    for (ExpectedOutputDTO &output : rt.expectedOutputs)
+    {
+        output.type = intern(output.type);
+    }
+
+    EnvConfigDTO &env = tool.env;
+    env.strategy = intern(env.strategy);
+    env.interpreterPath = intern(env.interpreterPath);
+    env.dependencies = intern(env.dependencies);
+    env.cacheDir = intern(env.cacheDir);
+    env.setup.workdir = intern(env.setup.workdir);
+
+    for (ParamDTO &param : tool.params)
+    {
+        param.key = intern(param.key);
+        param.label = intern(param.label);
+        param.placeholder = intern(param.placeholder);
+        param.pattern = intern(param.pattern);
+        param.defaultValue = intern(param.defaultValue);
+        param.options = intern(param.options);
+    }
+}
+
+qsizetype StringPool::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_strings.size() + countBuckets(m_lists) + countBuckets(m_optionLists);
+}
+
+void StringPool::clear()
+{
+    QWriteLocker locker(&m_lock);
+    m_strings.clear();
+    m_lists.clear();
+    m_optionLists.clear();
+}
+
+qsizetype StringPool::prune()
+{
+    QWriteLocker locker(&m_lock);
+    // Lists first: their items share buffers with m_strings.
+    qsizetype removed = pruneBuckets(m_lists) + pruneBuckets(m_optionLists);
+    for (auto it = m_strings.begin(); it != m_strings.end();)
+    {
+        if (it->isDetached())
+        {
+            it = m_strings.erase(it);
+            ++removed;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+// Process-wide intern pool for the strings and lists that repeat across a tool
+// library (categories, tags, runtime types, env strategies, select option
+// lists, ...). Interning returns an implicitly shared copy of an equal value
+// seen before, so 10k tools with the same ten categories hold ten buffers
+// instead of 10k. Safe to use from the scan thread pool.
+//
+// Lists are bucketed by a hash of their items rather than keyed by a joined
+// string, so a list that occurs once costs one copy, not two. prune() drops
+// values nothing outside the pool refers to any more; the scanner calls it
+// after each scan so a watched library does not accumulate stale entries.
+class StringPool
+{
+public:
+    static StringPool &instance();
+
+    QString intern(const QString &value);
+    QStringList intern(const QStringList &values);
+    QList<ParamOption> intern(const QList<ParamOption> &options);
+
+    // Interns every field of tool that typically repeats between manifests.
+    void internTool(ToolDTO &tool);
+
+    // Disabled pools return their input unchanged (used by the benchmark).
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    qsizetype size() const;
+    void clear();
+    // Removes every entry only the pool still holds; returns how many.
+    qsizetype prune();
+
+private:
+    StringPool() = default;
+
+    mutable QReadWriteLock m_lock;
+    QSet<QString> m_strings;
+    QHash<size_t, QList<QStringList>> m_lists;
+    QHash<size_t, QList<QList<ParamOption>>> m_optionLists;
+    std::atomic<bool> m_enabled{true};
+};
@@ -0,0 +1,103 @@
+#include "ToolCatalog.h"
+
+#include <atomic>
+
+namespace
+{
+std::atomic<quint64> g_nextVersion{1};
+} // namespace
+
+ToolCatalog::ToolCatalog()
+    : d(new Data)
+{
+}
+
+ToolCatalog::ToolCatalog(const QList<ToolHandle> &tools)
+    : d(new Data)
+{
+    reset(tools);
+}
+
+ToolHandle ToolCatalog::find(const QString &toolId) const
+{
+    const auto it = d->index.constFind(toolId);
+    return it == d->index.cend() ? ToolHandle() : d->tools.at(it.value());
+}
+
+void ToolCatalog::reset(const QList<ToolHandle> &tools)
+{
+    Data *data = d.data();
+    data->tools.clear();
+    data->index.clear();
+    data->tools.reserve(tools.size());
+    data->index.reserve(tools.size());
+    bumpVersion();
+    append(tools);
+}
+
+void ToolCatalog::append(const QList<ToolHandle> &tools)
+{
+    Data *data = d.data();
+    for (const ToolHandle &tool : tools)
+    {
+        if (!tool)
+        {
+            continue;
+        }
+        const auto it = data->index.constFind(tool->id);
+        if (it != data->index.cend())
+        {
+            data->tools[it.value()] = tool;
+            continue;
+        }
+        data->index.insert(tool->id, data->tools.size());
+        data->tools.append(tool);
+    }
+    bumpVersion();
+}
+
+ToolHandle ToolCatalog::upsert(const ToolHandle &tool)
+{
+    if (!tool)
+    {
+        return {};
+    }
+    Data *data = d.data();
+    ToolHandle previous;
+    const auto it = data->index.constFind(tool->id);
+    if (it != data->index.cend())
+    {
+        previous = data->tools.at(it.value());
+        data->tools[it.value()] = tool;
+    }
+    else
+    {
+        data->index.insert(tool->id, data->tools.size());
+        data->tools.append(tool);
+    }
+    bumpVersion();
+    return previous;
+}
+
+ToolHandle ToolCatalog::remove(const QString &toolId)
+{
+    // Check on the shared data first so a miss does not detach.
+    if (!d.constData()->index.contains(toolId))
+    {
+        return {};
+    }
+    Data *data = d.data();
+    const qsizetype position = data->index.take(toolId);
+    const ToolHandle removed = data->tools.takeAt(position);
+    for (qsizetype i = position; i < data->tools.size(); ++i)
+    {
+        data->index[data->tools.at(i)->id] = i;
+    }
+    bumpVersion();
+    return removed;
+}
+
+void ToolCatalog::bumpVersion()
+{
+    d->version = g_nextVersion.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QHash>
+#include <QList>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QString>
+
+// Implicitly shared snapshot of the scanned tools. Copying a catalog costs one
+// reference count; a writer detaches (copying only the handle list, never the
+// ToolDTOs) so snapshots held elsewhere stay unchanged. Every write assigns a
+// new, process-wide unique version, which lets readers cheaply tell whether
+// the catalog they derived state from is still current.
+class ToolCatalog
+{
+public:
+    ToolCatalog();
+    explicit ToolCatalog(const QList<ToolHandle> &tools);
+
+    quint64 version() const { return d->version; }
+    qsizetype size() const { return d->tools.size(); }
+    bool isEmpty() const { return d->tools.isEmpty(); }
+    const QList<ToolHandle> &tools() const { return d->tools; }
+    ToolHandle find(const QString &toolId) const;
+    bool contains(const QString &toolId) const { return d->index.contains(toolId); }
+
+    void reset(const QList<ToolHandle> &tools);
+    void append(const QList<ToolHandle> &tools);
+    // Replaces the tool with the same id (keeping its position) or appends it;
+    // returns the replaced handle, if any.
+    ToolHandle upsert(const ToolHandle &tool);
+    // Returns the removed handle, or a null handle when the id is unknown.
+    ToolHandle remove(const QString &toolId);
+
+private:
+    struct Data : QSharedData
+    {
+        quint64 version{0};
+        QList<ToolHandle> tools;
+        QHash<QString, qsizetype> index; // tool id -> position in tools
+    };
+
+    void bumpVersion();
+
+    QSharedDataPointer<Data> d;
+};
+
+Q_DECLARE_METATYPE(ToolCatalog)
@@ -0,0 +1,332 @@
+#include "ToolCatalogCache.h"
+
+#include "core/StringPool.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+Q_LOGGING_CATEGORY(logCatalog, "core.catalog")
+
+namespace
+{
+constexpr quint32 kCacheMagic = 0x53424343; // "SBCC"
+constexpr quint32 kCacheFormat = 4; // 4: header errors include runtime.args placeholder checks
+
+void writeParam(QDataStream &out, const ParamDTO &param)
+{
+    out << param.key << param.label << static_cast<qint32>(param.type) << param.required << param.defaultValue;
+    out << static_cast<qint32>(param.options.size());
+    for (const auto &opt : param.options)
+    {
+        out << opt.label << opt.value;
+    }
+    out << param.multi << param.min << param.max << param.step << param.placeholder << param.pattern << param.description;
+}
+
+void readParam(QDataStream &in, ParamDTO &param)
+{
+    qint32 type = 0;
+    qint32 optionCount = 0;
+    in >> param.key >> param.label >> type >> param.required >> param.defaultValue;
+    param.type = static_cast<ParamType>(type);
+    in >> optionCount;
+    for (qint32 i = 0; i < optionCount && in.status() == QDataStream::Ok; ++i)
+    {
+        ParamOption opt;
+        in >> opt.label >> opt.value;
+        param.options.append(opt);
+    }
+    in >> param.multi >> param.min >> param.max >> param.step >> param.placeholder >> param.pattern >> param.description;
+}
+
+void writeTool(QDataStream &out, const ToolDTO &tool)
+{
+    out << tool.id << tool.name << tool.version << tool.description << tool.category << tool.thumbnail << tool.tags;
+    out << tool.toolDir << tool.toolsRoot;
+
+    const RuntimeConfigDTO &rt = tool.runtime;
+    out << rt.type << rt.entry << rt.args << rt.shellWrap << rt.workdir << rt.extraEnv << static_cast<qint32>(rt.timeoutSeconds);
+    out << static_cast<qint32>(rt.expectedOutputs.size());
+    for (const auto &ex : rt.expectedOutputs)
+    {
+        out << ex.path << ex.label << ex.type;
+    }
+
+    const EnvConfigDTO &env = tool.env;
+    out << env.strategy << env.interpreterPath << env.dependencies << env.cacheDir;
+    out << env.setup.command << env.setup.shell << env.setup.workdir;
+
+    out << static_cast<qint32>(tool.params.size());
+    for (const auto &param : tool.params)
+    {
+        writeParam(out, param);
+    }
+}
+
+void readTool(QDataStream &in, ToolDTO &tool)
+{
+    in >> tool.id >> tool.name >> tool.version >> tool.description >> tool.category >> tool.thumbnail >> tool.tags;
+    in >> tool.toolDir >> tool.toolsRoot;
+
+    RuntimeConfigDTO &rt = tool.runtime;
+    qint32 timeout = 0;
+    qint32 outputCount = 0;
+    in >> rt.type >> rt.entry >> rt.args >> rt.shellWrap >> rt.workdir >> rt.extraEnv >> timeout;
+    rt.timeoutSeconds = timeout;
+    in >> outputCount;
+    for (qint32 i = 0; i < outputCount && in.status() == QDataStream::Ok; ++i)
+    {
+        ExpectedOutputDTO ex;
+        in >> ex.path >> ex.label >> ex.type;
+        rt.expectedOutputs.append(ex);
+    }
+
+    EnvConfigDTO &env = tool.env;
+    in >> env.strategy >> env.interpreterPath >> env.dependencies >> env.cacheDir;
+    in >> env.setup.command >> env.setup.shell >> env.setup.workdir;
+
+    qint32 paramCount = 0;
+    in >> paramCount;
+    for (qint32 i = 0; i < paramCount && in.status() == QDataStream::Ok; ++i)
+    {
+        ParamDTO param;
+        readParam(in, param);
+        tool.params.append(param);
+    }
+}
+} // namespace
+
+bool ToolCatalogCache::load(const QString &catalogKey)
+{
+    clear();
+    m_catalogKey = catalogKey;
+
+    QFile file(cacheFilePath(catalogKey));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 format = 0;
+    QString storedKey;
+    qint32 count = 0;
+    in >> magic >> format;
+    if (magic != kCacheMagic || format != kCacheFormat)
+    {
+        qInfo(logCatalog) << "Ignoring incompatible catalog cache" << file.fileName();
+        return false;
+    }
+    in >> storedKey >> count;
+    if (storedKey != catalogKey)
+    {
+        return false;
+    }
+
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        Entry entry;
+        in >> entry.manifestPath >> entry.stamp.size >> entry.stamp.mtimeMs >> entry.stamp.contentHash >> entry.error;
+        ToolDTO tool;
+        readTool(in, tool);
+        StringPool::instance().internTool(tool);
+        entry.tool = ToolHandle::create(std::move(tool));
+        m_order << entry.manifestPath;
+        m_entries.insert(entry.manifestPath, entry);
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        qWarning(logCatalog) << "Corrupt catalog cache" << file.fileName();
+        clear();
+        m_catalogKey = catalogKey;
+        return false;
+    }
+
+    qInfo(logCatalog) << "Loaded catalog cache" << file.fileName() << "entries" << m_entries.size();
+    return true;
+}
+
+bool ToolCatalogCache::save()
+{
+    if (m_catalogKey.isEmpty())
+    {
+        return false;
+    }
+
+    const QString path = cacheFilePath(m_catalogKey);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning(logCatalog) << "Cannot write catalog cache" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kCacheMagic << kCacheFormat << m_catalogKey << static_cast<qint32>(m_order.size());
+    for (const QString &manifestPath : std::as_const(m_order))
+    {
+        const Entry &entry = m_entries.find(manifestPath).value();
+        out << entry.manifestPath << entry.stamp.size << entry.stamp.mtimeMs << entry.stamp.contentHash << entry.error;
+        writeTool(out, entry.tool ? *entry.tool : ToolDTO{});
+    }
+
+    if (!file.commit())
+    {
+        qWarning(logCatalog) << "Failed to commit catalog cache" << path << file.errorString();
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+void ToolCatalogCache::clear()
+{
+    m_catalogKey.clear();
+    m_entries.clear();
+    m_order.clear();
+    m_dirty = false;
+}
+
+QList<ToolHandle> ToolCatalogCache::tools() const
+{
+    QList<ToolHandle> list;
+    list.reserve(m_order.size());
+    for (const QString &manifestPath : m_order)
+    {
+        const auto it = m_entries.constFind(manifestPath);
+        if (it != m_entries.cend() && it->tool && !it->tool->id.isEmpty())
+        {
+            list.append(it->tool);
+        }
+    }
+    return list;
+}
+
+bool ToolCatalogCache::lookup(const QString &manifestPath, const QFileInfo &info, Entry &entry) const
+{
+    const auto it = m_entries.constFind(manifestPath);
+    if (it == m_entries.cend())
+    {
+        return false;
+    }
+
+    ManifestStamp current = stampFor(info);
+    if (!it->stamp.sameFileTimes(current))
+    {
+        // Touched or copied without a content change (common on network shares
+        // and after checkouts): fall back to comparing the content hash.
+        current.contentHash = hashFile(manifestPath);
+        if (current.contentHash.isEmpty() || current.contentHash != it->stamp.contentHash)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        current.contentHash = it->stamp.contentHash;
+    }
+
+    entry = *it;
+    entry.stamp = current;
+    return true;
+}
+
+void ToolCatalogCache::insert(const Entry &entry)
+{
+    auto it = m_entries.find(entry.manifestPath);
+    if (it == m_entries.end())
+    {
+        m_order << entry.manifestPath;
+        m_entries.insert(entry.manifestPath, entry);
+        m_dirty = true;
+        return;
+    }
+
+    if (it->stamp.size != entry.stamp.size || it->stamp.mtimeMs != entry.stamp.mtimeMs || it->stamp.contentHash != entry.stamp.contentHash)
+    {
+        *it = entry;
+        m_dirty = true;
+    }
+}
+
+void ToolCatalogCache::remove(const QString &manifestPath)
+{
+    if (m_entries.remove(manifestPath) > 0)
+    {
+        m_order.removeAll(manifestPath);
+        m_dirty = true;
+    }
+}
+
+void ToolCatalogCache::retainOnly(const QStringList &manifestPaths)
+{
+    if (manifestPaths == m_order)
+    {
+        return;
+    }
+
+    QHash<QString, Entry> kept;
+    QStringList order;
+    for (const QString &manifestPath : manifestPaths)
+    {
+        const auto it = m_entries.constFind(manifestPath);
+        if (it != m_entries.cend())
+        {
+            kept.insert(manifestPath, *it);
+            order << manifestPath;
+        }
+    }
+    m_entries.swap(kept);
+    m_order = order;
+    m_dirty = true;
+}
+
+ToolCatalogCache::ManifestStamp ToolCatalogCache::stampFor(const QFileInfo &info)
+{
+    ManifestStamp stamp;
+    stamp.size = info.exists() ? info.size() : -1;
+    stamp.mtimeMs = info.lastModified().toMSecsSinceEpoch();
+    return stamp;
+}
+
+QByteArray ToolCatalogCache::hashFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    return hash.result();
+}
+
+QByteArray ToolCatalogCache::hashContent(const QByteArray &content)
+{
+    return QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+}
+
+QString ToolCatalogCache::cacheFilePath(const QString &catalogKey)
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (base.isEmpty())
+    {
+        base = QDir::temp().filePath(QStringLiteral("ScriptToolbox"));
+    }
+    const QByteArray fileKey = QCryptographicHash::hash(catalogKey.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    return QDir(base).filePath(QStringLiteral("catalog/%1.bin").arg(QString::fromLatin1(fileKey)));
+}
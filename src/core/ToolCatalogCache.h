@@ -0,0 +1,65 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+class QFileInfo;
+
+// On-disk snapshot of parsed tool manifests for one scan configuration (its
+// tools roots, see catalogKeyFor in ScanWorker). Each entry is
+// keyed by the manifest path and validated against its size, mtime and
+// content hash, so only changed tool.yaml files need to be parsed again.
+class ToolCatalogCache
+{
+public:
+    struct ManifestStamp
+    {
+        qint64 size{-1};
+        qint64 mtimeMs{0};
+        QByteArray contentHash;
+
+        bool sameFileTimes(const ManifestStamp &other) const { return size == other.size && mtimeMs == other.mtimeMs; }
+    };
+
+    struct Entry
+    {
+        QString manifestPath;
+        ManifestStamp stamp;
+        ToolHandle tool;
+        QString error;
+    };
+
+    ToolCatalogCache() = default;
+
+    bool load(const QString &catalogKey);
+    bool save();
+    void clear();
+
+    QString catalogKey() const { return m_catalogKey; }
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    bool isDirty() const { return m_dirty; }
+    QList<ToolHandle> tools() const;
+
+    // Thread-safe for concurrent readers. On success fills entry with the cached
+    // data and the stamp that should be stored back (the content hash is only
+    // computed when size/mtime changed).
+    bool lookup(const QString &manifestPath, const QFileInfo &info, Entry &entry) const;
+    void insert(const Entry &entry);
+    void remove(const QString &manifestPath);
+    void retainOnly(const QStringList &manifestPaths);
+
+    static ManifestStamp stampFor(const QFileInfo &info);
+    static QByteArray hashFile(const QString &path);
+    static QByteArray hashContent(const QByteArray &content);
+    static QString cacheFilePath(const QString &catalogKey);
+
+private:
+    QString m_catalogKey;
+    QHash<QString, Entry> m_entries;
+    QStringList m_order;
+    bool m_dirty{false};
+};
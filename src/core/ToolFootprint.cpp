@@ -0,0 +1,151 @@
+#include "ToolFootprint.h"
+
+#include <QSet>
+
+namespace
+{
+// Handle control block plus the DTO it owns (QSharedPointer::create allocates both at once).
+constexpr qint64 kHandleOverhead = 2 * sizeof(void *) + sizeof(int) * 2;
+// Rough per-node cost of the std::map behind QMap.
+constexpr qint64 kMapNodeOverhead = 4 * sizeof(void *);
+
+class Walker
+{
+public:
+    ToolFootprint result;
+
+    void addTool(const ToolHandle &tool)
+    {
+        if (!tool || !claim(tool.data()))
+        {
+            return;
+        }
+        ++result.tools;
+        result.totalBytes += kHandleOverhead + qint64(sizeof(ToolDTO));
+
+        addString(tool->id);
+        addString(tool->name);
+        addString(tool->version);
+        addString(tool->description);
+        addString(tool->category);
+        addString(tool->thumbnail);
+        addStringList(tool->tags);
+        addString(tool->toolDir);
+        addString(tool->toolsRoot);
+
+        const RuntimeConfigDTO &rt = tool->runtime;
+        addString(rt.type);
+        addString(rt.entry);
+        addStringList(rt.args);
+        addString(rt.workdir);
+        if (!rt.extraEnv.isEmpty())
+        {
+            result.totalBytes += rt.extraEnv.size() * (kMapNodeOverhead + 2 * qint64(sizeof(QString)));
+            for (auto it = rt.extraEnv.cbegin(); it != rt.extraEnv.cend(); ++it)
+            {
+                addString(it.key());
+                addString(it.value());
+            }
+        }
+        if (addListBuffer(rt.expectedOutputs))
+        {
+            for (const ExpectedOutputDTO &output : rt.expectedOutputs)
+            {
+                addString(output.path);
+                addString(output.label);
+                addString(output.type);
+            }
+        }
+
+        const EnvConfigDTO &env = tool->env;
+        addString(env.strategy);
+        addString(env.interpreterPath);
+        addStringList(env.dependencies);
+        addString(env.cacheDir);
+        addString(env.setup.command);
+        addString(env.setup.workdir);
+
+        if (addListBuffer(tool->params))
+        {
+            for (const ParamDTO &param : tool->params)
+            {
+                addString(param.key);
+                addString(param.label);
+                addString(param.defaultValue);
+                addString(param.placeholder);
+                addString(param.pattern);
+                addString(param.description);
+                if (addListBuffer(param.options))
+                {
+                    for (const ParamOption &option : param.options)
+                    {
+                        addString(option.label);
+                        addString(option.value);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    QSet<const void *> m_seen;
+
+    bool claim(const void *buffer)
+    {
+        if (m_seen.contains(buffer))
+        {
+            return false;
+        }
+        m_seen.insert(buffer);
+        ++result.uniqueBuffers;
+        return true;
+    }
+
+    void addString(const QString &value)
+    {
+        // capacity() is 0 for empty strings and for QStringLiteral data,
+        // neither of which owns heap memory.
+        if (value.capacity() == 0 || !claim(value.constData()))
+        {
+            return;
+        }
+        const qint64 bytes = qint64(sizeof(QArrayData)) + (value.capacity() + 1) * qint64(sizeof(QChar));
+        result.stringBytes += bytes;
+        result.totalBytes += bytes;
+    }
+
+    // Returns true when the buffer was not seen before, i.e. its elements
+    // still need to be walked.
+    template <typename T>
+    bool addListBuffer(const QList<T> &list)
+    {
+        if (list.capacity() == 0 || !claim(list.constData()))
+        {
+            return false;
+        }
+        result.totalBytes += qint64(sizeof(QArrayData)) + list.capacity() * qint64(sizeof(T));
+        return true;
+    }
+
+    void addStringList(const QStringList &list)
+    {
+        if (addListBuffer(list))
+        {
+            for (const QString &value : list)
+            {
+                addString(value);
+            }
+        }
+    }
+};
+} // namespace
+
+ToolFootprint ToolFootprint::estimate(const QList<ToolHandle> &tools)
+{
+    Walker walker;
+    for (const ToolHandle &tool : tools)
+    {
+        walker.addTool(tool);
+    }
+    return walker.result;
+}
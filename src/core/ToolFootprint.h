@@ -0,0 +1,21 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QList>
+
+// Estimates the heap held by a set of tools. Implicitly shared buffers
+// (interned strings, shared lists, the same handle listed twice) are counted
+// once, so the result reflects what interning actually saves. Allocator
+// overhead is ignored; the figures are meant for comparisons, not accounting.
+struct ToolFootprint
+{
+    qsizetype tools{0};
+    qint64 totalBytes{0};
+    qint64 stringBytes{0}; // QString payloads and headers
+    qsizetype uniqueBuffers{0};
+
+    double bytesPerTool() const { return tools > 0 ? double(totalBytes) / tools : 0.0; }
+
+    static ToolFootprint estimate(const QList<ToolHandle> &tools);
+};
@@ -0,0 +1,513 @@
+#include "ToolManifest.h"
+
+#include "core/ArgTemplate.h"
+#include "core/StringPool.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSet>
+
+#include <yaml-cpp/yaml.h>
+
+#include <cctype>
+
+namespace
+{
+QString toQString(const YAML::Node &node, const QString &fallback = QString())
+{
+    if (!node)
+    {
+        return fallback;
+    }
+    if (node.IsScalar())
+    {
+        return QString::fromStdString(node.as<std::string>());
+    }
+    return fallback;
+}
+
+bool toBool(const YAML::Node &node, bool fallback = false)
+{
+    if (!node)
+    {
+        return fallback;
+    }
+    if (node.IsScalar())
+    {
+        return node.as<bool>(fallback);
+    }
+    return fallback;
+}
+
+QStringList toStringList(const YAML::Node &node)
+{
+    QStringList list;
+    if (!node || !node.IsSequence())
+    {
+        return list;
+    }
+    for (const auto &item : node)
+    {
+        list << QString::fromStdString(item.as<std::string>(""));
+    }
+    return list;
+}
+// "512M", "2G", "1.5g", "65536K"; a bare number is MB. Returns 0 when unset
+// or unparsable.
+qint64 toByteSize(const YAML::Node &node)
+{
+    QString text = toQString(node).trimmed().toUpper();
+    if (text.endsWith(QLatin1Char('B')))
+    {
+        text.chop(1);
+    }
+    qint64 unit = 1024 * 1024;
+    if (text.endsWith(QLatin1Char('K')) || text.endsWith(QLatin1Char('M')) || text.endsWith(QLatin1Char('G')))
+    {
+        const QChar suffix = text.back();
+        unit = suffix == QLatin1Char('K') ? 1024 : (suffix == QLatin1Char('M') ? 1024 * 1024 : 1024LL * 1024 * 1024);
+        text.chop(1);
+    }
+    bool ok = false;
+    const double value = text.trimmed().toDouble(&ok);
+    return ok && value > 0 ? static_cast<qint64>(value * unit) : 0;
+}
+
+void decodeLimits(const YAML::Node &node, LimitsDTO &limits)
+{
+    limits.cpuSeconds = node["cpu"].as<int>(0);
+    limits.cpuCores = node["cpu_cores"].as<double>(0.0);
+    limits.memoryBytes = toByteSize(node["memory"]);
+    limits.openFiles = node["nofile"].as<int>(0);
+    limits.processes = node["nproc"].as<int>(0);
+    limits.cgroup = toBool(node["cgroup"]);
+}
+
+void decodeHeader(const YAML::Node &root, ToolDTO &dto)
+{
+    dto.name = toQString(root["name"], dto.id);
+    dto.version = toQString(root["version"]);
+    dto.description = toQString(root["description"]);
+    dto.category = toQString(root["category"], QStringLiteral("未分类"));
+    dto.thumbnail = toQString(root["thumbnail"]);
+
+    if (root["tags"])
+    {
+        for (const auto &tag : root["tags"])
+        {
+            dto.tags << QString::fromStdString(tag.as<std::string>());
+        }
+    }
+}
+
+const QSet<QByteArray> &headerKeys()
+{
+    static const QSet<QByteArray> keys{"id", "name", "version", "description", "category", "thumbnail", "tags", "runtime", "command"};
+    return keys;
+}
+} // namespace
+
+QString ToolManifest::manifestPath(const QString &toolDirPath)
+{
+    return QDir(toolDirPath).filePath(QStringLiteral("tool.yaml"));
+}
+
+QByteArray ToolManifest::extractHeaderDocument(const QByteArray &content)
+{
+    QByteArray out;
+    out.reserve(qMin<qsizetype>(content.size(), 4096));
+    bool keep = false;
+    bool seenKey = false;
+
+    qsizetype start = content.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+    while (start < content.size())
+    {
+        qsizetype end = content.indexOf('\n', start);
+        if (end < 0)
+        {
+            end = content.size();
+        }
+        const QByteArrayView line(content.constData() + start, end - start);
+        start = end + 1;
+
+        if (line.isEmpty() || line.front() == ' ' || line.front() == '\t' || line.front() == '#' || line.front() == '\r')
+        {
+            if (keep)
+            {
+                out.append(line).append('\n');
+            }
+            continue;
+        }
+        if (line.front() == '-')
+        {
+            if (line.startsWith("---"))
+            {
+                // A leading document marker is fine; a second document is not.
+                if (seenKey)
+                {
+                    return {};
+                }
+                continue;
+            }
+            // Block sequence items may sit at column 0 under their key.
+            if (!seenKey)
+            {
+                return {};
+            }
+            if (keep)
+            {
+                out.append(line).append('\n');
+            }
+            continue;
+        }
+
+        // Anything but a plain or quoted "key:" line (flow maps, anchors,
+        // tags, complex keys) is left to the full parser.
+        const qsizetype colon = line.indexOf(':');
+        if (colon <= 0 || !(line.front() == '"' || line.front() == '\'' || std::isalnum(static_cast<unsigned char>(line.front())) || line.front() == '_'))
+        {
+            return {};
+        }
+        QByteArray key = line.first(colon).trimmed().toByteArray();
+        if (key.size() >= 2 && (key.front() == '"' || key.front() == '\'') && key.back() == key.front())
+        {
+            key = key.mid(1, key.size() - 2);
+        }
+        seenKey = true;
+        keep = headerKeys().contains(key);
+        if (keep)
+        {
+            out.append(line).append('\n');
+        }
+    }
+    return seenKey ? out : QByteArray();
+}
+
+ToolDTO ToolManifest::loadHeader(const QString &toolDirPath, QString &error)
+{
+    const QString yamlPath = manifestPath(toolDirPath);
+    QFile file(yamlPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        ToolDTO dto;
+        dto.id = QFileInfo(toolDirPath).fileName();
+        dto.toolDir = toolDirPath;
+        error = QStringLiteral("Failed to parse %1: %2").arg(yamlPath, file.errorString());
+        return dto;
+    }
+    return loadHeader(toolDirPath, file.readAll(), error);
+}
+
+ToolDTO ToolManifest::loadHeader(const QString &toolDirPath, const QByteArray &content, QString &error)
+{
+    ToolDTO dto;
+    dto.id = QFileInfo(toolDirPath).fileName();
+    dto.toolDir = toolDirPath;
+    const QString yamlPath = manifestPath(toolDirPath);
+
+    QByteArray header = extractHeaderDocument(content);
+    if (header.isEmpty())
+    {
+        header = content;
+    }
+
+    try
+    {
+        const YAML::Node root = YAML::Load(header.toStdString());
+        decodeHeader(root, dto);
+        QStringList templateErrors;
+
+        if (root["runtime"])
+        {
+            const auto runtime = root["runtime"];
+            dto.runtime.type = toQString(runtime["type"]);
+            dto.runtime.entry = toQString(runtime["entry"]);
+            // Params are not decoded yet, so only the placeholders themselves
+            // are checked here; loadFull also checks the parameter keys.
+            templateErrors << ArgTemplate::check(toStringList(runtime["args"]), QStringLiteral("runtime.args"), false);
+            if (runtime["shard"] && runtime["shard"]["merge"])
+            {
+                templateErrors << ArgTemplate::check(toStringList(runtime["shard"]["merge"]["args"]), QStringLiteral("runtime.shard.merge.args"), true);
+            }
+        }
+        else
+        {
+            dto.runtime.type = QStringLiteral("generic");
+            dto.runtime.entry = toQString(root["command"]); // legacy fallback
+        }
+
+        if (dto.runtime.entry.isEmpty())
+        {
+            error = QStringLiteral("Missing runtime.entry in %1").arg(yamlPath);
+        }
+        else if (!templateErrors.isEmpty())
+        {
+            error = QStringLiteral("%1: %2").arg(yamlPath, templateErrors.join(QStringLiteral("; ")));
+        }
+    }
+    catch (const YAML::Exception &ex)
+    {
+        error = QStringLiteral("Failed to parse %1: %2").arg(yamlPath, QString::fromStdString(ex.what()));
+    }
+
+    StringPool::instance().internTool(dto);
+    return dto;
+}
+
+ToolDTO ToolManifest::loadFull(const QString &toolDirPath, QString &error)
+{
+    ToolDTO dto;
+    dto.id = QFileInfo(toolDirPath).fileName();
+    dto.toolDir = toolDirPath;
+
+    const QString yamlPath = manifestPath(toolDirPath);
+    try
+    {
+        YAML::Node root = YAML::LoadFile(yamlPath.toStdString());
+
+        decodeHeader(root, dto);
+
+        // runtime
+        if (root["runtime"])
+        {
+            const auto runtime = root["runtime"];
+            dto.runtime.type = toQString(runtime["type"]);
+            dto.runtime.entry = toQString(runtime["entry"]);
+            dto.runtime.args = toStringList(runtime["args"]);
+            dto.runtime.shellWrap = toBool(runtime["shell"], toBool(runtime["shell_wrap"], false));
+            dto.runtime.workdir = toQString(runtime["workdir"], QStringLiteral("."));
+            dto.runtime.timeoutSeconds = runtime["timeout"].as<int>(0);
+            dto.runtime.cache = toBool(runtime["cache"]);
+            if (runtime["warm"].IsMap())
+            {
+                const auto warm = runtime["warm"];
+                dto.runtime.warm.enabled = toBool(warm["enabled"], true);
+                dto.runtime.warm.preload = toStringList(warm["preload"]);
+                dto.runtime.warm.size = warm["size"].as<int>(1);
+            }
+            else
+            {
+                dto.runtime.warm.enabled = toBool(runtime["warm"]);
+            }
+            dto.runtime.server.enabled = toQString(runtime["mode"]).trimmed().toLower() == QStringLiteral("server");
+            if (runtime["server"])
+            {
+                const auto server = runtime["server"];
+                dto.runtime.server.idleTimeoutSeconds = server["idle_timeout"].as<int>(dto.runtime.server.idleTimeoutSeconds);
+                dto.runtime.server.healthIntervalSeconds = server["health_interval"].as<int>(dto.runtime.server.healthIntervalSeconds);
+                dto.runtime.server.startTimeoutSeconds = server["start_timeout"].as<int>(dto.runtime.server.startTimeoutSeconds);
+            }
+            if (runtime["limits"])
+            {
+                decodeLimits(runtime["limits"], dto.runtime.limits);
+            }
+
+            if (runtime["extra_env"])
+            {
+                for (auto it = runtime["extra_env"].begin(); it != runtime["extra_env"].end(); ++it)
+                {
+                    dto.runtime.extraEnv.insert(QString::fromStdString(it->first.as<std::string>()),
+                                                QString::fromStdString(it->second.as<std::string>("")));
+                }
+            }
+
+            if (runtime["shard"])
+            {
+                const auto shard = runtime["shard"];
+                dto.runtime.shard.param = toQString(shard["param"]);
+                dto.runtime.shard.recordStart = toQString(shard["record_start"]);
+                dto.runtime.shard.header = toBool(shard["header"]);
+                dto.runtime.shard.maxShards = shard["max_shards"].as<int>(0);
+                dto.runtime.shard.minShardBytes = static_cast<qint64>(shard["min_shard_mb"].as<double>(8.0) * 1024 * 1024);
+                if (shard["merge"])
+                {
+                    dto.runtime.shard.mergeEntry = toQString(shard["merge"]["entry"]);
+                    dto.runtime.shard.mergeArgs = toStringList(shard["merge"]["args"]);
+                }
+            }
+
+            if (runtime["expected_outputs"])
+            {
+                for (const auto &out : runtime["expected_outputs"])
+                {
+                    ExpectedOutputDTO ex;
+                    ex.path = toQString(out["path"]);
+                    ex.label = toQString(out["label"], ex.path);
+                    ex.type = toQString(out["type"], QStringLiteral("file"));
+                    if (!ex.path.isEmpty())
+                    {
+                        dto.runtime.expectedOutputs.append(ex);
+                    }
+                }
+            }
+        }
+        else
+        {
+            dto.runtime.type = QStringLiteral("generic");
+            dto.runtime.entry = toQString(root["command"]); // legacy fallback
+        }
+
+        // limits: documented at the top level; runtime.limits is accepted too.
+        if (root["limits"])
+        {
+            decodeLimits(root["limits"], dto.runtime.limits);
+        }
+
+        // env
+        if (root["env"])
+        {
+            const auto env = root["env"];
+            dto.env.strategy = toQString(env["strategy"], toQString(env["type"]));
+            dto.env.interpreterPath = toQString(env["interpreter"], toQString(env["interpreter_path"]));
+            dto.env.dependencies = toStringList(env["dependencies"]);
+            dto.env.cacheDir = toQString(env["cache_dir"]);
+
+            if (env["setup"])
+            {
+                const auto setup = env["setup"];
+                dto.env.setup.command = toQString(setup["command"]);
+                dto.env.setup.shell = toBool(setup["shell"]);
+                dto.env.setup.workdir = toQString(setup["workdir"], QStringLiteral("."));
+            }
+        }
+
+        if (dto.env.cacheDir.isEmpty())
+        {
+            if (dto.runtime.type.toLower() == QStringLiteral("r"))
+            {
+                dto.env.cacheDir = QStringLiteral(".r-lib");
+            }
+            else if (dto.runtime.type.toLower() == QStringLiteral("python"))
+            {
+                dto.env.cacheDir = QStringLiteral(".venv");
+            }
+        }
+
+        if (root["params"])
+        {
+            for (const auto &p : root["params"])
+            {
+                ParamDTO param;
+                param.key = toQString(p["key"]);
+                param.label = toQString(p["label"], param.key);
+                param.type = paramTypeFromString(toQString(p["type"]));
+                param.required = p["required"].as<bool>(false);
+                param.defaultValue = toQString(p["default"]);
+                param.multi = p["multi"].as<bool>(false);
+                param.min = p["min"].as<double>(0.0);
+                param.max = p["max"].as<double>(0.0);
+                param.step = p["step"].as<double>(1.0);
+                param.placeholder = toQString(p["placeholder"]);
+                param.pattern = toQString(p["pattern"]);
+                param.description = toQString(p["description"]);
+
+                if (p["options"])
+                {
+                    for (const auto &opt : p["options"])
+                    {
+                        ParamOption o;
+                        if (opt.IsMap())
+                        {
+                            o.label = toQString(opt["label"]);
+                            o.value = toQString(opt["value"], o.label);
+                        }
+                        else
+                        {
+                            const QString val = QString::fromStdString(opt.as<std::string>(""));
+                            o.label = val;
+                            o.value = val;
+                        }
+                        param.options.append(o);
+                    }
+                }
+
+                if (!param.key.isEmpty())
+                {
+                    dto.params.append(param);
+                }
+            }
+        }
+
+        // Templates are compiled once here and shared by every run of the tool.
+        QStringList paramKeys;
+        for (const ParamDTO &param : dto.params)
+        {
+            paramKeys << param.key;
+        }
+        QStringList templateErrors;
+        dto.runtime.argTemplate = QSharedPointer<const ArgTemplate>::create(
+            ArgTemplate::compile(dto.runtime.args, QStringLiteral("runtime.args"), paramKeys, false, templateErrors));
+        if (!dto.runtime.shard.mergeArgs.isEmpty())
+        {
+            dto.runtime.shard.mergeArgTemplate = QSharedPointer<const ArgTemplate>::create(
+                ArgTemplate::compile(dto.runtime.shard.mergeArgs, QStringLiteral("runtime.shard.merge.args"), paramKeys, true, templateErrors));
+        }
+
+        if (dto.runtime.entry.isEmpty())
+        {
+            error = QStringLiteral("Missing runtime.entry in %1").arg(yamlPath);
+        }
+        else if (!templateErrors.isEmpty())
+        {
+            error = QStringLiteral("%1: %2").arg(yamlPath, templateErrors.join(QStringLiteral("; ")));
+        }
+    }
+    catch (const YAML::Exception &ex)
+    {
+        error = QStringLiteral("Failed to parse %1: %2").arg(yamlPath, QString::fromStdString(ex.what()));
+    }
+
+    StringPool::instance().internTool(dto);
+    dto.detailsLoaded = true;
+    return dto;
+}
+
+ToolHandle ToolManifestCache::resolve(const ToolHandle &header, QString &error)
+{
+    if (!header || header->detailsLoaded)
+    {
+        return header;
+    }
+
+    const QString path = ToolManifest::manifestPath(header->toolDir);
+    const QFileInfo info(path);
+    const qint64 size = info.exists() ? info.size() : -1;
+    const qint64 mtimeMs = info.lastModified().toMSecsSinceEpoch();
+
+    {
+        QMutexLocker lock(&m_mutex);
+        const auto it = m_entries.constFind(path);
+        if (it != m_entries.cend() && it->size == size && it->mtimeMs == mtimeMs)
+        {
+            error = it->error;
+            return it->tool;
+        }
+    }
+
+    // Decode outside the lock; a concurrent duplicate decode is harmless.
+    Entry entry;
+    entry.size = size;
+    entry.mtimeMs = mtimeMs;
+    ToolDTO tool = ToolManifest::loadFull(header->toolDir, entry.error);
+    tool.toolsRoot = header->toolsRoot;
+    entry.tool = ToolHandle::create(std::move(tool));
+
+    QMutexLocker lock(&m_mutex);
+    m_entries.insert(path, entry);
+    error = entry.error;
+    return entry.tool;
+}
+
+void ToolManifestCache::invalidate(const QString &toolDirPath)
+{
+    QMutexLocker lock(&m_mutex);
+    m_entries.remove(ToolManifest::manifestPath(toolDirPath));
+}
+
+void ToolManifestCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_entries.clear();
+}
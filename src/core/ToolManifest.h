@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// Decodes tool.yaml into ToolDTO in two phases. The header pass only decodes
+// what the tool list needs (name, category, thumbnail, description, tags and
+// runtime type/entry) and skips the params/env blocks textually; the full pass
+// decodes everything and marks the DTO with detailsLoaded.
+class ToolManifest
+{
+public:
+    static QString manifestPath(const QString &toolDirPath);
+    static ToolDTO loadHeader(const QString &toolDirPath, QString &error);
+    // Same, from tool.yaml content the caller has already read.
+    static ToolDTO loadHeader(const QString &toolDirPath, const QByteArray &content, QString &error);
+    static ToolDTO loadFull(const QString &toolDirPath, QString &error);
+
+    // Returns only the top-level blocks the header pass needs, or an empty
+    // array when the document layout is not simple enough to slice safely.
+    static QByteArray extractHeaderDocument(const QByteArray &content);
+};
+
+// Cache of full manifest decodes keyed by manifest path. An entry is reused
+// while the file keeps its size and mtime. Safe to use from any thread.
+class ToolManifestCache
+{
+public:
+    // header must carry toolDir (as produced by the scan). Returns header itself
+    // when it is already fully decoded.
+    ToolHandle resolve(const ToolHandle &header, QString &error);
+    void invalidate(const QString &toolDirPath);
+    void clear();
+
+private:
+    struct Entry
+    {
+        qint64 size{-1};
+        qint64 mtimeMs{0};
+        ToolHandle tool;
+        QString error;
+    };
+
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
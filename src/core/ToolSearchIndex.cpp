@@ -0,0 +1,311 @@
+#include "ToolSearchIndex.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+constexpr double kExactWeight = 1.0;
+constexpr double kPrefixWeight = 0.6;
+constexpr double kFuzzyWeight = 0.3;
+constexpr int kFuzzyMinLength = 3;
+
+bool isCjk(QChar ch)
+{
+    switch (ch.script())
+    {
+    case QChar::Script_Han:
+    case QChar::Script_Hiragana:
+    case QChar::Script_Katakana:
+    case QChar::Script_Hangul:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Smallest optimal-string-alignment distance between query and any prefix of
+// term, or maxDistance + 1 once it is known to exceed the bound. Prefix
+// distance keeps fuzzy matching useful while the user is still typing.
+int prefixDistance(const QString &query, const QString &term, int maxDistance, std::vector<int> rows[3])
+{
+    const int n = static_cast<int>(query.size());
+    const int m = std::min(static_cast<int>(term.size()), n + maxDistance);
+    for (auto *row : {&rows[0], &rows[1], &rows[2]})
+    {
+        row->assign(m + 1, 0);
+    }
+    std::vector<int> *before = &rows[0];
+    std::vector<int> *previous = &rows[1];
+    std::vector<int> *current = &rows[2];
+    for (int j = 0; j <= m; ++j)
+    {
+        (*previous)[j] = j;
+    }
+
+    for (int i = 1; i <= n; ++i)
+    {
+        (*current)[0] = i;
+        int rowMin = i;
+        for (int j = 1; j <= m; ++j)
+        {
+            const int cost = query.at(i - 1) == term.at(j - 1) ? 0 : 1;
+            int value = std::min({(*previous)[j] + 1, (*current)[j - 1] + 1, (*previous)[j - 1] + cost});
+            if (i > 1 && j > 1 && query.at(i - 1) == term.at(j - 2) && query.at(i - 2) == term.at(j - 1))
+            {
+                value = std::min(value, (*before)[j - 2] + 1);
+            }
+            (*current)[j] = value;
+            rowMin = std::min(rowMin, value);
+        }
+        if (rowMin > maxDistance)
+        {
+            return maxDistance + 1;
+        }
+        std::swap(before, previous);
+        std::swap(previous, current);
+    }
+    return *std::min_element(previous->cbegin(), previous->cend());
+}
+} // namespace
+
+QStringList ToolSearchIndex::tokenize(const QString &text)
+{
+    QStringList tokens;
+    QString word;
+    auto flush = [&]() {
+        if (!word.isEmpty())
+        {
+            tokens << word;
+            word.clear();
+        }
+    };
+    for (const QChar ch : text)
+    {
+        if (isCjk(ch))
+        {
+            flush();
+            tokens << QString(ch);
+        }
+        else if (ch.isLetterOrNumber())
+        {
+            word += ch.toLower();
+        }
+        else
+        {
+            flush();
+        }
+    }
+    flush();
+    return tokens;
+}
+
+void ToolSearchIndex::clear()
+{
+    m_docs.clear();
+    m_freeSlots.clear();
+    m_docIds.clear();
+    m_postings.clear();
+    m_nextSeq = 0;
+}
+
+void ToolSearchIndex::rebuild(const QList<ToolHandle> &tools)
+{
+    clear();
+    m_docs.reserve(tools.size());
+    m_docIds.reserve(tools.size());
+    for (const ToolHandle &tool : tools)
+    {
+        upsert(tool);
+    }
+}
+
+void ToolSearchIndex::upsert(const ToolHandle &tool)
+{
+    if (!tool)
+    {
+        return;
+    }
+
+    int slot = m_docIds.value(tool->id, -1);
+    quint64 seq = 0;
+    if (slot >= 0)
+    {
+        seq = m_docs.at(slot).seq; // keep its place among equal scores
+        unindex(slot);
+    }
+    else
+    {
+        seq = m_nextSeq++;
+        if (!m_freeSlots.isEmpty())
+        {
+            slot = m_freeSlots.takeLast();
+        }
+        else
+        {
+            slot = static_cast<int>(m_docs.size());
+            m_docs.append(Doc{});
+        }
+        m_docIds.insert(tool->id, slot);
+    }
+
+    Doc &doc = m_docs[slot];
+    doc.toolId = tool->id;
+    doc.seq = seq;
+    doc.terms.clear();
+    addTerms(doc.terms, tool->name, Name);
+    addTerms(doc.terms, tool->id, Id);
+    doc.terms[tool->id.toLower()] |= Id; // whole id, e.g. python_table_demo
+    for (const QString &tag : tool->tags)
+    {
+        addTerms(doc.terms, tag, Tags);
+    }
+    addTerms(doc.terms, tool->category, Category);
+    addTerms(doc.terms, tool->description, Description);
+
+    for (auto it = doc.terms.cbegin(); it != doc.terms.cend(); ++it)
+    {
+        m_postings[it.key()].insert(slot, it.value());
+    }
+}
+
+void ToolSearchIndex::remove(const QString &toolId)
+{
+    const int slot = m_docIds.value(toolId, -1);
+    if (slot < 0)
+    {
+        return;
+    }
+    unindex(slot);
+    m_docs[slot] = Doc{};
+    m_docIds.remove(toolId);
+    m_freeSlots.append(slot);
+}
+
+void ToolSearchIndex::addTerms(QHash<QString, quint8> &terms, const QString &text, Field field) const
+{
+    for (const QString &token : tokenize(text))
+    {
+        terms[token] |= field;
+    }
+}
+
+void ToolSearchIndex::unindex(int slot)
+{
+    const Doc &doc = m_docs.at(slot);
+    for (auto it = doc.terms.cbegin(); it != doc.terms.cend(); ++it)
+    {
+        auto posting = m_postings.find(it.key());
+        if (posting == m_postings.end())
+        {
+            continue;
+        }
+        posting->remove(slot);
+        if (posting->isEmpty())
+        {
+            m_postings.erase(posting);
+        }
+    }
+}
+
+double ToolSearchIndex::fieldWeight(quint8 fields)
+{
+    if (fields & Name)
+        return 5.0;
+    if (fields & Id)
+        return 4.0;
+    if (fields & Tags)
+        return 3.0;
+    if (fields & Category)
+        return 2.0;
+    return 1.0;
+}
+
+QHash<int, double> ToolSearchIndex::matchTerm(const QString &term) const
+{
+    QHash<int, double> scores;
+    auto credit = [&scores](const Posting &posting, double weight) {
+        for (auto it = posting.cbegin(); it != posting.cend(); ++it)
+        {
+            double &score = scores[it.key()];
+            score = std::max(score, fieldWeight(it.value()) * weight);
+        }
+    };
+
+    // Exact and prefix matches are one contiguous run in the ordered map.
+    for (auto it = m_postings.lowerBound(term); it != m_postings.cend() && it.key().startsWith(term); ++it)
+    {
+        credit(it.value(), it.key().size() == term.size() ? kExactWeight : kPrefixWeight);
+    }
+    if (!scores.isEmpty() || term.size() < kFuzzyMinLength)
+    {
+        return scores;
+    }
+
+    const int maxDistance = term.size() >= 7 ? 2 : 1;
+    std::vector<int> rows[3];
+    for (auto it = m_postings.cbegin(); it != m_postings.cend(); ++it)
+    {
+        if (it.key().size() + maxDistance < term.size())
+        {
+            continue;
+        }
+        if (prefixDistance(term, it.key(), maxDistance, rows) <= maxDistance)
+        {
+            credit(it.value(), kFuzzyWeight);
+        }
+    }
+    return scores;
+}
+
+QList<ToolSearchIndex::Hit> ToolSearchIndex::search(const QString &query) const
+{
+    QStringList terms = tokenize(query);
+    terms.removeDuplicates();
+    if (terms.isEmpty())
+    {
+        return {};
+    }
+
+    // Every term must match; candidates only ever shrink after the first one.
+    QHash<int, double> scores = matchTerm(terms.first());
+    for (qsizetype i = 1; i < terms.size() && !scores.isEmpty(); ++i)
+    {
+        const QHash<int, double> termScores = matchTerm(terms.at(i));
+        for (auto it = scores.begin(); it != scores.end();)
+        {
+            const auto match = termScores.constFind(it.key());
+            if (match == termScores.cend())
+            {
+                it = scores.erase(it);
+            }
+            else
+            {
+                it.value() += match.value();
+                ++it;
+            }
+        }
+    }
+
+    std::vector<std::pair<int, double>> ranked;
+    ranked.reserve(scores.size());
+    for (auto it = scores.cbegin(); it != scores.cend(); ++it)
+    {
+        ranked.emplace_back(it.key(), it.value());
+    }
+    std::sort(ranked.begin(), ranked.end(), [this](const auto &a, const auto &b) {
+        if (a.second != b.second)
+        {
+            return a.second > b.second;
+        }
+        return m_docs.at(a.first).seq < m_docs.at(b.first).seq;
+    });
+
+    QList<Hit> hits;
+    hits.reserve(static_cast<qsizetype>(ranked.size()));
+    for (const auto &[slot, score] : ranked)
+    {
+        hits.append({m_docs.at(slot).toolId, score});
+    }
+    return hits;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// Inverted index over tool name, id, tags, category and description. Terms
+// are lower-cased words; CJK text is indexed per character so queries work
+// without word segmentation. A query matches a tool when every query term
+// matches one of its terms exactly, as a prefix, or (when neither finds
+// anything) within a small edit distance. Updates are incremental, so the
+// index follows catalog changes without a rebuild.
+class ToolSearchIndex
+{
+public:
+    struct Hit
+    {
+        QString toolId;
+        double score{0};
+    };
+
+    void clear();
+    void rebuild(const QList<ToolHandle> &tools);
+    void upsert(const ToolHandle &tool);
+    void remove(const QString &toolId);
+    qsizetype size() const { return m_docIds.size(); }
+
+    // Best match first; ties keep the order in which tools were indexed.
+    QList<Hit> search(const QString &query) const;
+
+    static QStringList tokenize(const QString &text);
+
+private:
+    enum Field : quint8
+    {
+        Description = 0x01,
+        Category = 0x02,
+        Tags = 0x04,
+        Id = 0x08,
+        Name = 0x10,
+    };
+
+    struct Doc
+    {
+        QString toolId;
+        quint64 seq{0};
+        QHash<QString, quint8> terms; // term -> fields it occurs in
+    };
+
+    using Posting = QHash<int, quint8>; // doc slot -> fields
+
+    void addTerms(QHash<QString, quint8> &terms, const QString &text, Field field) const;
+    void unindex(int slot);
+    QHash<int, double> matchTerm(const QString &term) const;
+    static double fieldWeight(quint8 fields);
+
+    QList<Doc> m_docs;
+    QList<int> m_freeSlots;
+    QHash<QString, int> m_docIds;
+    QMap<QString, Posting> m_postings; // ordered for prefix lookups
+    quint64 m_nextSeq{0};
+};
@@ -0,0 +1,367 @@
+#include "ToolServer.h"
+
+#include "core/ProcessControl.h"
+
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLoggingCategory>
+#include <QProcess>
+#include <QTimer>
+
+#include <utility>
+
+Q_LOGGING_CATEGORY(logServer, "core.server")
+
+ToolServer::ToolServer(const QString &name, const Spec &spec, QObject *parent)
+    : QObject(parent), m_name(name), m_spec(spec)
+{
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(qMax(1, spec.config.idleTimeoutSeconds) * 1000);
+    connect(m_idleTimer, &QTimer::timeout, this, [this]()
+            {
+        if (m_state == State::Ready && m_queue.isEmpty())
+        {
+            stop(QStringLiteral("idle for %1 s").arg(m_spec.config.idleTimeoutSeconds), false);
+        } });
+
+    m_healthTimer = new QTimer(this);
+    m_healthTimer->setInterval(qMax(1, spec.config.healthIntervalSeconds) * 1000);
+    connect(m_healthTimer, &QTimer::timeout, this, &ToolServer::ping);
+
+    m_deadline = new QTimer(this);
+    m_deadline->setSingleShot(true);
+    connect(m_deadline, &QTimer::timeout, this, [this]()
+            {
+        if (m_state == State::Starting)
+        {
+            stop(QStringLiteral("not ready after %1 s").arg(m_spec.config.startTimeoutSeconds), true);
+        }
+        else
+        {
+            stop(QStringLiteral("no answer to a health check within %1 s").arg(kPingTimeoutMs / 1000), true);
+        } });
+}
+
+QString ToolServer::keyOf(const QString &toolId, const Spec &spec)
+{
+    QStringList environment = spec.environment.toStringList();
+    environment.sort();
+    const QStringList parts{toolId,
+                            spec.program,
+                            spec.args.join(QChar(0)),
+                            spec.workdir,
+                            environment.join(QLatin1Char('\n')),
+                            QStringLiteral("%1 %2 %3 %4 %5 %6")
+                                .arg(spec.limits.cpuSeconds)
+                                .arg(spec.limits.cpuCores)
+                                .arg(spec.limits.memoryBytes)
+                                .arg(spec.limits.openFiles)
+                                .arg(spec.limits.processes)
+                                .arg(int(spec.limits.cgroup)),
+                            QStringLiteral("%1 %2 %3")
+                                .arg(spec.config.idleTimeoutSeconds)
+                                .arg(spec.config.healthIntervalSeconds)
+                                .arg(spec.config.startTimeoutSeconds)};
+    return QString::fromLatin1(QCryptographicHash::hash(parts.join(QChar(1)).toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+void ToolServer::submit(const QString &runId, const QJsonObject &request)
+{
+    m_queue.append({runId, request});
+    if (m_state == State::Down)
+    {
+        start();
+        return;
+    }
+    // Starting and Busy pick the queue up on "ready" / "result"; Stopping on
+    // the restart that follows the exit.
+    dispatchNext();
+}
+
+void ToolServer::cancel(const QString &runId)
+{
+    for (qsizetype i = 0; i < m_queue.size(); ++i)
+    {
+        if (m_queue.at(i).first == runId)
+        {
+            m_queue.removeAt(i);
+            emit requestFinished(runId, -1, QStringLiteral("cancelled"));
+            return;
+        }
+    }
+    if (m_current == runId)
+    {
+        stop(QStringLiteral("request %1 cancelled").arg(runId), false);
+    }
+}
+
+void ToolServer::start()
+{
+    QString program = m_spec.program;
+    QStringList args = m_spec.args;
+    auto *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+    ProcessControl::prepare(*process, m_spec.limits, program, args);
+    process->setProcessEnvironment(m_spec.environment);
+    process->setWorkingDirectory(m_spec.workdir);
+
+    connect(process, &QProcess::readyReadStandardOutput, this, &ToolServer::handleStdout);
+    connect(process, &QProcess::readyReadStandardError, this, [this, process]()
+            {
+        const QByteArray data = process->readAllStandardError();
+        if (!m_current.isEmpty())
+        {
+            emit requestOutput(m_current, data, true);
+        }
+        else
+        {
+            qInfo(logServer).noquote() << m_name << QString::fromUtf8(data).trimmed();
+        } });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this](int exitCode, QProcess::ExitStatus status)
+            { handleExit(status == QProcess::NormalExit ? QStringLiteral("exit %1").arg(exitCode) : QStringLiteral("crashed")); });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error)
+            {
+        // Every other error is followed by finished().
+        if (error == QProcess::FailedToStart)
+        {
+            handleExit(QStringLiteral("failed to start: %1").arg(process->errorString()));
+        } });
+
+    m_process = process;
+    m_state = State::Starting;
+    m_stdout.clear();
+    if (m_spec.config.startTimeoutSeconds > 0)
+    {
+        m_deadline->start(m_spec.config.startTimeoutSeconds * 1000);
+    }
+    qInfo(logServer) << "Starting server" << m_name << "program" << program << "args" << args;
+    process->setProgram(program);
+    process->setArguments(args);
+    process->start();
+}
+
+void ToolServer::stop(const QString &reason, bool failure)
+{
+    if (!m_process || m_state == State::Stopping)
+    {
+        return;
+    }
+    qInfo(logServer) << "Stopping server" << m_name << reason;
+    const bool idle = m_state == State::Ready;
+    m_state = State::Stopping;
+    m_stopReason = reason;
+    m_stopIsFailure = failure;
+    m_idleTimer->stop();
+    m_healthTimer->stop();
+    m_deadline->stop();
+
+    QProcess *process = m_process;
+    if (idle && !failure)
+    {
+        send(QJsonObject{{QStringLiteral("type"), QStringLiteral("shutdown")}});
+        process->closeWriteChannel();
+    }
+    else
+    {
+        ProcessControl::terminate(*process);
+    }
+    QTimer::singleShot(kKillGraceMs, process, [this, process]()
+                       {
+        if (process->state() != QProcess::NotRunning)
+        {
+            qWarning(logServer) << "Killing server" << m_name << "after it ignored the stop request";
+            ProcessControl::kill(*process);
+        } });
+}
+
+void ToolServer::dispatchNext()
+{
+    if (m_state != State::Ready)
+    {
+        return;
+    }
+    if (m_queue.isEmpty())
+    {
+        if (m_spec.config.idleTimeoutSeconds > 0)
+        {
+            m_idleTimer->start();
+        }
+        return;
+    }
+    m_idleTimer->stop();
+    auto [runId, request] = m_queue.takeFirst();
+    request.insert(QStringLiteral("type"), QStringLiteral("run"));
+    request.insert(QStringLiteral("id"), runId);
+    m_current = runId;
+    m_state = State::Busy;
+    send(request);
+    emit requestStarted(runId);
+}
+
+void ToolServer::send(const QJsonObject &message)
+{
+    // Compact JSON escapes newlines inside strings: one message, one line.
+    m_process->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void ToolServer::handleStdout()
+{
+    m_stdout += m_process->readAllStandardOutput();
+    qsizetype start = 0;
+    for (qsizetype newline = m_stdout.indexOf('\n'); newline >= 0; newline = m_stdout.indexOf('\n', start))
+    {
+        QByteArray line = m_stdout.mid(start, newline - start);
+        if (line.endsWith('\r'))
+        {
+            line.chop(1);
+        }
+        start = newline + 1;
+        handleLine(line);
+    }
+    m_stdout.remove(0, start);
+}
+
+void ToolServer::handleLine(const QByteArray &line)
+{
+    if (line.startsWith('{'))
+    {
+        QJsonParseError error;
+        const QJsonObject message = QJsonDocument::fromJson(line, &error).object();
+        const QString type = message.value(QStringLiteral("type")).toString();
+        if (error.error == QJsonParseError::NoError && !type.isEmpty())
+        {
+            const QString id = message.value(QStringLiteral("id")).toString();
+            if (type == QStringLiteral("ready"))
+            {
+                if (m_state == State::Starting)
+                {
+                    m_deadline->stop();
+                    m_state = State::Ready;
+                    qInfo(logServer) << "Server" << m_name << "ready";
+                    if (m_spec.config.healthIntervalSeconds > 0)
+                    {
+                        m_healthTimer->start();
+                    }
+                    dispatchNext();
+                }
+            }
+            else if (type == QStringLiteral("pong"))
+            {
+                if (m_state != State::Starting)
+                {
+                    m_deadline->stop();
+                }
+            }
+            else if (type == QStringLiteral("log"))
+            {
+                if (!id.isEmpty() && id == m_current)
+                {
+                    QByteArray text = message.value(QStringLiteral("text")).toString().toUtf8();
+                    if (!text.endsWith('\n'))
+                    {
+                        text += '\n';
+                    }
+                    emit requestOutput(id, text, message.value(QStringLiteral("stream")).toString() == QStringLiteral("stderr"));
+                }
+            }
+            else if (type == QStringLiteral("result"))
+            {
+                if (id.isEmpty() || id != m_current)
+                {
+                    return;
+                }
+                m_current.clear();
+                m_failures = 0;
+                const int exitCode = message.value(QStringLiteral("exitCode")).toInt(0);
+                QString text = message.value(QStringLiteral("message")).toString();
+                if (text.isEmpty())
+                {
+                    text = QStringLiteral("exit %1").arg(exitCode);
+                }
+                emit requestFinished(id, exitCode, text);
+                if (m_state == State::Busy)
+                {
+                    m_state = State::Ready;
+                    dispatchNext();
+                }
+            }
+            else
+            {
+                qWarning(logServer) << "Server" << m_name << "sent an unknown message type" << type;
+            }
+            return;
+        }
+    }
+
+    // Anything else on stdout is plain output of the request in flight.
+    if (!m_current.isEmpty())
+    {
+        emit requestOutput(m_current, line + '\n', false);
+    }
+    else
+    {
+        qInfo(logServer).noquote() << m_name << QString::fromUtf8(line);
+    }
+}
+
+void ToolServer::handleExit(const QString &status)
+{
+    m_process->deleteLater();
+    m_process = nullptr;
+    m_idleTimer->stop();
+    m_healthTimer->stop();
+    m_deadline->stop();
+    m_state = State::Down;
+    const bool expected = !m_stopReason.isEmpty() && !m_stopIsFailure;
+    const QString reason = m_stopReason.isEmpty() ? status : m_stopReason;
+    m_stopReason.clear();
+
+    if (!m_current.isEmpty())
+    {
+        emit requestFinished(std::exchange(m_current, QString()), -1, QStringLiteral("tool server stopped: %1").arg(reason));
+    }
+    if (expected)
+    {
+        qInfo(logServer) << "Server" << m_name << "stopped:" << reason;
+    }
+    else
+    {
+        ++m_failures;
+        qWarning(logServer) << "Server" << m_name << "stopped unexpectedly:" << reason;
+    }
+
+    if (m_failures >= kMaxFailures)
+    {
+        failQueue(QStringLiteral("tool server failed %1 times in a row (last: %2)").arg(m_failures).arg(reason));
+        m_failures = 0;
+        return;
+    }
+    if (!m_queue.isEmpty())
+    {
+        start();
+    }
+}
+
+void ToolServer::ping()
+{
+    // Requests are read one at a time, so only an idle server can answer
+    // promptly; a busy one is covered by runtime.timeout.
+    if (m_state != State::Ready || m_deadline->isActive())
+    {
+        return;
+    }
+    send(QJsonObject{{QStringLiteral("type"), QStringLiteral("ping")}, {QStringLiteral("id"), QString::number(++m_pingSeq)}});
+    m_deadline->start(kPingTimeoutMs);
+}
+
+void ToolServer::failQueue(const QString &message)
+{
+    const auto queue = std::exchange(m_queue, {});
+    for (const auto &entry : queue)
+    {
+        emit requestFinished(entry.first, -1, message);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+
+class QProcess;
+class QTimer;
+
+// Host of one runtime.mode: server tool. The tool is started once and kept
+// alive; every run becomes a request line on its stdin and it answers on
+// stdout, one JSON object per line:
+//
+//   core -> tool   {"type":"run","id":<runId>,"args":[..],"params":{..},
+//                   "runDir":..,"outputDir":..,"env":{..}}
+//                  {"type":"ping","id":<n>}    {"type":"shutdown"}
+//   tool -> core   {"type":"ready"}            {"type":"pong","id":<n>}
+//                  {"type":"log","id":<runId>,"stream":"stdout"|"stderr","text":..}
+//                  {"type":"result","id":<runId>,"exitCode":0,"message":..}
+//
+// Requests are handled one at a time in submission order. Other stdout
+// lines and all of stderr count as output of the request in flight.
+// The server is started on demand and shut down after the idle timeout.
+// While idle it is pinged every health interval, and a missing pong gets
+// it restarted. When it exits with a request in flight, that request fails
+// and the server is restarted for the rest of the queue. After
+// kMaxFailures starts in a row that produced no result, the queue fails
+// instead. Lives on the job thread.
+class ToolServer : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int kPingTimeoutMs = 10000;
+    static constexpr int kKillGraceMs = 5000;
+    static constexpr int kMaxFailures = 3;
+
+    struct Spec
+    {
+        QString program;
+        QStringList args;
+        QProcessEnvironment environment;
+        QString workdir;
+        LimitsDTO limits;
+        ServerConfigDTO config;
+    };
+
+    ToolServer(const QString &name, const Spec &spec, QObject *parent = nullptr);
+
+    static QString keyOf(const QString &toolId, const Spec &spec);
+
+    void submit(const QString &runId, const QJsonObject &request);
+    // A queued request is dropped; the one in flight cannot be interrupted
+    // through the protocol, so the server is stopped (and restarted for
+    // whatever is queued behind it).
+    void cancel(const QString &runId);
+
+signals:
+    void requestStarted(const QString &runId);
+    void requestOutput(const QString &runId, const QByteArray &data, bool isError);
+    void requestFinished(const QString &runId, int exitCode, const QString &message);
+
+private:
+    enum class State
+    {
+        Down,
+        Starting, // waiting for "ready"
+        Ready,
+        Busy,
+        Stopping
+    };
+
+    void start();
+    void stop(const QString &reason, bool failure);
+    void dispatchNext();
+    void send(const QJsonObject &message);
+    void handleStdout();
+    void handleLine(const QByteArray &line);
+    void handleExit(const QString &status);
+    void ping();
+    void failQueue(const QString &message);
+
+    QString m_name;
+    Spec m_spec;
+    QProcess *m_process{nullptr};
+    State m_state{State::Down};
+    QList<QPair<QString, QJsonObject>> m_queue;
+    QString m_current;     // request in flight
+    QByteArray m_stdout;   // incomplete protocol line
+    QString m_stopReason;  // why the server is being stopped, if it is
+    bool m_stopIsFailure{false};
+    int m_failures{0};     // starts in a row without a result
+    qint64 m_pingSeq{0};
+    QTimer *m_idleTimer{nullptr};
+    QTimer *m_healthTimer{nullptr};
+    QTimer *m_deadline{nullptr}; // start-up ("ready") and pong deadline
+};
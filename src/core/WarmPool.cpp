@@ -0,0 +1,301 @@
+#include "WarmPool.h"
+
+#include "core/ProcessControl.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QUrl>
+
+Q_LOGGING_CATEGORY(logWarm, "core.warm")
+
+namespace
+{
+// Both bootstraps read the same job format from stdin: a "<variables> <args>"
+// line, then one percent-encoded field per line -- workdir, entry, the
+// name/value pairs of the per-run variables, the args.
+
+const char kPythonBootstrap[] = R"PY(# Warm interpreter for runtime.warm tools, written by Script Toolbox.
+# Imports the modules named on the command line, then reads one job from
+# stdin and runs it the way `python <entry> <args...>` would.
+import importlib
+import os
+import runpy
+import sys
+from urllib.parse import unquote
+
+
+def preload(names):
+    # Nothing printed while importing belongs to a run.
+    saved = sys.stdout, sys.stderr
+    with open(os.devnull, "w") as sink:
+        sys.stdout = sys.stderr = sink
+        try:
+            for name in names:
+                try:
+                    importlib.import_module(name)
+                except Exception:
+                    pass
+        finally:
+            sys.stdout, sys.stderr = saved
+
+
+def read_job():
+    header = sys.stdin.readline().split()
+    if len(header) != 2:
+        return None
+    variables, count = int(header[0]), int(header[1])
+    fields = [unquote(sys.stdin.readline().rstrip("\r\n")) for _ in range(2 + 2 * variables + count)]
+    pairs = fields[2:2 + 2 * variables]
+    return fields[0], fields[1], dict(zip(pairs[0::2], pairs[1::2])), fields[2 + 2 * variables:]
+
+
+preload(sys.argv[1:])
+job = read_job()
+if job is None:
+    sys.exit(0)
+workdir, entry, variables, args = job
+del job, preload, read_job
+os.environ.update(variables)
+os.chdir(workdir)
+sys.argv = [entry] + args
+sys.path[0] = os.path.dirname(os.path.abspath(entry))
+runpy.run_path(entry, run_name="__main__")
+)PY";
+
+const char kRBootstrap[] = R"R(# Warm interpreter for runtime.warm tools, written by Script Toolbox.
+# Loads the packages named on the command line, then reads one job from
+# stdin and runs it the way `Rscript <entry> <args...>` would.
+local({
+  for (pkg in commandArgs(trailingOnly = TRUE)) {
+    try(suppressPackageStartupMessages(loadNamespace(pkg)), silent = TRUE)
+  }
+})
+
+local({
+  con <- file("stdin", open = "r")
+  header <- readLines(con, n = 1L)
+  if (length(header) == 0L) quit(save = "no", status = 0L)
+  counts <- suppressWarnings(as.integer(strsplit(header, " ", fixed = TRUE)[[1L]]))
+  if (length(counts) != 2L || anyNA(counts)) quit(save = "no", status = 0L)
+  fields <- readLines(con, n = 2L + 2L * counts[1L] + counts[2L])
+  close(con)
+  fields <- vapply(fields, function(field) {
+    value <- utils::URLdecode(field)
+    Encoding(value) <- "UTF-8"
+    value
+  }, "", USE.NAMES = FALSE)
+
+  if (counts[1L] > 0L) {
+    pairs <- fields[2L + seq_len(2L * counts[1L])]
+    values <- pairs[c(FALSE, TRUE)]
+    names(values) <- pairs[c(TRUE, FALSE)]
+    do.call(Sys.setenv, as.list(values))
+  }
+  entry <- fields[2L]
+  args <- fields[2L + 2L * counts[1L] + seq_len(counts[2L])]
+  # Scripts read their arguments through commandArgs(); the global
+  # definition shadows base's for them.
+  assign("commandArgs", function(trailingOnly = FALSE) {
+    if (trailingOnly) args else c(base::commandArgs()[1L], paste0("--file=", entry), "--args", args)
+  }, envir = globalenv())
+  setwd(fields[1L])
+  source(entry)
+})
+)R";
+} // namespace
+
+WarmPool::WarmPool(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool WarmPool::supports(const QString &runtime)
+{
+    return runtime == QStringLiteral("python") || runtime == QStringLiteral("r");
+}
+
+QProcess *WarmPool::take(const Spec &spec, QObject *parent)
+{
+    const QString key = keyOf(spec);
+    QProcess *process = nullptr;
+    QList<QProcess *> idle = m_idle.take(key);
+    while (!idle.isEmpty() && !process)
+    {
+        QProcess *candidate = idle.takeFirst();
+        QObject::disconnect(candidate, nullptr, this, nullptr);
+        if (candidate->state() == QProcess::NotRunning)
+        {
+            candidate->deleteLater();
+            continue;
+        }
+        // Whatever the imports printed and is still buffered belongs to no run.
+        candidate->readAllStandardOutput();
+        candidate->readAllStandardError();
+        candidate->setParent(parent);
+        process = candidate;
+    }
+    if (!idle.isEmpty())
+    {
+        m_idle.insert(key, idle);
+    }
+    fill(key, spec);
+    return process;
+}
+
+void WarmPool::dispatch(QProcess &process, const Job &job)
+{
+    QByteArray message = QByteArray::number(job.variables.size()) + ' ' + QByteArray::number(job.args.size()) + '\n';
+    const auto addField = [&message](const QString &value)
+    { message += QUrl::toPercentEncoding(value) + '\n'; };
+    addField(job.workdir);
+    addField(job.entry);
+    for (auto it = job.variables.cbegin(); it != job.variables.cend(); ++it)
+    {
+        addField(it.key());
+        addField(it.value());
+    }
+    for (const QString &arg : job.args)
+    {
+        addField(arg);
+    }
+    process.write(message);
+    // A cold run's stdin stays open but empty; EOF is the closest a script
+    // reading it can get to that once the job line is consumed.
+    process.closeWriteChannel();
+}
+
+QString WarmPool::keyOf(const Spec &spec)
+{
+    QStringList environment = spec.environment.toStringList();
+    environment.sort();
+    const QStringList parts{spec.runtime, spec.program, spec.preload.join(QLatin1Char(' ')), spec.envStamp, environment.join(QLatin1Char('\n'))};
+    return QString::fromLatin1(QCryptographicHash::hash(parts.join(QChar(0)).toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+QString WarmPool::bootstrapPath(const QString &runtime)
+{
+    const auto cached = m_bootstrapPaths.constFind(runtime);
+    if (cached != m_bootstrapPaths.cend())
+    {
+        return cached.value();
+    }
+
+    QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (base.isEmpty())
+    {
+        base = QDir::temp().filePath(QStringLiteral("ScriptToolbox"));
+    }
+    const bool python = runtime == QStringLiteral("python");
+    const QString path = QDir(base).filePath(python ? QStringLiteral("warm/bootstrap.py") : QStringLiteral("warm/bootstrap.R"));
+    const QByteArray content(python ? kPythonBootstrap : kRBootstrap);
+
+    QFile existing(path);
+    if (!existing.open(QIODevice::ReadOnly) || existing.readAll() != content)
+    {
+        existing.close();
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit())
+        {
+            qWarning(logWarm) << "Cannot write" << path << file.errorString();
+            return QString();
+        }
+    }
+    m_bootstrapPaths.insert(runtime, path);
+    return path;
+}
+
+void WarmPool::fill(const QString &key, const Spec &spec)
+{
+    if (m_broken.contains(key))
+    {
+        return;
+    }
+    const QString bootstrap = bootstrapPath(spec.runtime);
+    if (bootstrap.isEmpty())
+    {
+        return;
+    }
+
+    const int size = qBound(1, spec.size, kMaxSize);
+    QList<QProcess *> &idle = m_idle[key];
+    if (idle.size() >= size)
+    {
+        return;
+    }
+    qInfo(logWarm) << "Starting" << size - idle.size() << "warm interpreter(s):" << spec.program << "preloading" << spec.preload;
+    while (idle.size() < size)
+    {
+        auto *process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::SeparateChannels);
+        QString program = spec.program;
+        QStringList args{bootstrap};
+        args << spec.preload;
+        // No limits (runtime.warm is not used with them), but the process
+        // group, so that stopping the run reaches its children.
+        ProcessControl::prepare(*process, LimitsDTO(), program, args);
+        process->setProcessEnvironment(spec.environment);
+        process->setWorkingDirectory(QDir::tempPath());
+
+        connect(process, &QProcess::readyReadStandardOutput, this, [process]()
+                { process->readAllStandardOutput(); });
+        connect(process, &QProcess::readyReadStandardError, this, [process]()
+                { process->readAllStandardError(); });
+        const auto died = [this, key, process, program = spec.program]()
+        {
+            // Usually a missing or broken interpreter; starting more would fail
+            // the same way, so runs of this spec start cold from now on.
+            qWarning(logWarm) << "Warm interpreter" << program << "exited while idle:" << process->errorString();
+            m_broken.insert(key);
+            drop(key, process);
+        };
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, died);
+        connect(process, &QProcess::errorOccurred, this, [died](QProcess::ProcessError error)
+                {
+            if (error == QProcess::FailedToStart)
+            {
+                died();
+            } });
+        QTimer::singleShot(kIdleTimeoutMs, process, [this, key, process]()
+                           {
+            if (m_idle.value(key).contains(process))
+            {
+                qInfo(logWarm) << "Stopping idle warm interpreter" << process->program();
+                drop(key, process);
+            } });
+
+        process->setProgram(program);
+        process->setArguments(args);
+        process->start();
+        idle << process;
+    }
+}
+
+void WarmPool::drop(const QString &key, QProcess *process)
+{
+    const auto it = m_idle.find(key);
+    if (it != m_idle.end())
+    {
+        it->removeAll(process);
+        if (it->isEmpty())
+        {
+            m_idle.erase(it);
+        }
+    }
+    QObject::disconnect(process, nullptr, this, nullptr);
+    if (process->state() == QProcess::NotRunning)
+    {
+        process->deleteLater();
+        return;
+    }
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process, &QObject::deleteLater);
+    // Blocked on its job line; EOF ends it without a signal.
+    process->closeWriteChannel();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QProcessEnvironment>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QProcess;
+
+// Pre-started interpreters for runtime.warm tools. A warm interpreter has
+// already imported the modules (Python) or loaded the packages (R) the tool
+// declares and blocks on stdin until it is handed one job, which it runs as
+// `python <entry> <args>` / `Rscript <entry> <args>` would; then it exits.
+// Every run is still a process of its own, so its pipes, process group,
+// stop/timeout handling and metrics work as for a cold start, and nothing a
+// script does can leak into the next run.
+//
+// Interpreters are pooled per Spec (interpreter, environment, preload) and
+// started on demand: the first run of a spec starts cold and fills the pool
+// for the next. Idle interpreters are stopped after kIdleTimeoutMs. Lives on
+// the job thread.
+class WarmPool : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int kIdleTimeoutMs = 10 * 60 * 1000;
+    static constexpr int kMaxSize = 8;
+
+    struct Spec
+    {
+        QString runtime;                 // "python" | "r"
+        QString program;                 // interpreter
+        QStringList preload;             // modules / packages imported while idle
+        QProcessEnvironment environment; // everything except the per-run variables
+        QString envStamp;                // changes when the env is rebuilt differently
+        int size{1};                     // interpreters kept ready
+    };
+
+    struct Job
+    {
+        QString workdir;
+        QString entry;
+        QStringList args;
+        QMap<QString, QString> variables; // per-run environment (TOOL_RUN_DIR, ...)
+    };
+
+    explicit WarmPool(QObject *parent = nullptr);
+
+    static bool supports(const QString &runtime);
+
+    // Returns a started interpreter for spec, reparented to parent, or nullptr
+    // when none is ready. Either way the pool for spec is topped up again.
+    QProcess *take(const Spec &spec, QObject *parent);
+    // Sends job to an interpreter returned by take() and closes its stdin.
+    static void dispatch(QProcess &process, const Job &job);
+
+private:
+    static QString keyOf(const Spec &spec);
+    // Writes the bootstrap script for runtime to the cache directory once.
+    QString bootstrapPath(const QString &runtime);
+    void fill(const QString &key, const Spec &spec);
+    void drop(const QString &key, QProcess *process);
+
+    QHash<QString, QList<QProcess *>> m_idle;
+    QSet<QString> m_broken; // specs whose interpreters died while idle; run cold
+    QHash<QString, QString> m_bootstrapPaths;
+};
@@ -74,9 +74,10 @@ bool commandExists(const QString &program)
 }
 } // namespace
 
-void EnvWorker::prepareEnv(const QString &toolsRoot, const ToolDTO &tool)
+void EnvWorker::prepareEnv(const QString &toolsRoot, const ToolHandle &toolHandle)
 {
-    const QString toolDir = QDir(toolsRoot).filePath(tool.id);
+    const ToolDTO &tool = *toolHandle;
+    const QString toolDir = tool.toolDir.isEmpty() ? QDir(toolsRoot).filePath(tool.id) : tool.toolDir;
     QString envPath;
     QString message;
 
@@ -9,7 +9,7 @@ class EnvWorker : public QObject
 {
     Q_OBJECT
 public slots:
-    void prepareEnv(const QString &toolsRoot, const ToolDTO &tool);
+    void prepareEnv(const QString &toolsRoot, const ToolHandle &toolHandle);
 
 signals:
     void envReady(const QString &toolId, const QString &envPath);
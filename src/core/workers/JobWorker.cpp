@@ -1,13 +1,30 @@
 #include "JobWorker.h"
 
+#include "core/ArgTemplate.h"
+#include "core/OutputFramer.h"
+#include "core/ProcessControl.h"
+#include "core/RunCache.h"
+#include "core/RunMetadata.h"
+#include "core/RunProgress.h"
+#include "core/ToolServer.h"
+#include "core/workers/LogWriter.h"
+
 #include <QDateTime>
 #include <QDir>
-#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonObject>
 #include <QLoggingCategory>
 #include <QProcess>
 #include <QProcessEnvironment>
 #include <QRegularExpression>
 #include <QTextStream>
+#include <QThreadPool>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <chrono>
 
 Q_LOGGING_CATEGORY(logJob, "core.job")
 
@@ -33,7 +50,8 @@ QString quoteArg(const QString &arg)
     }
     return escaped;
 #else
-    if (arg.contains(QRegularExpression(QStringLiteral("[\\s\"']"))))
+    static const QRegularExpression needsQuotes(QStringLiteral("[\\s\"']"));
+    if (arg.contains(needsQuotes))
     {
         QString escaped = arg;
         escaped.replace('\'', QStringLiteral("'\"'\"'"));
@@ -54,97 +72,75 @@ QString joinCommandForShell(const QString &program, const QStringList &args)
     return parts.join(QLatin1Char(' '));
 }
 
-QMap<QString, QStringList> toParamMap(const QList<RunParamValueDTO> &params)
-{
-    QMap<QString, QStringList> map;
-    for (const auto &p : params)
-    {
-        map.insert(p.key, p.values);
-    }
-    return map;
-}
-
-QString applyTemplate(QString token,
-                      const QMap<QString, QStringList> &paramMap,
-                      const QString &runDir,
-                      const QString &outputDir,
-                      const QString &toolDir,
-                      const RuntimeConfigDTO &runtime)
-{
-    auto firstParam = [&](const QString &key) {
-        const QStringList vals = paramMap.value(key);
-        return vals.isEmpty() ? QString() : vals.first();
-    };
-
-    token.replace(QStringLiteral("{{run.outputs}}"), outputDir);
-    token.replace(QStringLiteral("{{run.dir}}"), runDir);
-    token.replace(QStringLiteral("{{tool.root}}"), toolDir);
-    token.replace(QStringLiteral("{{runtime.workdir}}"), runtime.workdir);
-
-    QRegularExpression re(QStringLiteral(R"(\{\{\s*params\.([A-Za-z0-9_\-]+)\s*\}\})"));
-    auto it = re.globalMatch(token);
-    while (it.hasNext())
-    {
-        const auto m = it.next();
-        const QString key = m.captured(1);
-        token.replace(m.captured(0), firstParam(key));
-    }
-    return token;
-}
-
-QStringList renderToken(const QString &token,
-                        const QMap<QString, QStringList> &paramMap,
-                        const QString &runDir,
-                        const QString &outputDir,
-                        const QString &toolDir,
-                        const RuntimeConfigDTO &runtime)
+// Variables that differ on every run. A process started ahead of the run (a
+// warm interpreter, a tool server) gets them with the job instead.
+QMap<QString, QString> takeRunVariables(QProcessEnvironment &env)
 {
-    QRegularExpression single(QStringLiteral(R"(^\{\{\s*params\.([A-Za-z0-9_\-]+)\s*\}\}$)"));
-    const auto m = single.match(token);
-    if (m.hasMatch())
+    QMap<QString, QString> variables;
+    for (const QString &name : {QStringLiteral("TOOL_OUTPUT_DIR"), QStringLiteral("TOOL_RUN_DIR"), QStringLiteral("TOOL_SHARD_OUTPUTS")})
     {
-        const QStringList vals = paramMap.value(m.captured(1));
-        if (vals.isEmpty())
+        if (env.contains(name))
         {
-            return {QString()};
+            variables.insert(name, env.value(name));
+            env.remove(name);
         }
-        return vals;
     }
-
-    return {applyTemplate(token, paramMap, runDir, outputDir, toolDir, runtime)};
+    return variables;
 }
 
-QStringList expandArgs(const RuntimeConfigDTO &runtime,
-                       const QMap<QString, QStringList> &paramMap,
-                       const QString &runDir,
-                       const QString &outputDir,
-                       const QString &toolDir)
+QMap<QString, QStringList> toParamMap(const QList<RunParamValueDTO> &params)
 {
-    QStringList args;
-    for (const QString &tpl : runtime.args)
+    QMap<QString, QStringList> map;
+    for (const auto &p : params)
     {
-        args.append(renderToken(tpl, paramMap, runDir, outputDir, toolDir, runtime));
+        map.insert(p.key, p.values);
     }
-    return args;
+    return map;
 }
 } // namespace
 
-void JobWorker::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunRequestDTO &request, const QString &envPath)
+void JobWorker::runJob(const QString &runId, const QString &toolsRoot, const ToolHandle &toolHandle, const RunRequestDTO &request, const QString &envPath)
 {
-    if (m_process && m_process->state() != QProcess::NotRunning)
+    const ToolDTO &tool = *toolHandle;
+    if (m_runs.contains(runId))
     {
-        emit jobFinished(tool.id, -1, QStringLiteral("A job is already running"));
+        qWarning(logJob) << "Duplicate run id" << runId << "for" << tool.id;
         return;
     }
 
     const QString runDir = ensureRunDirectory(toolsRoot, tool, request);
+    if (runDir.isEmpty())
+    {
+        emit jobFinished(runId, tool.id, -1, QStringLiteral("Failed to create run directory"));
+        return;
+    }
     const QString outputDir = QDir(runDir).filePath(QStringLiteral("outputs"));
-    QDir().mkpath(outputDir);
 
-    m_notified = false;
-    m_process.reset(new QProcess());
-    m_process->setProcessChannelMode(QProcess::SeparateChannels);
-    wireProcessSignals(*m_process, tool.id, runDir);
+    // A server-mode run has no process of its own; ToolServer hosts it.
+    const bool serverMode = tool.runtime.server.enabled;
+    QProcess *process = nullptr;
+    if (!serverMode)
+    {
+        process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::SeparateChannels);
+    }
+    Run run;
+    run.toolId = tool.id;
+    run.process = process;
+    run.runDirectory = runDir;
+    run.stdoutLog = QDir(runDir).filePath(QStringLiteral("logs/stdout.log"));
+    run.stderrLog = QDir(runDir).filePath(QStringLiteral("logs/stderr.log"));
+    run.logBacklog = QSharedPointer<QAtomicInteger<qint64>>::create(0);
+    run.timeoutSeconds = tool.runtime.timeoutSeconds;
+    run.out.framer = QSharedPointer<OutputFramer>::create();
+    run.err.framer = QSharedPointer<OutputFramer>::create();
+    run.out.framer->setControlPrefix(RunProgress::linePrefix());
+    run.err.framer->setControlPrefix(RunProgress::linePrefix());
+    m_runs.insert(runId, run);
+    if (process)
+    {
+        wireProcessSignals(*process, runId);
+    }
 
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
     env.remove(QStringLiteral("PYTHONHOME"));
@@ -152,8 +148,18 @@ void JobWorker::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunR
     env.insert(QStringLiteral("PYTHONHOME"), QString());
     env.insert(QStringLiteral("PYTHONPATH"), QString());
     env.insert(QStringLiteral("TOOL_OUTPUT_DIR"), outputDir);
-    env.insert(QStringLiteral("TOOL_ROOT"), QDir(toolsRoot).filePath(tool.id));
+    const QString toolDir = tool.toolDir.isEmpty() ? QDir(toolsRoot).filePath(tool.id) : tool.toolDir;
+    env.insert(QStringLiteral("TOOL_ROOT"), toolDir);
     env.insert(QStringLiteral("TOOL_RUN_DIR"), runDir);
+    if (!m_toolLibraryDir.isEmpty())
+    {
+        env.insert(QStringLiteral("TOOLBOX_LIB"), m_toolLibraryDir);
+    }
+    env.insert(QStringLiteral("TOOLBOX_PROGRESS"), QStringLiteral("1"));
+    if (!request.shardOutputs.isEmpty())
+    {
+        env.insert(QStringLiteral("TOOL_SHARD_OUTPUTS"), request.shardOutputs.join(QDir::listSeparator()));
+    }
 
     for (auto it = tool.runtime.extraEnv.cbegin(); it != tool.runtime.extraEnv.cend(); ++it)
     {
@@ -163,11 +169,19 @@ void JobWorker::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunR
     QString program;
     QStringList args;
 
-    const QString toolDir = QDir(toolsRoot).filePath(tool.id);
     const QString entryPath = QDir(toolDir).filePath(tool.runtime.entry);
     const QString runtimeType = tool.runtime.type.trimmed().toLower();
-    const QMap<QString, QStringList> paramMap = toParamMap(request.params);
-    const QStringList templatedArgs = expandArgs(tool.runtime, paramMap, runDir, outputDir, toolDir);
+    // Tools decoded by ToolManifest carry their compiled args; a DTO built
+    // elsewhere is compiled here.
+    ArgTemplate uncompiled;
+    const ArgTemplate *argTemplate = tool.runtime.argTemplate.data();
+    if (!argTemplate)
+    {
+        QStringList ignored;
+        uncompiled = ArgTemplate::compile(tool.runtime.args, QStringLiteral("runtime.args"), {}, true, ignored);
+        argTemplate = &uncompiled;
+    }
+    const QStringList templatedArgs = argTemplate->expand({toParamMap(request.params), runDir, outputDir, toolDir, tool.runtime.workdir, request.shardOutputs, m_binaryPaths});
 
     if (runtimeType == QStringLiteral("python"))
     {
@@ -176,7 +190,6 @@ void JobWorker::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunR
                                         : (!envPath.isEmpty() ? pythonFromEnv(envPath) : QStringLiteral("python"));
         program = interpreter;
         args << entryPath;
-        args << templatedArgs;
 
         if (!envPath.isEmpty())
         {
@@ -193,7 +206,6 @@ void JobWorker::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunR
     {
         program = tool.env.interpreterPath.isEmpty() ? QStringLiteral("Rscript") : tool.env.interpreterPath;
         args << entryPath;
-        args << templatedArgs;
         if (!envPath.isEmpty())
         {
             env.insert(QStringLiteral("R_LIBS_USER"), envPath);
@@ -202,10 +214,63 @@ void JobWorker::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunR
     else // generic
     {
         program = entryPath;
-        args = templatedArgs;
     }
+    const QStringList launchArgs = args; // without the templated args
+    args << templatedArgs;
 
-    if (tool.runtime.shellWrap)
+    // runtime.warm: a pre-started interpreter gets the run-specific variables
+    // with its job; everything else it was started with. Limits apply at
+    // start-up, so tools with limits always start cold.
+    if (tool.runtime.warm.enabled && !serverMode && WarmPool::supports(runtimeType) && !tool.runtime.shellWrap && !tool.runtime.limits.any())
+    {
+        Run &pending = m_runs[runId];
+        pending.warm = true;
+        pending.warmSpec.runtime = runtimeType;
+        pending.warmSpec.program = program;
+        pending.warmSpec.preload = tool.runtime.warm.preload;
+        pending.warmSpec.size = tool.runtime.warm.size;
+        pending.warmSpec.envStamp = tool.env.dependencies.join(QLatin1Char('\n')) + QLatin1Char('\n') + tool.env.setup.command;
+        QProcessEnvironment shared = env;
+        pending.warmJob.variables = takeRunVariables(shared);
+        pending.warmSpec.environment = shared;
+        pending.warmJob.workdir = runDir;
+        pending.warmJob.entry = entryPath;
+        pending.warmJob.args = templatedArgs;
+    }
+
+    // runtime.mode: server: the server is started with the interpreter and
+    // entry only and runs in the tool directory; args, params and the run
+    // paths travel with each request.
+    if (serverMode)
+    {
+        ToolServer::Spec spec;
+        spec.program = program;
+        spec.args = launchArgs;
+        spec.environment = env;
+        const QMap<QString, QString> variables = takeRunVariables(spec.environment);
+        spec.workdir = toolDir;
+        spec.limits = tool.runtime.limits;
+        spec.config = tool.runtime.server;
+
+        QJsonObject requestEnv;
+        for (auto it = variables.cbegin(); it != variables.cend(); ++it)
+        {
+            requestEnv.insert(it.key(), it.value());
+        }
+        QJsonObject serverRequest;
+        serverRequest.insert(QStringLiteral("args"), QJsonArray::fromStringList(templatedArgs));
+        serverRequest.insert(QStringLiteral("params"), RunMetadata::paramsToJson(request.params));
+        serverRequest.insert(QStringLiteral("runDir"), runDir);
+        serverRequest.insert(QStringLiteral("outputDir"), outputDir);
+        serverRequest.insert(QStringLiteral("env"), requestEnv);
+
+        Run &pending = m_runs[runId];
+        pending.server = serverFor(tool.id, spec);
+        pending.serverRequest = serverRequest;
+        args = launchArgs;
+    }
+
+    if (tool.runtime.shellWrap && !serverMode)
     {
         const QString commandLine = joinCommandForShell(program, args);
 #ifdef Q_OS_WIN
@@ -217,26 +282,244 @@ void JobWorker::runJob(const QString &toolsRoot, const ToolDTO &tool, const RunR
 #endif
     }
 
-    m_process->setProcessEnvironment(env);
-    m_process->setWorkingDirectory(runDir);
+    if (process)
+    {
+        ProcessControl::prepare(*process, tool.runtime.limits, program, args);
+        process->setProcessEnvironment(env);
+        process->setWorkingDirectory(runDir);
+    }
+
+    const QString commandLine = joinCommandForShell(program, args);
+    RunMetadata::writeCommand(runDir, commandLine);
+    QJsonObject metadata;
+    metadata.insert(QStringLiteral("runId"), runId);
+    metadata.insert(QStringLiteral("toolId"), tool.id);
+    metadata.insert(QStringLiteral("version"), tool.version);
+    metadata.insert(QStringLiteral("command"), commandLine);
+    metadata.insert(QStringLiteral("params"), RunMetadata::paramsToJson(request.params));
+    metadata.insert(QStringLiteral("envPath"), envPath);
+    if (serverMode)
+    {
+        metadata.insert(QStringLiteral("server"), true);
+    }
+    metadata.insert(QStringLiteral("startedAt"), QDateTime::currentDateTime().toString(Qt::ISODateWithMs));
+    RunMetadata::writeMetadata(runDir, metadata);
+    m_runs[runId].metadata = metadata;
+
+    if (process)
+    {
+        process->setProgram(program);
+        process->setArguments(args);
+    }
+    emit jobStarted(runId, tool.id, runDir);
+
+    if (tool.runtime.cache)
+    {
+        // Run paths differ on every run; key on the placeholders instead.
+        RunCache::KeyInput input{toolHandle, toolDir, envPath, {}, request.params};
+        for (QString arg : templatedArgs)
+        {
+            input.args << arg.replace(outputDir, QStringLiteral("{{run.outputs}}")).replace(runDir, QStringLiteral("{{run.dir}}"));
+        }
+        m_runs[runId].cacheRoot = RunCache::cacheRoot(toolsRoot);
+        lookupCache(runId, input);
+        return;
+    }
+    launch(runId);
+}
+
+void JobWorker::launch(const QString &runId)
+{
+    const auto it = m_runs.find(runId);
+    if (it == m_runs.end())
+    {
+        return;
+    }
+    it->launched = true;
+    // Queued calls from this thread reach the writer in order, so open, write
+    // and close need no further synchronisation.
+    QMetaObject::invokeMethod(m_logWriter, "open", Qt::QueuedConnection, Q_ARG(QString, it->stdoutLog));
+    QMetaObject::invokeMethod(m_logWriter, "open", Qt::QueuedConnection, Q_ARG(QString, it->stderrLog));
+
+    if (it->server)
+    {
+        qInfo(logJob) << "Submitting" << runId << it->toolId << "to its tool server";
+        it->server->submit(runId, it->serverRequest);
+        return;
+    }
 
-    emit jobStarted(tool.id, runDir);
-    m_process->start(program, args);
+    if (it->warm)
+    {
+        if (!m_warmPool)
+        {
+            m_warmPool = new WarmPool(this);
+        }
+        if (QProcess *warm = m_warmPool->take(it->warmSpec, this))
+        {
+            it->process->deleteLater(); // never started
+            it->process = warm;
+            it->metadata.insert(QStringLiteral("warm"), true);
+            wireProcessSignals(*warm, runId);
+            qInfo(logJob) << "Dispatching" << runId << it->toolId << "to warm interpreter" << warm->processId() << "runDir" << it->runDirectory;
+            WarmPool::dispatch(*warm, it->warmJob);
+            handleStarted(runId);
+            return;
+        }
+    }
+
+    QProcess *process = it->process;
+    qInfo(logJob) << "Starting" << runId << it->toolId << "program" << process->program() << "args" << process->arguments() << "runDir" << it->runDirectory;
+    // Startup failures arrive through errorOccurred; blocking in waitForStarted
+    // here would stall every other run on this thread.
+    process->start();
+}
+
+void JobWorker::lookupCache(const QString &runId, const RunCache::KeyInput &input)
+{
+    struct Lookup
+    {
+        QString key;
+        bool hit{false};
+        QJsonObject entry;
+    };
+    const QString cacheRoot = m_runs.value(runId).cacheRoot;
+    const QString runDir = m_runs.value(runId).runDirectory;
+
+    // Hashing inputs can take a while; keep it off this thread, which serves
+    // the output of every other run.
+    auto *watcher = new QFutureWatcher<Lookup>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, runId]()
+            {
+        const Lookup lookup = watcher->result();
+        watcher->deleteLater();
+        const auto it = m_runs.find(runId);
+        if (it == m_runs.end())
+        {
+            return; // cancelled while hashing
+        }
+        it->cacheKey = lookup.key;
+        if (!lookup.hit)
+        {
+            launch(runId);
+            return;
+        }
+        QJsonObject cache;
+        cache.insert(QStringLiteral("key"), lookup.key);
+        cache.insert(QStringLiteral("sourceRunId"), lookup.entry.value(QStringLiteral("runId")));
+        cache.insert(QStringLiteral("sourceRunDirectory"), lookup.entry.value(QStringLiteral("runDirectory")));
+        it->metadata.insert(QStringLiteral("cache"), cache);
+        emit jobOutput(runId, it->toolId, {QStringLiteral("Reused the result of %1 (cache key %2)").arg(lookup.entry.value(QStringLiteral("runId")).toString(), lookup.key.left(12))}, false);
+        finishRun(runId, 0, QString::fromLatin1(kCachedMessage));
+    });
+    watcher->setFuture(QtConcurrent::run([input, cacheRoot, runDir]()
+                                         {
+        Lookup lookup;
+        lookup.key = RunCache::computeKey(input);
+        lookup.hit = RunCache::restore(cacheRoot, lookup.key, runDir, lookup.entry);
+        return lookup; }));
+}
 
-    if (!m_process->waitForStarted(5000))
+ToolServer *JobWorker::serverFor(const QString &toolId, const ToolServer::Spec &spec)
+{
+    // Keyed by everything the server is started with: an edited tool.yaml
+    // gets a fresh server and the old one runs into its idle timeout.
+    ToolServer *&server = m_servers[ToolServer::keyOf(toolId, spec)];
+    if (server)
+    {
+        return server;
+    }
+    server = new ToolServer(toolId, spec, this);
+    connect(server, &ToolServer::requestStarted, this, &JobWorker::handleStarted);
+    connect(server, &ToolServer::requestOutput, this, [this](const QString &runId, const QByteArray &data, bool isError)
+            {
+        const auto it = m_runs.find(runId);
+        if (it == m_runs.end())
+        {
+            return;
+        }
+        writeLog(runId, *it, isError, data);
+        handleOutput(runId, isError, data); });
+    connect(server, &ToolServer::requestFinished, this, [this](const QString &runId, int exitCode, const QString &message)
+            {
+        // As for a process: a stopped run never reads as success.
+        const QString stopReason = m_runs.value(runId).stopReason;
+        finishRun(runId, stopReason.isEmpty() ? exitCode : -1, stopReason.isEmpty() ? message : stopReason); });
+    return server;
+}
+
+void JobWorker::cancel(const QString &runId)
+{
+    stop(runId, QStringLiteral("cancelled"));
+}
+
+void JobWorker::cancelAll()
+{
+    const QStringList runIds = m_runs.keys();
+    for (const QString &runId : runIds)
+    {
+        stop(runId, QStringLiteral("cancelled"));
+    }
+}
+
+void JobWorker::stop(const QString &runId, const QString &reason)
+{
+    const auto it = m_runs.find(runId);
+    if (it == m_runs.end() || !it->stopReason.isEmpty())
     {
-        const QString err = m_process->errorString();
-        emit jobFinished(tool.id, -1, QStringLiteral("Failed to start: %1").arg(err));
         return;
     }
-    qInfo(logJob) << "Started" << tool.id << "program" << program << "args" << args << "runDir" << runDir;
+    if (!it->launched)
+    {
+        // Still looking up the cache; there is no process to stop yet.
+        finishRun(runId, -1, reason);
+        return;
+    }
+    if (it->server)
+    {
+        qInfo(logJob) << "Stopping" << runId << reason;
+        it->stopReason = reason;
+        it->server->cancel(runId);
+        return;
+    }
+    if (it->process->state() == QProcess::NotRunning)
+    {
+        return;
+    }
+    qInfo(logJob) << "Stopping" << runId << reason;
+    it->stopReason = reason;
+    QProcess *process = it->process;
+    ProcessControl::terminate(*process);
+    QTimer::singleShot(kKillGraceMs, process, [process, runId]()
+                       {
+        if (process->state() != QProcess::NotRunning)
+        {
+            qWarning(logJob) << "Killing" << runId << "after it ignored the stop request";
+            ProcessControl::kill(*process);
+        } });
 }
 
-void JobWorker::cancel()
+QString JobWorker::createRunDirectory(const QString &toolsRoot, const QString &toolId)
 {
-    if (m_process && m_process->state() != QProcess::NotRunning)
+    // runs/<timestamp>_<toolId>_<seq>: mkdir fails on an existing directory,
+    // so concurrent runs started within the same second each claim their own
+    // seq instead of sharing a folder.
+    const QDir runsDir(QDir(toolsRoot).filePath(QStringLiteral("runs")));
+    if (!runsDir.mkpath(QStringLiteral(".")))
+    {
+        return QString();
+    }
+    const QString stem = QStringLiteral("%1_%2").arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd_hh-mm-ss")), toolId);
+    for (int seq = 1;; ++seq)
     {
-        m_process->terminate();
+        const QString candidate = runsDir.filePath(QStringLiteral("%1_%2").arg(stem).arg(seq));
+        if (runsDir.mkdir(candidate))
+        {
+            return QDir(candidate).absolutePath();
+        }
+        if (!QFileInfo::exists(candidate))
+        {
+            return QString();
+        }
     }
 }
 
@@ -245,71 +528,384 @@ QString JobWorker::ensureRunDirectory(const QString &toolsRoot, const ToolDTO &t
     QString runDir = request.runDirectory;
     if (runDir.isEmpty())
     {
-        const QString timestamp = QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd_hh-mm-ss"));
-        runDir = QDir(toolsRoot).filePath(QStringLiteral("runs/%1_%2").arg(timestamp, tool.id));
+        runDir = createRunDirectory(toolsRoot, tool.id);
+        if (runDir.isEmpty())
+        {
+            return QString();
+        }
+    }
+    else if (!QDir().mkpath(runDir))
+    {
+        return QString();
     }
 
-    QDir().mkpath(runDir);
     QDir(runDir).mkpath(QStringLiteral("logs"));
     QDir(runDir).mkpath(QStringLiteral("outputs"));
     return QDir(runDir).absolutePath();
 }
 
-void JobWorker::wireProcessSignals(QProcess &process, const QString &toolId, const QString &runDir)
+void JobWorker::wireProcessSignals(QProcess &process, const QString &runId)
 {
-    auto stdoutPath = QDir(runDir).filePath(QStringLiteral("logs/stdout.log"));
-    auto stderrPath = QDir(runDir).filePath(QStringLiteral("logs/stderr.log"));
-
-    auto *stdoutFile = new QFile(stdoutPath, &process);
-    auto *stderrFile = new QFile(stderrPath, &process);
-    stdoutFile->open(QIODevice::WriteOnly | QIODevice::Text);
-    stderrFile->open(QIODevice::WriteOnly | QIODevice::Text);
-
-    QObject::connect(&process, &QProcess::readyReadStandardOutput, &process, [this, &process, stdoutFile, toolId]()
+    const QString toolId = m_runs.value(runId).toolId;
+    // Drain QProcess on every notification so its read buffer never grows;
+    // the log file is the lossless copy, the UI only gets what fits the budget.
+    // A log writer that falls behind suspends the process instead (writeLog).
+    QObject::connect(&process, &QProcess::readyReadStandardOutput, &process, [this, &process, runId]()
                      {
         const QByteArray data = process.readAllStandardOutput();
-        stdoutFile->write(data);
-        stdoutFile->flush();
-        const QString text = QString::fromUtf8(data);
-        const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
-        for (const QString &line : lines)
+        const auto it = m_runs.find(runId);
+        if (it != m_runs.end())
         {
-            emit jobOutput(toolId, line.trimmed(), false);
-        } });
+            writeLog(runId, *it, false, data);
+        }
+        handleOutput(runId, false, data); });
 
-    QObject::connect(&process, &QProcess::readyReadStandardError, &process, [this, &process, stderrFile, toolId]()
+    QObject::connect(&process, &QProcess::readyReadStandardError, &process, [this, &process, runId]()
                      {
         const QByteArray data = process.readAllStandardError();
-        stderrFile->write(data);
-        stderrFile->flush();
-        const QString text = QString::fromUtf8(data);
-        const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
-        for (const QString &line : lines)
+        const auto it = m_runs.find(runId);
+        if (it != m_runs.end())
         {
-            emit jobOutput(toolId, line.trimmed(), true);
-        } });
+            writeLog(runId, *it, true, data);
+        }
+        handleOutput(runId, true, data); });
+
+    QObject::connect(&process, &QProcess::started, &process, [this, runId]()
+                     { handleStarted(runId); });
+
+    // stdout closes as the process exits, usually just before it is reaped:
+    // the last chance to read its final counters from /proc.
+    QObject::connect(&process, &QProcess::readChannelFinished, &process, [this]()
+                     { m_sampler.sample(); });
 
     QObject::connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &process,
-                     [this, stdoutFile, stderrFile, toolId](int exitCode, QProcess::ExitStatus status)
+                     [this, runId, toolId](int exitCode, QProcess::ExitStatus status)
                      {
-                         stdoutFile->close();
-                         stderrFile->close();
-                         if (m_notified)
-                             return;
-                         m_notified = true;
-                         const QString message = status == QProcess::NormalExit
-                                                     ? QStringLiteral("exit %1").arg(exitCode)
-                                                     : QStringLiteral("crashed");
-                         emit jobFinished(toolId, exitCode, message);
-                         qInfo(logJob) << "Finished" << toolId << "exit" << exitCode << "status" << (status == QProcess::NormalExit);
+                         const QString stopReason = m_runs.value(runId).stopReason;
+                         QString message = status == QProcess::NormalExit
+                                               ? QStringLiteral("exit %1").arg(exitCode)
+                                               : QStringLiteral("crashed");
+                         qInfo(logJob) << "Finished" << runId << toolId << "exit" << exitCode << "status" << (status == QProcess::NormalExit);
+                         // The exit code of a crashed process is meaningless, and a stopped
+                         // run did not complete even if it exited cleanly on SIGTERM;
+                         // never let either read as success.
+                         if (!stopReason.isEmpty())
+                         {
+                             message = stopReason;
+                             exitCode = -1;
+                         }
+                         else if (status != QProcess::NormalExit)
+                         {
+                             exitCode = -1;
+                         }
+                         finishRun(runId, exitCode, message);
                      });
 
-    QObject::connect(&process, &QProcess::errorOccurred, &process, [this, toolId](QProcess::ProcessError error) {
-        if (m_notified)
-            return;
-        m_notified = true;
-        const QString msg = QStringLiteral("Process error: %1").arg(static_cast<int>(error));
-        emit jobFinished(toolId, -1, msg);
-        qWarning(logJob) << "Error" << toolId << msg;
+    QObject::connect(&process, &QProcess::errorOccurred, &process, [this, &process, runId, toolId](QProcess::ProcessError error) {
+        const QString msg = error == QProcess::FailedToStart
+                                ? QStringLiteral("Failed to start: %1").arg(process.errorString())
+                                : QStringLiteral("Process error: %1").arg(static_cast<int>(error));
+        qWarning(logJob) << "Error" << runId << toolId << msg;
+        // A crash is still followed by finished(); only a failed start ends the
+        // run here.
+        if (error == QProcess::FailedToStart)
+        {
+            finishRun(runId, -1, msg);
+        }
     });
 }
+
+void JobWorker::finishRun(const QString &runId, int exitCode, const QString &message)
+{
+    const auto it = m_runs.find(runId);
+    if (it == m_runs.end())
+    {
+        return;
+    }
+    Run run = *it;
+    m_runs.erase(it);
+    // Deliver the tail of the output (including an unterminated last line and
+    // the count of anything dropped) before the finish notification.
+    run.out.framer->finish();
+    run.err.framer->finish();
+    applyProgress(run, run.out.framer->takeControlLines() + run.err.framer->takeControlLines());
+    run.sampling = false;
+    flushOutput(runId, run);
+
+    run.metadata.insert(QStringLiteral("finishedAt"), QDateTime::currentDateTime().toString(Qt::ISODateWithMs));
+    run.metadata.insert(QStringLiteral("exitCode"), exitCode);
+    run.metadata.insert(QStringLiteral("message"), message);
+    RunMetricsDTO metrics = m_sampler.take(runId);
+    if (m_sampler.isEmpty() && m_metricsTimer)
+    {
+        m_metricsTimer->stop();
+    }
+    if (run.clock.isValid())
+    {
+        metrics.wallMs = run.clock.elapsed();
+        run.metadata.insert(QStringLiteral("metrics"), RunMetadata::metricsToJson(metrics));
+    }
+    if (run.progressReported)
+    {
+        run.metadata.insert(QStringLiteral("progress"), RunProgress::toJson(run.progress));
+    }
+    RunMetadata::writeMetadata(run.runDirectory, run.metadata);
+
+    if (run.clock.isValid())
+    {
+        emit jobMetrics(runId, run.toolId, metrics);
+    }
+    QMetaObject::invokeMethod(m_logWriter, "close", Qt::QueuedConnection, Q_ARG(QString, run.stdoutLog));
+    QMetaObject::invokeMethod(m_logWriter, "close", Qt::QueuedConnection, Q_ARG(QString, run.stderrLog));
+    // Queued after the closes above, so the copy sees fully flushed logs.
+    if (!run.cacheKey.isEmpty() && run.launched && run.stopReason.isEmpty() && exitCode == 0)
+    {
+        storeInCache(runId, run);
+    }
+    if (run.process)
+    {
+        run.process->deleteLater();
+    }
+    emit jobFinished(runId, run.toolId, exitCode, message);
+}
+
+void JobWorker::setOutputBudget(qint64 bytes)
+{
+    m_outputBudget = qMax<qint64>(64 * 1024, bytes);
+}
+
+void JobWorker::outputConsumed(const QString &runId, qint64 bytes)
+{
+    const auto it = m_runs.find(runId);
+    if (it == m_runs.end())
+    {
+        return;
+    }
+    it->inFlightBytes = qMax<qint64>(0, it->inFlightBytes - bytes);
+    // Resume at the low-water mark, not right under the budget, so a tool that
+    // keeps outpacing the UI does not flip between states on every batch.
+    if (it->sampling && it->inFlightBytes <= m_outputBudget / 4)
+    {
+        it->sampling = false;
+        qInfo(logJob) << "Output of" << runId << "resumed after dropping" << it->out.omittedLines + it->err.omittedLines << "lines";
+        scheduleOutputFlush();
+    }
+}
+
+void JobWorker::writeLog(const QString &runId, Run &run, bool isError, const QByteArray &data)
+{
+    if (data.isEmpty())
+    {
+        return;
+    }
+    const qint64 size = data.size();
+    const qint64 backlog = run.logBacklog->fetchAndAddRelaxed(size) + size;
+    LogWriter *writer = m_logWriter;
+    const QString path = isError ? run.stderrLog : run.stdoutLog;
+    const QSharedPointer<QAtomicInteger<qint64>> counter = run.logBacklog;
+    QMetaObject::invokeMethod(m_logWriter, [writer, path, data, counter, size]()
+                              {
+        writer->write(path, data);
+        counter->fetchAndSubRelaxed(size); }, Qt::QueuedConnection);
+
+    if (backlog <= kLogHighWater || run.logSuspended || !run.process)
+    {
+        return;
+    }
+    // Server-mode runs share their process and are not paused.
+    if (!ProcessControl::suspend(*run.process))
+    {
+        return;
+    }
+    qInfo(logJob) << "Log writer is" << backlog << "bytes behind" << runId << "; suspending it until the logs catch up";
+    run.logSuspended = true;
+    resumeWhenLogDrained(runId);
+}
+
+void JobWorker::resumeWhenLogDrained(const QString &runId)
+{
+    const auto it = m_runs.find(runId);
+    if (it == m_runs.end() || !it->logSuspended || !it->process)
+    {
+        return;
+    }
+    if (it->logBacklog->loadRelaxed() > kLogHighWater / 4)
+    {
+        QTimer::singleShot(kLogDrainPollMs, it->process, [this, runId]()
+                           { resumeWhenLogDrained(runId); });
+        return;
+    }
+    it->logSuspended = false;
+    ProcessControl::resume(*it->process);
+    qInfo(logJob) << "Resumed" << runId << "after the log writer caught up";
+}
+
+void JobWorker::handleOutput(const QString &runId, bool isError, const QByteArray &data)
+{
+    const auto it = m_runs.find(runId);
+    if (it == m_runs.end())
+    {
+        return;
+    }
+    Stream &stream = isError ? it->err : it->out;
+    stream.framer->append(data);
+    if (stream.framer->hasControlLines())
+    {
+        applyProgress(*it, stream.framer->takeControlLines());
+        scheduleOutputFlush();
+    }
+    if (!stream.framer->hasLines())
+    {
+        return;
+    }
+
+    if (!it->sampling && it->inFlightBytes + it->out.framer->pendingBytes() + it->err.framer->pendingBytes() > m_outputBudget)
+    {
+        qInfo(logJob) << "Output of" << runId << "exceeds the UI budget; dropping lines until it drains";
+        it->sampling = true;
+    }
+    if (it->sampling)
+    {
+        stream.omittedLines += stream.framer->takeLines().size();
+        return;
+    }
+    scheduleOutputFlush();
+}
+
+void JobWorker::setResultCacheLimit(qint64 bytes)
+{
+    m_cacheMaxBytes = qMax<qint64>(0, bytes);
+}
+
+void JobWorker::storeInCache(const QString &runId, const Run &run)
+{
+    QJsonObject entry;
+    entry.insert(QStringLiteral("runId"), runId);
+    entry.insert(QStringLiteral("toolId"), run.toolId);
+    entry.insert(QStringLiteral("runDirectory"), run.runDirectory);
+    const QString cacheRoot = run.cacheRoot;
+    const QString key = run.cacheKey;
+    const QString runDir = run.runDirectory;
+    const qint64 maxBytes = m_cacheMaxBytes;
+    // Hop through the log writer so the copy starts only after it has closed
+    // this run's logs (calls from here reach it in order), then leave the
+    // copying to the pool.
+    QMetaObject::invokeMethod(m_logWriter, [cacheRoot, key, runDir, entry, maxBytes]()
+                              { QThreadPool::globalInstance()->start([cacheRoot, key, runDir, entry, maxBytes]()
+                                                                     { RunCache::store(cacheRoot, key, runDir, entry, maxBytes); }); }, Qt::QueuedConnection);
+}
+
+void JobWorker::handleStarted(const QString &runId)
+{
+    const auto it = m_runs.find(runId);
+    if (it == m_runs.end())
+    {
+        return;
+    }
+    qInfo(logJob) << "Started" << runId << it->toolId;
+    if (it->timeoutSeconds > 0)
+    {
+        // Counted from start-up; the timer dies with the process.
+        const int timeout = it->timeoutSeconds;
+        QObject *context = it->process ? static_cast<QObject *>(it->process) : this;
+        QTimer::singleShot(std::chrono::seconds(timeout), context, [this, runId, timeout]()
+                           { stop(runId, QStringLiteral("timed out after %1 s").arg(timeout)); });
+    }
+    it->clock.start();
+    if (!it->process)
+    {
+        return; // a tool server's process is shared; only wall time is recorded
+    }
+    // ProcessControl::prepare made the process the leader of its own group.
+    m_sampler.watch(runId, it->process->processId());
+    if (!ProcessSampler::supported())
+    {
+        return;
+    }
+    if (!m_metricsTimer)
+    {
+        m_metricsTimer = new QTimer(this);
+        m_metricsTimer->setInterval(kMetricsSampleMs);
+        connect(m_metricsTimer, &QTimer::timeout, this, [this]()
+                { m_sampler.sample(); });
+    }
+    if (!m_metricsTimer->isActive())
+    {
+        m_metricsTimer->start();
+    }
+}
+
+void JobWorker::scheduleOutputFlush()
+{
+    if (!m_flushTimer)
+    {
+        m_flushTimer = new QTimer(this);
+        m_flushTimer->setSingleShot(true);
+        m_flushTimer->setInterval(kOutputFlushMs);
+        connect(m_flushTimer, &QTimer::timeout, this, qOverload<>(&JobWorker::flushOutput));
+    }
+    // Single-shot and not restarted while pending: a chatty tool produces at
+    // most one batch per stream every kOutputFlushMs.
+    if (!m_flushTimer->isActive())
+    {
+        m_flushTimer->start();
+    }
+}
+
+void JobWorker::flushOutput()
+{
+    for (auto it = m_runs.begin(); it != m_runs.end(); ++it)
+    {
+        flushOutput(it.key(), it.value());
+    }
+}
+
+void JobWorker::flushOutput(const QString &runId, Run &run)
+{
+    // Progress is a snapshot, not a stream: only the latest state is sent,
+    // at most once per flush, and the output budget does not hold it back.
+    if (run.progressChanged)
+    {
+        run.progressChanged = false;
+        emit jobProgress(runId, run.toolId, run.progress);
+    }
+    if (run.sampling)
+    {
+        return;
+    }
+    flushStream(runId, run, false);
+    flushStream(runId, run, true);
+}
+
+void JobWorker::applyProgress(Run &run, const QStringList &reports)
+{
+    const qint64 elapsedMs = run.clock.isValid() ? run.clock.elapsed() : 0;
+    for (const QString &report : reports)
+    {
+        if (RunProgress::apply(report, elapsedMs, run.progress))
+        {
+            run.progressChanged = true;
+            run.progressReported = true;
+        }
+    }
+}
+
+void JobWorker::flushStream(const QString &runId, Run &run, bool isError)
+{
+    Stream &stream = isError ? run.err : run.out;
+    if (!stream.framer->hasLines() && stream.omittedLines == 0)
+    {
+        return;
+    }
+    QStringList lines;
+    if (stream.omittedLines > 0)
+    {
+        lines << QStringLiteral("[%1 lines not shown; full output in logs/%2]")
+                     .arg(stream.omittedLines)
+                     .arg(isError ? QStringLiteral("stderr.log") : QStringLiteral("stdout.log"));
+        stream.omittedLines = 0;
+    }
+    lines << stream.framer->takeLines();
+    run.inFlightBytes += OutputFramer::byteSize(lines);
+    emit jobOutput(runId, run.toolId, lines, isError);
+}
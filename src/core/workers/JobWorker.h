@@ -1,28 +1,148 @@
 #pragma once
 
 #include "common/Dto.h"
+#include "core/ProcessSampler.h"
+#include "core/RunCache.h"
+#include "core/ToolServer.h"
+#include "core/WarmPool.h"
 
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
 #include <QObject>
 #include <QProcess>
-#include <QScopedPointer>
+#include <QSharedPointer>
 #include <QString>
+#include <QStringList>
 
+class LogWriter;
+class OutputFramer;
+class QTimer;
+
+// Runs any number of tool processes side by side on the job thread. Admission
+// (queueing, the concurrency limit) is decided by CoreService; every run is
+// identified by the runId it was submitted with. Output is framed into lines
+// per stream and delivered in batches at most every kOutputFlushMs. The UI
+// path is bounded per run: once more than the output budget is emitted but
+// not yet acknowledged through outputConsumed(), lines are dropped until the
+// consumer drains below a quarter of it. logs/*.log get everything, up to
+// the LogWriter size cap; when more than kLogHighWater of a run's output is
+// queued for the LogWriter, the run's process group is suspended until the
+// backlog drops below a quarter of that, much as a full pipe would block it.
 class JobWorker : public QObject
 {
     Q_OBJECT
+public:
+    static constexpr int kOutputFlushMs = 16;
+    static constexpr qint64 kDefaultOutputBudget = 4 * 1024 * 1024;
+    static constexpr qint64 kLogHighWater = 16 * 1024 * 1024;
+    static constexpr int kLogDrainPollMs = 20;
+    // Time a stopped or timed-out run gets between terminate and kill.
+    static constexpr int kKillGraceMs = 5000;
+    static constexpr int kMetricsSampleMs = 500;
+    static constexpr qint64 kDefaultResultCacheLimit = 2LL * 1024 * 1024 * 1024;
+    // jobFinished message of a run answered from the runtime.cache store
+    // without launching anything.
+    static constexpr const char kCachedMessage[] = "cached";
+
+    // Claims a fresh runs/<timestamp>_<toolId>_<seq> directory under toolsRoot;
+    // returns its absolute path, or an empty string on failure.
+    static QString createRunDirectory(const QString &toolsRoot, const QString &toolId);
+
+    // logs/stdout.log and logs/stderr.log are written through writer, which
+    // lives on another thread. Must be set before the worker is moved.
+    void setLogWriter(LogWriter *writer) { m_logWriter = writer; }
+    // Exported to runs as TOOLBOX_LIB. Must be set before the worker is moved.
+    void setToolLibraryDir(const QString &dir) { m_toolLibraryDir = dir; }
+    // {{config.bin.<name>}} in runtime.args. Must be set before the worker is moved.
+    void setBinaryPaths(const QMap<QString, QString> &paths) { m_binaryPaths = paths; }
+
 public slots:
-    void runJob(const QString &toolsRoot, const ToolDTO &tool, const RunRequestDTO &request, const QString &envPath);
-    void cancel();
+    void runJob(const QString &runId, const QString &toolsRoot, const ToolHandle &toolHandle, const RunRequestDTO &request, const QString &envPath);
+    void cancel(const QString &runId);
+    void cancelAll();
+    void setOutputBudget(qint64 bytes);
+    void outputConsumed(const QString &runId, qint64 bytes);
+    // Size bound of the runtime.cache result store (see RunCache).
+    void setResultCacheLimit(qint64 bytes);
 
 signals:
-    void jobStarted(const QString &toolId, const QString &runDirectory);
-    void jobOutput(const QString &toolId, const QString &line, bool isError);
-    void jobFinished(const QString &toolId, int exitCode, const QString &message);
+    void jobStarted(const QString &runId, const QString &toolId, const QString &runDirectory);
+    void jobOutput(const QString &runId, const QString &toolId, const QStringList &lines, bool isError);
+    // Emitted right before jobFinished for runs that got as far as starting.
+    void jobMetrics(const QString &runId, const QString &toolId, const RunMetricsDTO &metrics);
+    // Latest state of what the run reported through RunProgress, at most once
+    // per output flush.
+    void jobProgress(const QString &runId, const QString &toolId, const RunProgressDTO &progress);
+    void jobFinished(const QString &runId, const QString &toolId, int exitCode, const QString &message);
 
 private:
+    struct Stream
+    {
+        QSharedPointer<OutputFramer> framer;
+        qint64 omittedLines{0};
+    };
+
+    struct Run
+    {
+        QString toolId;
+        QProcess *process{nullptr}; // null for server-mode runs
+        ToolServer *server{nullptr}; // runtime.mode: server
+        QJsonObject serverRequest;
+        QString runDirectory;
+        bool launched{false}; // false while the cache lookup runs
+        QString cacheRoot;    // runtime.cache only
+        QString cacheKey;
+        QJsonObject metadata; // written at start, completed at finish
+        QElapsedTimer clock;  // started with the process
+        Stream out;
+        Stream err;
+        QString stdoutLog;
+        QString stderrLog;
+        int timeoutSeconds{0};   // armed once the process runs
+        bool warm{false};        // runtime.warm: try a pre-started interpreter first
+        WarmPool::Spec warmSpec;
+        WarmPool::Job warmJob;
+        QString stopReason;      // set once cancel or the timeout stopped the run
+        qint64 inFlightBytes{0}; // emitted but not yet acknowledged
+        // Bytes handed to the LogWriter that it has not taken yet; shared
+        // with the queued writes, which count them down on its thread.
+        QSharedPointer<QAtomicInteger<qint64>> logBacklog;
+        bool logSuspended{false};
+        bool sampling{false};    // over budget, lines go to the log files only
+        RunProgressDTO progress;
+        bool progressChanged{false};  // not yet emitted
+        bool progressReported{false}; // anything valid arrived at all
+    };
+
     QString ensureRunDirectory(const QString &toolsRoot, const ToolDTO &tool, const RunRequestDTO &request) const;
-    void wireProcessSignals(QProcess &process, const QString &toolId, const QString &runDir);
+    void wireProcessSignals(QProcess &process, const QString &runId);
+    ToolServer *serverFor(const QString &toolId, const ToolServer::Spec &spec);
+    void finishRun(const QString &runId, int exitCode, const QString &message);
+    void stop(const QString &runId, const QString &reason);
+    void launch(const QString &runId);
+    void lookupCache(const QString &runId, const RunCache::KeyInput &input);
+    void storeInCache(const QString &runId, const Run &run);
+    void handleStarted(const QString &runId);
+    void handleOutput(const QString &runId, bool isError, const QByteArray &data);
+    void writeLog(const QString &runId, Run &run, bool isError, const QByteArray &data);
+    void resumeWhenLogDrained(const QString &runId);
+    void scheduleOutputFlush();
+    void flushOutput();
+    void flushOutput(const QString &runId, Run &run);
+    void flushStream(const QString &runId, Run &run, bool isError);
+    void applyProgress(Run &run, const QStringList &reports);
 
-    QScopedPointer<QProcess> m_process;
-    bool m_notified{false};
+    QHash<QString, Run> m_runs;
+    QTimer *m_flushTimer{nullptr};
+    ProcessSampler m_sampler;
+    QTimer *m_metricsTimer{nullptr};
+    WarmPool *m_warmPool{nullptr};
+    QHash<QString, ToolServer *> m_servers; // by ToolServer::keyOf
+    qint64 m_cacheMaxBytes{kDefaultResultCacheLimit};
+    qint64 m_outputBudget{kDefaultOutputBudget};
+    LogWriter *m_logWriter{nullptr};
+    QString m_toolLibraryDir;
+    QMap<QString, QString> m_binaryPaths;
 };
@@ -0,0 +1,174 @@
+#include "LogWriter.h"
+
+#include <QFile>
+#include <QLoggingCategory>
+#include <QTimer>
+
+Q_LOGGING_CATEGORY(logLogs, "core.logs")
+
+namespace
+{
+constexpr QIODevice::OpenMode kOpenMode = QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered;
+
+QString rotatedPath(const QString &path, int index)
+{
+    return QStringLiteral("%1.%2").arg(path).arg(index);
+}
+} // namespace
+
+LogWriter::LogWriter(const LogOptionsDTO &options, QObject *parent)
+    : QObject(parent), m_options(options)
+{
+}
+
+LogWriter::~LogWriter()
+{
+    closeAll();
+}
+
+void LogWriter::open(const QString &path)
+{
+    close(path);
+    Log log;
+    // We buffer ourselves; QFile's own buffer would only add a copy.
+    log.file = QSharedPointer<QFile>::create(path);
+    if (!log.file->open(kOpenMode))
+    {
+        qWarning(logLogs) << "Cannot open log" << path << log.file->errorString();
+        return;
+    }
+    m_logs.insert(path, log);
+}
+
+void LogWriter::write(const QString &path, const QByteArray &data)
+{
+    const auto it = m_logs.find(path);
+    if (it == m_logs.end() || data.isEmpty())
+    {
+        return;
+    }
+    it->buffer.append(data);
+    if (it->buffer.size() >= m_options.bufferBytes)
+    {
+        flushLog(path, *it);
+        return;
+    }
+
+    if (!m_flushTimer)
+    {
+        m_flushTimer = new QTimer(this);
+        m_flushTimer->setSingleShot(true);
+        connect(m_flushTimer, &QTimer::timeout, this, &LogWriter::flushAll);
+    }
+    if (!m_flushTimer->isActive())
+    {
+        m_flushTimer->start(qMax(1, m_options.flushIntervalMs));
+    }
+}
+
+void LogWriter::close(const QString &path)
+{
+    const auto it = m_logs.find(path);
+    if (it == m_logs.end())
+    {
+        return;
+    }
+    flushLog(path, *it);
+    if (it->discarded > 0)
+    {
+        it->file->write(QStringLiteral("[%1 more bytes were not logged]\n").arg(it->discarded).toUtf8());
+        qInfo(logLogs) << "Log" << path << "was truncated;" << it->discarded << "bytes dropped";
+    }
+    it->file->close();
+    m_logs.erase(it);
+}
+
+void LogWriter::closeAll()
+{
+    const QStringList paths = m_logs.keys();
+    for (const QString &path : paths)
+    {
+        close(path);
+    }
+}
+
+void LogWriter::flushAll()
+{
+    for (auto it = m_logs.begin(); it != m_logs.end(); ++it)
+    {
+        flushLog(it.key(), it.value());
+    }
+}
+
+void LogWriter::flushLog(const QString &path, Log &log)
+{
+    if (log.buffer.isEmpty())
+    {
+        return;
+    }
+    writeBlock(path, log, log.buffer.constData(), log.buffer.size());
+    log.buffer.clear();
+}
+
+void LogWriter::writeBlock(const QString &path, Log &log, const char *data, qint64 size)
+{
+    while (size > 0)
+    {
+        if (log.truncated)
+        {
+            log.discarded += size;
+            return;
+        }
+
+        const qint64 room = m_options.maxBytes > 0 ? m_options.maxBytes - log.written : size;
+        if (room <= 0)
+        {
+            if (m_options.rotate && rotate(path, log))
+            {
+                continue;
+            }
+            log.file->write(QStringLiteral("\n[log truncated at %1 bytes]\n").arg(m_options.maxBytes).toUtf8());
+            log.truncated = true;
+            continue;
+        }
+
+        const qint64 written = log.file->write(data, qMin(room, size));
+        if (written <= 0)
+        {
+            qWarning(logLogs) << "Write to" << path << "failed:" << log.file->errorString();
+            log.truncated = true;
+            continue;
+        }
+        log.written += written;
+        data += written;
+        size -= written;
+    }
+}
+
+bool LogWriter::rotate(const QString &path, Log &log)
+{
+    if (m_options.keepRotated <= 0)
+    {
+        return false;
+    }
+    log.file->close();
+    QFile::remove(rotatedPath(path, m_options.keepRotated));
+    for (int i = m_options.keepRotated - 1; i >= 1; --i)
+    {
+        QFile::rename(rotatedPath(path, i), rotatedPath(path, i + 1));
+    }
+    if (!QFile::rename(path, rotatedPath(path, 1)))
+    {
+        // Keep what is there and fall back to truncation.
+        qWarning(logLogs) << "Cannot rotate" << path;
+        log.file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered);
+        return false;
+    }
+    if (!log.file->open(kOpenMode))
+    {
+        qWarning(logLogs) << "Cannot reopen rotated log" << path << log.file->errorString();
+        log.truncated = true;
+    }
+    log.written = 0;
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "common/Dto.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+
+class QFile;
+class QTimer;
+
+// Writes run logs on its own thread so the job thread never waits on disk.
+// Output is collected per file and written in large blocks: when a file's
+// buffer reaches bufferBytes, or at the latest flushIntervalMs after it was
+// first appended to. Files are capped at maxBytes, either truncated with a
+// marker line or rotated.
+class LogWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LogWriter(const LogOptionsDTO &options = LogOptionsDTO(), QObject *parent = nullptr);
+    ~LogWriter() override;
+
+public slots:
+    // Creates (or truncates) path. Writes to a path that is not open are dropped.
+    void open(const QString &path);
+    void write(const QString &path, const QByteArray &data);
+    void close(const QString &path);
+    // Writes out everything buffered and closes all files.
+    void closeAll();
+
+private:
+    struct Log
+    {
+        QSharedPointer<QFile> file;
+        QByteArray buffer;
+        qint64 written{0};   // bytes in the current file
+        qint64 discarded{0}; // bytes dropped after truncation
+        bool truncated{false};
+    };
+
+    void flushAll();
+    void flushLog(const QString &path, Log &log);
+    void writeBlock(const QString &path, Log &log, const char *data, qint64 size);
+    bool rotate(const QString &path, Log &log);
+
+    LogOptionsDTO m_options;
+    QHash<QString, Log> m_logs;
+    QTimer *m_flushTimer{nullptr};
+};
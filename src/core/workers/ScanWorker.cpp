@@ -1,243 +1,710 @@
 #include "ScanWorker.h"
 
+#include "core/StringPool.h"
+#include "core/ToolManifest.h"
+
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFuture>
+#include <QLoggingCategory>
+#include <QRegularExpression>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
 
-#include <yaml-cpp/yaml.h>
+Q_LOGGING_CATEGORY(logScan, "core.scan")
 
 namespace
 {
-QString toQString(const YAML::Node &node, const QString &fallback = QString())
+constexpr int kWatchDebounceMs = 300;
+constexpr int kStreamBatchSize = 64;
+constexpr int kStreamBatchIntervalMs = 50;
+
+#ifdef Q_OS_WIN
+constexpr Qt::CaseSensitivity kPathCase = Qt::CaseInsensitive;
+#else
+constexpr Qt::CaseSensitivity kPathCase = Qt::CaseSensitive;
+#endif
+
+struct IgnoreRules
 {
-    if (!node)
-    {
-        return fallback;
-    }
-    if (node.IsScalar())
+    QList<QRegularExpression> names;
+    QList<QRegularExpression> paths;
+
+    bool matches(const QString &name, const QString &relativePath) const
     {
-        return QString::fromStdString(node.as<std::string>());
+        for (const auto &re : names)
+        {
+            if (re.match(name).hasMatch())
+                return true;
+        }
+        for (const auto &re : paths)
+        {
+            if (re.match(relativePath).hasMatch())
+                return true;
+        }
+        return false;
     }
-    return fallback;
-}
+};
 
-bool toBool(const YAML::Node &node, bool fallback = false)
+// Patterns come from ScanOptionsDTO plus an optional .toolignore file in the
+// root (one wildcard per line, '#' starts a comment).
+IgnoreRules loadIgnoreRules(const QString &root, const QStringList &extraPatterns)
 {
-    if (!node)
+    QStringList patterns = extraPatterns;
+    QFile ignoreFile(QDir(root).filePath(QStringLiteral(".toolignore")));
+    if (ignoreFile.open(QIODevice::ReadOnly | QIODevice::Text))
     {
-        return fallback;
+        while (!ignoreFile.atEnd())
+        {
+            const QString line = QString::fromUtf8(ignoreFile.readLine()).trimmed();
+            if (!line.isEmpty() && !line.startsWith('#'))
+            {
+                patterns << line;
+            }
+        }
     }
-    if (node.IsScalar())
+
+    IgnoreRules rules;
+    for (QString pattern : std::as_const(patterns))
     {
-        return node.as<bool>(fallback);
+        pattern = QDir::fromNativeSeparators(pattern.trimmed());
+        while (pattern.endsWith('/'))
+            pattern.chop(1);
+        if (pattern.isEmpty())
+            continue;
+        if (pattern.contains('/'))
+        {
+            if (pattern.startsWith('/'))
+                pattern.remove(0, 1);
+            rules.paths << QRegularExpression::fromWildcard(pattern, kPathCase);
+        }
+        else
+        {
+            rules.names << QRegularExpression::fromWildcard(pattern, kPathCase);
+        }
     }
-    return fallback;
+    return rules;
 }
+} // namespace
 
-QStringList toStringList(const YAML::Node &node)
+ScanWorker::ScanWorker(QObject *parent)
+    : QObject(parent)
 {
-    QStringList list;
-    if (!node || !node.IsSequence())
-    {
-        return list;
-    }
-    for (const auto &item : node)
+    // Manifest parsing is mostly file IO (often on a network share), so size the
+    // pool to the machine rather than sharing the global pool with other work.
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+const QStringList &ScanWorker::alwaysPrunedDirs()
+{
+    // Environment and output trees can hold hundreds of thousands of files.
+    static const QStringList dirs{
+        QStringLiteral(".venv"),
+        QStringLiteral(".r-lib"),
+        QStringLiteral("runs"),
+        QStringLiteral("node_modules"),
+        QStringLiteral(".git"),
+    };
+    return dirs;
+}
+
+void ScanWorker::setParallel(bool enabled)
+{
+    m_parallel = enabled;
+}
+
+void ScanWorker::setCacheEnabled(bool enabled)
+{
+    m_cacheEnabled = enabled;
+    if (!enabled)
     {
-        list << QString::fromStdString(item.as<std::string>(""));
+        m_cache.clear();
     }
-    return list;
 }
-} // namespace
 
-void ScanWorker::scan(const QString &toolsRoot)
+void ScanWorker::scan(const ScanOptionsDTO &options)
+{
+    runScan(options, false);
+}
+
+void ScanWorker::scanStreaming(const ScanOptionsDTO &options)
+{
+    runScan(options, true);
+}
+
+void ScanWorker::runScan(const ScanOptionsDTO &options, bool streaming)
 {
     ScanResultDTO result;
-    QDir root(toolsRoot);
-    if (!root.exists())
+    auto appendError = [&result](const QString &error) {
+        if (error.isEmpty())
+            return;
+        if (!result.error.isEmpty())
+        {
+            result.error.append('\n');
+        }
+        result.error.append(error);
+    };
+
+    const Discovery discovery = discover(options);
+    for (const QString &error : discovery.errors)
     {
-        result.error = QStringLiteral("Tools root does not exist: %1").arg(toolsRoot);
-        emit scanFinished(result);
+        appendError(error);
+    }
+    if (discovery.errors.size() == options.roots.size())
+    {
+        // None of the roots exists.
+        if (streaming)
+        {
+            emit scanCompleted(0, result.error);
+        }
+        else
+        {
+            emit scanFinished(result);
+        }
         return;
     }
 
-    const QStringList entries = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    for (const QString &entry : entries)
+    const QString catalogKey = catalogKeyFor(options);
+    if (m_cacheEnabled && m_cache.catalogKey() != catalogKey)
     {
-        const QString toolDir = root.filePath(entry);
-        const QString yamlPath = QDir(toolDir).filePath(QStringLiteral("tool.yaml"));
-        if (!QFile::exists(yamlPath))
+        // First scan of these roots: hand out the last known catalog right
+        // away, the validated result follows once changed manifests are re-parsed.
+        if (m_cache.load(catalogKey) && !m_cache.isEmpty())
         {
-            continue;
+            ScanResultDTO restored;
+            restored.tools = m_cache.tools();
+            emit catalogRestored(restored);
+        }
+    }
+
+    QList<ParsedTool> accepted;
+    QHash<QString, QString> seenIds;
+    // Cache writes wait until every parse has finished: pool threads still
+    // call m_cache.lookup while the sink already sees earlier results.
+    QList<ToolCatalogCache::Entry> cacheEntries;
+    QList<ToolHandle> batch;
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+
+    auto flush = [&]() {
+        if (!batch.isEmpty())
+        {
+            emit scanBatchReady(batch);
+            batch.clear();
         }
+        sinceFlush.restart();
+    };
 
-        QString error;
-        ToolDTO dto = parseTool(toolDir, error);
-        if (!error.isEmpty())
+    parseToolDirs(discovery.tools, [&](const ParsedTool &entry) {
+        if (m_cacheEnabled)
         {
-            if (!result.error.isEmpty())
+            cacheEntries.append({entry.manifestPath, entry.stamp, entry.tool, entry.error});
+        }
+        appendError(entry.error);
+
+        if (entry.tool->id.isEmpty())
+        {
+            return;
+        }
+        const auto duplicate = seenIds.constFind(entry.tool->id);
+        if (duplicate != seenIds.cend())
+        {
+            appendError(QStringLiteral("Duplicate tool id %1 in %2 (already provided by %3)").arg(entry.tool->id, entry.toolDir, duplicate.value()));
+            return;
+        }
+        seenIds.insert(entry.tool->id, entry.toolDir);
+        accepted.append(entry);
+
+        if (!streaming)
+        {
+            result.tools.append(entry.tool);
+            return;
+        }
+
+        batch.append(entry.tool);
+        // The first tool goes out on its own so the window fills within a
+        // frame; after that batches are bounded by size and by age.
+        if (accepted.size() == 1 || batch.size() >= kStreamBatchSize || sinceFlush.elapsed() >= kStreamBatchIntervalMs)
+        {
+            flush();
+        }
+    });
+
+    if (m_cacheEnabled)
+    {
+        QStringList manifestPaths;
+        manifestPaths.reserve(cacheEntries.size());
+        for (const ToolCatalogCache::Entry &entry : std::as_const(cacheEntries))
+        {
+            m_cache.insert(entry);
+            manifestPaths << entry.manifestPath;
+        }
+        m_cache.retainOnly(manifestPaths);
+        if (m_cache.isDirty())
+        {
+            m_cache.save();
+        }
+    }
+
+    rememberTools(options, discovery, accepted);
+    if (streaming)
+    {
+        flush();
+        emit scanCompleted(accepted.size(), result.error);
+    }
+    else
+    {
+        emit scanFinished(result);
+    }
+    // Values of tools that disappeared or changed since the last scan.
+    StringPool::instance().prune();
+}
+
+void ScanWorker::startWatching(const ScanOptionsDTO &options)
+{
+    if (!m_watcher)
+    {
+        // Created lazily so both objects live on the scan thread.
+        m_watcher = new QFileSystemWatcher(this);
+        m_debounce = new QTimer(this);
+        m_debounce->setSingleShot(true);
+        m_debounce->setInterval(kWatchDebounceMs);
+        connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &ScanWorker::handleDirectoryChanged);
+        connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &ScanWorker::handleFileChanged);
+        connect(m_debounce, &QTimer::timeout, this, &ScanWorker::applyPendingChanges);
+    }
+
+    stopWatching();
+    m_watchOptions = options;
+    if (m_knownKey != catalogKeyFor(options))
+    {
+        // No scan of these roots yet: take a baseline without announcing anything.
+        const Discovery discovery = discover(options);
+        QList<ParsedTool> accepted;
+        QSet<QString> seenIds;
+        parseToolDirs(discovery.tools, [&](const ParsedTool &entry) {
+            if (!entry.tool->id.isEmpty() && !seenIds.contains(entry.tool->id))
             {
-                result.error.append('\n');
+                seenIds.insert(entry.tool->id);
+                accepted.append(entry);
             }
-            result.error.append(error);
-        }
+        });
+        rememberTools(options, discovery, accepted);
+    }
+    syncWatchedPaths();
+    qInfo(logScan) << "Watching" << options.roots << "tools" << m_knownTools.size();
+}
 
-        if (!dto.id.isEmpty())
+void ScanWorker::stopWatching()
+{
+    if (m_debounce)
+    {
+        m_debounce->stop();
+    }
+    if (m_watcher)
+    {
+        const QStringList watched = m_watcher->files() + m_watcher->directories();
+        if (!watched.isEmpty())
         {
-            result.tools.append(dto);
+            m_watcher->removePaths(watched);
         }
     }
+    m_watchOptions = ScanOptionsDTO{};
+    m_dirtyToolDirs.clear();
+    m_layoutDirty = false;
+}
 
-    emit scanFinished(result);
+void ScanWorker::handleDirectoryChanged(const QString &path)
+{
+    if (m_containerDirs.contains(path))
+    {
+        m_layoutDirty = true;
+    }
+    else
+    {
+        m_dirtyToolDirs.insert(path);
+    }
+    m_debounce->start();
 }
 
-ToolDTO ScanWorker::parseTool(const QString &toolDirPath, QString &error) const
+void ScanWorker::handleFileChanged(const QString &path)
 {
-    ToolDTO dto;
-    dto.id = QFileInfo(toolDirPath).fileName();
+    m_dirtyToolDirs.insert(QFileInfo(path).path());
+    m_debounce->start();
+}
 
-    const QString yamlPath = QDir(toolDirPath).filePath(QStringLiteral("tool.yaml"));
-    try
+void ScanWorker::applyPendingChanges()
+{
+    if (m_watchOptions.roots.isEmpty())
     {
-        YAML::Node root = YAML::LoadFile(yamlPath.toStdString());
+        return;
+    }
+
+    QSet<QString> dirty = m_dirtyToolDirs;
+    m_dirtyToolDirs.clear();
+    QHash<QString, QString> newToolRoots;
 
-        dto.name = toQString(root["name"], dto.id);
-        dto.version = toQString(root["version"]);
-        dto.description = toQString(root["description"]);
-        dto.category = toQString(root["category"], QStringLiteral("未分类"));
-        dto.thumbnail = toQString(root["thumbnail"]);
+    if (m_layoutDirty)
+    {
+        m_layoutDirty = false;
+        const Discovery discovery = discover(m_watchOptions);
+        m_containerDirs = QSet<QString>(discovery.containerDirs.cbegin(), discovery.containerDirs.cend());
 
-        if (root["tags"])
+        QSet<QString> current;
+        for (const ToolLocation &location : discovery.tools)
         {
-            for (const auto &tag : root["tags"])
+            current.insert(location.toolDir);
+            if (!m_knownTools.contains(location.toolDir))
             {
-                dto.tags << QString::fromStdString(tag.as<std::string>());
+                dirty.insert(location.toolDir);
+                newToolRoots.insert(location.toolDir, location.toolsRoot);
             }
         }
-
-        // runtime
-        if (root["runtime"])
+        for (auto it = m_knownTools.cbegin(); it != m_knownTools.cend(); ++it)
         {
-            const auto runtime = root["runtime"];
-            dto.runtime.type = toQString(runtime["type"]);
-            dto.runtime.entry = toQString(runtime["entry"]);
-            dto.runtime.args = toStringList(runtime["args"]);
-            dto.runtime.shellWrap = toBool(runtime["shell"], toBool(runtime["shell_wrap"], false));
-            dto.runtime.workdir = toQString(runtime["workdir"], QStringLiteral("."));
-            dto.runtime.timeoutSeconds = runtime["timeout"].as<int>(0);
-
-            if (runtime["extra_env"])
+            if (!current.contains(it.key()))
             {
-                for (auto it = runtime["extra_env"].begin(); it != runtime["extra_env"].end(); ++it)
-                {
-                    dto.runtime.extraEnv.insert(QString::fromStdString(it->first.as<std::string>()),
-                                                QString::fromStdString(it->second.as<std::string>("")));
-                }
+                dirty.insert(it.key());
             }
+        }
+    }
 
-            if (runtime["expected_outputs"])
+    const bool cacheActive = m_cacheEnabled && m_cache.catalogKey() == catalogKeyFor(m_watchOptions);
+    QList<ToolLocation> toParse;
+    for (const QString &toolDir : std::as_const(dirty))
+    {
+        const QString manifestPath = ToolManifest::manifestPath(toolDir);
+        const auto known = m_knownTools.constFind(toolDir);
+        if (QFileInfo::exists(manifestPath))
+        {
+            if (known != m_knownTools.cend())
             {
-                for (const auto &out : runtime["expected_outputs"])
-                {
-                    ExpectedOutputDTO ex;
-                    ex.path = toQString(out["path"]);
-                    ex.label = toQString(out["label"], ex.path);
-                    ex.type = toQString(out["type"], QStringLiteral("file"));
-                    if (!ex.path.isEmpty())
-                    {
-                        dto.runtime.expectedOutputs.append(ex);
-                    }
-                }
+                toParse.append({known->toolsRoot, toolDir});
+            }
+            else if (newToolRoots.contains(toolDir))
+            {
+                toParse.append({newToolRoots.value(toolDir), toolDir});
             }
+            continue;
         }
-        else
+
+        if (known == m_knownTools.cend())
         {
-            dto.runtime.type = QStringLiteral("generic");
-            dto.runtime.entry = toQString(root["command"]); // legacy fallback
+            continue;
+        }
+        const QString toolId = known->id;
+        m_knownTools.erase(known);
+        if (cacheActive)
+        {
+            m_cache.remove(manifestPath);
         }
+        qInfo(logScan) << "Tool removed" << toolId;
+        emit toolRemoved(toolId);
+    }
+    std::sort(toParse.begin(), toParse.end(), [](const ToolLocation &a, const ToolLocation &b)
+              { return a.toolDir < b.toolDir; });
 
-        // env
-        if (root["env"])
+    const QList<ParsedTool> parsed = parseToolDirs(toParse);
+    for (const ParsedTool &entry : parsed)
+    {
+        if (cacheActive)
+        {
+            m_cache.insert({entry.manifestPath, entry.stamp, entry.tool, entry.error});
+        }
+        const bool broken = !entry.error.isEmpty() || entry.tool->id.isEmpty();
+        if (!entry.error.isEmpty())
         {
-            const auto env = root["env"];
-            dto.env.strategy = toQString(env["strategy"], toQString(env["type"]));
-            dto.env.interpreterPath = toQString(env["interpreter"], toQString(env["interpreter_path"]));
-            dto.env.dependencies = toStringList(env["dependencies"]);
-            dto.env.cacheDir = toQString(env["cache_dir"]);
+            qWarning(logScan) << entry.error;
+        }
 
-            if (env["setup"])
+        auto known = m_knownTools.find(entry.toolDir);
+        if (known == m_knownTools.end() && broken)
+        {
+            // Remembered so that fixing the manifest announces the tool.
+            m_knownTools.insert(entry.toolDir, {entry.tool->id, entry.tool->toolsRoot, entry.stamp, true});
+            continue;
+        }
+        if (known == m_knownTools.end())
+        {
+            const bool duplicate = std::any_of(m_knownTools.cbegin(), m_knownTools.cend(), [&](const KnownTool &k)
+                                               { return k.id == entry.tool->id; });
+            if (duplicate)
             {
-                const auto setup = env["setup"];
-                dto.env.setup.command = toQString(setup["command"]);
-                dto.env.setup.shell = toBool(setup["shell"]);
-                dto.env.setup.workdir = toQString(setup["workdir"], QStringLiteral("."));
+                qWarning(logScan) << "Duplicate tool id" << entry.tool->id << "in" << entry.toolDir;
+                continue;
             }
+            m_knownTools.insert(entry.toolDir, {entry.tool->id, entry.tool->toolsRoot, entry.stamp});
+            qInfo(logScan) << "Tool added" << entry.tool->id;
+            emit toolAdded(entry.tool);
+            continue;
         }
 
-        if (dto.env.cacheDir.isEmpty())
+        // Directory events also fire for .venv/.r-lib churn inside a tool;
+        // only announce an update when the manifest itself changed.
+        if (known->stamp.sameFileTimes(entry.stamp) && known->stamp.contentHash == entry.stamp.contentHash)
         {
-            if (dto.runtime.type.toLower() == QStringLiteral("r"))
-            {
-                dto.env.cacheDir = QStringLiteral(".r-lib");
-            }
-            else if (dto.runtime.type.toLower() == QStringLiteral("python"))
+            continue;
+        }
+        known->stamp = entry.stamp;
+        if (broken)
+        {
+            // Half-edited manifests are common while watching; take the tool
+            // out until it parses again rather than showing a stale entry.
+            if (!known->broken)
             {
-                dto.env.cacheDir = QStringLiteral(".venv");
+                known->broken = true;
+                qInfo(logScan) << "Tool withdrawn" << known->id;
+                emit toolRemoved(known->id);
             }
+            continue;
+        }
+        if (known->broken)
+        {
+            known->broken = false;
+            known->id = entry.tool->id;
+            qInfo(logScan) << "Tool restored" << entry.tool->id;
+            emit toolAdded(entry.tool);
+            continue;
         }
+        qInfo(logScan) << "Tool updated" << entry.tool->id;
+        emit toolUpdated(entry.tool);
+    }
+
+    if (cacheActive && m_cache.isDirty())
+    {
+        m_cache.save();
+    }
+    syncWatchedPaths();
+    StringPool::instance().prune();
+}
 
-        if (root["params"])
+void ScanWorker::rememberTools(const ScanOptionsDTO &options, const Discovery &discovery, const QList<ParsedTool> &accepted)
+{
+    m_knownKey = catalogKeyFor(options);
+    m_knownTools.clear();
+    for (const ParsedTool &entry : accepted)
+    {
+        m_knownTools.insert(entry.toolDir, {entry.tool->id, entry.tool->toolsRoot, entry.stamp, !entry.error.isEmpty()});
+    }
+    m_containerDirs = QSet<QString>(discovery.containerDirs.cbegin(), discovery.containerDirs.cend());
+
+    if (!m_watchOptions.roots.isEmpty() && catalogKeyFor(m_watchOptions) == m_knownKey)
+    {
+        syncWatchedPaths();
+    }
+}
+
+void ScanWorker::syncWatchedPaths()
+{
+    if (!m_watcher || m_watchOptions.roots.isEmpty())
+    {
+        return;
+    }
+
+    QStringList wanted(m_containerDirs.cbegin(), m_containerDirs.cend());
+    for (auto it = m_knownTools.cbegin(); it != m_knownTools.cend(); ++it)
+    {
+        wanted << it.key() << ToolManifest::manifestPath(it.key());
+    }
+
+    const QStringList watched = m_watcher->files() + m_watcher->directories();
+    const QSet<QString> watchedSet(watched.cbegin(), watched.cend());
+    const QSet<QString> wantedSet(wanted.cbegin(), wanted.cend());
+
+    QStringList stale;
+    for (const QString &path : watched)
+    {
+        if (!wantedSet.contains(path))
         {
-            for (const auto &p : root["params"])
+            stale << path;
+        }
+    }
+    if (!stale.isEmpty())
+    {
+        m_watcher->removePaths(stale);
+    }
+
+    QStringList missing;
+    for (const QString &path : std::as_const(wanted))
+    {
+        if (!watchedSet.contains(path))
+        {
+            missing << path;
+        }
+    }
+    if (!missing.isEmpty())
+    {
+        // Editors that save via rename drop the file watch; re-adding it here
+        // keeps the manifest covered. Failures (e.g. inotify limits) only cost
+        // us the fine-grained event, the directory watch still fires.
+        const QStringList failed = m_watcher->addPaths(missing);
+        if (!failed.isEmpty())
+        {
+            qWarning(logScan) << "Cannot watch" << failed.size() << "paths";
+        }
+    }
+}
+
+ScanWorker::Discovery ScanWorker::discover(const ScanOptionsDTO &options) const
+{
+    Discovery discovery;
+    const int maxDepth = qMax(1, options.maxDepth);
+    QSet<QString> visited; // canonical paths, guards against symlink loops
+
+    for (const QString &rootPath : options.roots)
+    {
+        const QDir root(rootPath);
+        if (!root.exists())
+        {
+            discovery.errors << QStringLiteral("Tools root does not exist: %1").arg(rootPath);
+            continue;
+        }
+        const QString canonicalRoot = QFileInfo(rootPath).canonicalFilePath();
+        if (visited.contains(canonicalRoot))
+        {
+            continue;
+        }
+        visited.insert(canonicalRoot);
+        discovery.containerDirs << rootPath;
+
+        const IgnoreRules rules = loadIgnoreRules(rootPath, options.ignorePatterns);
+        std::function<void(const QString &, int)> walk = [&](const QString &dirPath, int depth) {
+            const QDir dir(dirPath);
+            const QStringList entries = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+            for (const QString &entry : entries)
             {
-                ParamDTO param;
-                param.key = toQString(p["key"]);
-                param.label = toQString(p["label"], param.key);
-                param.type = paramTypeFromString(toQString(p["type"]));
-                param.required = p["required"].as<bool>(false);
-                param.defaultValue = toQString(p["default"]);
-                param.multi = p["multi"].as<bool>(false);
-                param.min = p["min"].as<double>(0.0);
-                param.max = p["max"].as<double>(0.0);
-                param.step = p["step"].as<double>(1.0);
-                param.placeholder = toQString(p["placeholder"]);
-                param.pattern = toQString(p["pattern"]);
-                param.description = toQString(p["description"]);
-
-                if (p["options"])
+                if (alwaysPrunedDirs().contains(entry, kPathCase))
                 {
-                    for (const auto &opt : p["options"])
-                    {
-                        ParamOption o;
-                        if (opt.IsMap())
-                        {
-                            o.label = toQString(opt["label"]);
-                            o.value = toQString(opt["value"], o.label);
-                        }
-                        else
-                        {
-                            const QString val = QString::fromStdString(opt.as<std::string>(""));
-                            o.label = val;
-                            o.value = val;
-                        }
-                        param.options.append(o);
-                    }
+                    continue;
                 }
-
-                if (!param.key.isEmpty())
+                const QString path = dir.filePath(entry);
+                if (rules.matches(entry, root.relativeFilePath(path)))
+                {
+                    continue;
+                }
+                if (QFile::exists(ToolManifest::manifestPath(path)))
                 {
-                    dto.params.append(param);
+                    // A tool directory is a leaf; its own subfolders are never scanned.
+                    discovery.tools.append({rootPath, path});
+                    continue;
                 }
+                if (depth + 1 >= maxDepth)
+                {
+                    continue;
+                }
+                const QString canonical = QFileInfo(path).canonicalFilePath();
+                if (visited.contains(canonical))
+                {
+                    continue;
+                }
+                visited.insert(canonical);
+                discovery.containerDirs << path;
+                walk(path, depth + 1);
+            }
+        };
+        walk(rootPath, 0);
+    }
+    return discovery;
+}
+
+ScanWorker::ParsedTool ScanWorker::parseToolDir(const ToolLocation &location) const
+{
+    ParsedTool parsed;
+    parsed.toolDir = location.toolDir;
+    parsed.manifestPath = ToolManifest::manifestPath(location.toolDir);
+    const QFileInfo info(parsed.manifestPath);
+
+    ToolCatalogCache::Entry cached;
+    if (m_cacheEnabled && m_cache.lookup(parsed.manifestPath, info, cached))
+    {
+        parsed.stamp = cached.stamp;
+        parsed.tool = cached.tool;
+        parsed.error = cached.error;
+    }
+    else
+    {
+        parsed.stamp = ToolCatalogCache::stampFor(info);
+        // Read once: the same bytes are hashed for the cache and parsed.
+        QFile file(parsed.manifestPath);
+        ToolDTO tool;
+        if (file.open(QIODevice::ReadOnly))
+        {
+            const QByteArray content = file.readAll();
+            file.close();
+            if (m_cacheEnabled)
+            {
+                parsed.stamp.contentHash = ToolCatalogCache::hashContent(content);
             }
+            tool = parseTool(location.toolDir, content, parsed.error);
         }
+        else
+        {
+            // Let the manifest loader report why it cannot be read.
+            tool = ToolManifest::loadHeader(location.toolDir, parsed.error);
+        }
+        tool.toolsRoot = location.toolsRoot;
+        parsed.tool = ToolHandle::create(std::move(tool));
+    }
+    if (parsed.tool->toolsRoot != location.toolsRoot)
+    {
+        // Same manifest reached through a different root than when cached.
+        ToolDTO tool = *parsed.tool;
+        tool.toolsRoot = location.toolsRoot;
+        parsed.tool = ToolHandle::create(std::move(tool));
+    }
+    return parsed;
+}
 
-        if (dto.runtime.entry.isEmpty())
+QList<ScanWorker::ParsedTool> ScanWorker::parseToolDirs(const QList<ToolLocation> &locations)
+{
+    QList<ParsedTool> parsed;
+    parsed.reserve(locations.size());
+    parseToolDirs(locations, [&parsed](const ParsedTool &entry) { parsed.append(entry); });
+    return parsed;
+}
+
+void ScanWorker::parseToolDirs(const QList<ToolLocation> &locations, const std::function<void(const ParsedTool &)> &sink)
+{
+    if (!m_parallel || locations.size() < 2)
+    {
+        for (const ToolLocation &location : locations)
         {
-            error = QStringLiteral("Missing runtime.entry in %1").arg(yamlPath);
+            sink(parseToolDir(location));
         }
+        return;
     }
-    catch (const YAML::Exception &ex)
+
+    // Results are consumed strictly in input order (resultAt blocks until that
+    // index is ready), so the merged result stays deterministic regardless of
+    // which manifest finishes first, while later ones keep parsing meanwhile.
+    QFuture<ParsedTool> future = QtConcurrent::mapped(&m_pool, locations, [this](const ToolLocation &location) {
+        return parseToolDir(location);
+    });
+    for (int i = 0; i < locations.size(); ++i)
     {
-        error = QStringLiteral("Failed to parse %1: %2").arg(yamlPath, QString::fromStdString(ex.what()));
+        sink(future.resultAt(i));
     }
+}
+
+ToolDTO ScanWorker::parseTool(const QString &toolDirPath, const QByteArray &content, QString &error) const
+{
+    // Scan time only needs what the tool list shows; params/env are decoded
+    // on demand through ToolManifestCache.
+    return ToolManifest::loadHeader(toolDirPath, content, error);
+}
 
-    return dto;
+QString ScanWorker::catalogKeyFor(const ScanOptionsDTO &options)
+{
+    QStringList roots;
+    for (const QString &root : options.roots)
+    {
+        roots << QDir(root).absolutePath();
+    }
+    return roots.join('\n');
 }
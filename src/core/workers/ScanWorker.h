@@ -1,19 +1,104 @@
 #pragma once
 
 #include "common/Dto.h"
+#include "core/ToolCatalogCache.h"
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <functional>
+
+class QFileSystemWatcher;
+class QTimer;
 
 class ScanWorker : public QObject
 {
     Q_OBJECT
+public:
+    explicit ScanWorker(QObject *parent = nullptr);
+
+    // Directory names that are never descended into, regardless of ignore rules.
+    static const QStringList &alwaysPrunedDirs();
+
 public slots:
-    void scan(const QString &toolsRoot);
+    void scan(const ScanOptionsDTO &options);
+    void scanStreaming(const ScanOptionsDTO &options);
+    void setParallel(bool enabled);
+    void setCacheEnabled(bool enabled);
+    void startWatching(const ScanOptionsDTO &options);
+    void stopWatching();
 
 signals:
+    void catalogRestored(const ScanResultDTO &result);
     void scanFinished(const ScanResultDTO &result);
+    void scanBatchReady(const QList<ToolHandle> &tools);
+    void scanCompleted(int toolCount, const QString &errors);
+    void toolAdded(const ToolHandle &tool);
+    void toolUpdated(const ToolHandle &tool);
+    void toolRemoved(const QString &toolId);
+
+private slots:
+    void handleDirectoryChanged(const QString &path);
+    void handleFileChanged(const QString &path);
+    void applyPendingChanges();
 
 private:
-    ToolDTO parseTool(const QString &toolDirPath, QString &error) const;
+    struct ToolLocation
+    {
+        QString toolsRoot;
+        QString toolDir;
+    };
+
+    struct Discovery
+    {
+        QList<ToolLocation> tools;
+        QStringList containerDirs; // roots and intermediate folders, watched for new tools
+        QStringList errors;
+    };
+
+    struct ParsedTool
+    {
+        QString toolDir;
+        QString manifestPath;
+        ToolCatalogCache::ManifestStamp stamp;
+        ToolHandle tool; // never null
+        QString error;
+    };
+
+    struct KnownTool
+    {
+        QString id;
+        QString toolsRoot;
+        ToolCatalogCache::ManifestStamp stamp;
+        bool broken{false}; // manifest has errors; withdrawn from the catalog while watching
+    };
+
+    void runScan(const ScanOptionsDTO &options, bool streaming);
+    Discovery discover(const ScanOptionsDTO &options) const;
+    ParsedTool parseToolDir(const ToolLocation &location) const;
+    QList<ParsedTool> parseToolDirs(const QList<ToolLocation> &locations);
+    void parseToolDirs(const QList<ToolLocation> &locations, const std::function<void(const ParsedTool &)> &sink);
+    ToolDTO parseTool(const QString &toolDirPath, const QByteArray &content, QString &error) const;
+    void rememberTools(const ScanOptionsDTO &options, const Discovery &discovery, const QList<ParsedTool> &accepted);
+    void syncWatchedPaths();
+    static QString catalogKeyFor(const ScanOptionsDTO &options);
+
+    bool m_parallel{true};
+    bool m_cacheEnabled{true};
+    ToolCatalogCache m_cache;
+    QThreadPool m_pool;
+
+    QString m_knownKey;
+    QHash<QString, KnownTool> m_knownTools; // keyed by tool directory
+    QSet<QString> m_containerDirs;
+
+    ScanOptionsDTO m_watchOptions;
+    QFileSystemWatcher *m_watcher{nullptr};
+    QTimer *m_debounce{nullptr};
+    QSet<QString> m_dirtyToolDirs;
+    bool m_layoutDirty{false};
 };
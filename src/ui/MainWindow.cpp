@@ -11,6 +11,7 @@
 #include <QHBoxLayout>
 #include <QIcon>
 #include <QLabel>
+#include <QLineEdit>
 #include <QListWidget>
 #include <QListWidgetItem>
 #include <QListView>
@@ -19,6 +20,8 @@
 #include <QNetworkRequest>
 #include <QProcess>
 #include <QPushButton>
+#include <QSet>
+#include <QSignalBlocker>
 #include <QStandardPaths>
 #include <QStringConverter>
 #include <QVBoxLayout>
@@ -28,6 +31,8 @@
 #include <QTimer>
 #include <QWidget>
 
+#include <algorithm>
+
 namespace
 {
     const QString kAllCategory = QStringLiteral("全部");
@@ -39,14 +44,21 @@ namespace
     const QString kUpdateButtonIdle = QStringLiteral("检查更新");
 } // namespace
 
-MainWindow::MainWindow(CoreService *core, const QString &toolsRoot, QWidget *parent)
-    : QMainWindow(parent), m_core(core), m_toolsRoot(toolsRoot)
+MainWindow::MainWindow(CoreService *core, const ScanOptionsDTO &scanOptions, QWidget *parent)
+    : QMainWindow(parent), m_core(core), m_scanOptions(scanOptions), m_toolsRoot(scanOptions.roots.value(0))
 {
     buildUi();
 
+    connect(m_core, &CoreService::catalogRestored, this, &MainWindow::handleCatalogRestored);
     connect(m_core, &CoreService::scanFinished, this, &MainWindow::handleScanFinished);
+    connect(m_core, &CoreService::scanBatchReady, this, &MainWindow::handleScanBatchReady);
+    connect(m_core, &CoreService::scanCompleted, this, &MainWindow::handleScanCompleted);
+    connect(m_core, &CoreService::toolAdded, this, &MainWindow::handleToolAdded);
+    connect(m_core, &CoreService::toolUpdated, this, &MainWindow::handleToolUpdated);
+    connect(m_core, &CoreService::toolRemoved, this, &MainWindow::handleToolRemoved);
 
     handleRefreshClicked();
+    m_core->startWatching(m_scanOptions);
 
     // Do a light-weight auto check shortly after startup.
     QTimer::singleShot(1500, this, [this]()
@@ -86,6 +98,11 @@ void MainWindow::buildUi()
     toolbar->setLayout(toolbarLayout);
     rightLayout->addWidget(toolbar, 0);
 
+    m_searchEdit = new QLineEdit(right);
+    m_searchEdit->setPlaceholderText(tr("搜索工具：名称、ID、标签、分类、描述"));
+    m_searchEdit->setClearButtonEnabled(true);
+    rightLayout->addWidget(m_searchEdit, 0);
+
     m_toolList = new QListWidget(right);
     m_toolList->setResizeMode(QListView::Adjust);
     m_toolList->setSelectionMode(QAbstractItemView::SingleSelection);
@@ -98,25 +115,175 @@ void MainWindow::buildUi()
     connect(m_refreshBtn, &QPushButton::clicked, this, &MainWindow::handleRefreshClicked);
     connect(m_updateBtn, &QPushButton::clicked, this, &MainWindow::handleUpdateClicked);
     connect(m_categoryList, &QListWidget::currentRowChanged, this, &MainWindow::handleCategoryChanged);
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &MainWindow::handleSearchChanged);
     connect(m_toolList, &QListWidget::itemDoubleClicked, this, &MainWindow::handleToolActivated);
     connect(m_toggleViewBtn, &QPushButton::clicked, this, &MainWindow::handleToggleView);
 }
 
+void MainWindow::handleCatalogRestored(const ScanResultDTO &result)
+{
+    // Cached catalog from the previous session; the live scan replaces it shortly.
+    Q_UNUSED(result);
+    m_searchIndex.rebuild(m_core->catalog().tools());
+    rebuildCategories();
+    refreshSearch();
+}
+
 void MainWindow::handleScanFinished(const ScanResultDTO &result)
 {
+    m_searchIndex.rebuild(m_core->catalog().tools());
+    rebuildCategories();
+    refreshSearch();
     if (!result.ok())
     {
         QMessageBox::warning(this, tr("扫描失败"), result.error);
+    }
+}
+
+void MainWindow::handleScanBatchReady(const QList<ToolHandle> &tools)
+{
+    if (m_streamPending)
+    {
+        // First batch of a fresh scan replaces whatever was shown before
+        // (typically the restored cache); later batches are appended.
+        m_streamPending = false;
+        m_toolList->clear();
+        m_searchIndex.clear();
+    }
+
+    addCategoryIfMissing(kAllCategory);
+    for (const auto &tool : tools)
+    {
+        m_searchIndex.upsert(tool);
+        addCategoryIfMissing(tool->category);
+        if (!isSearching() && matchesFilter(*tool))
+        {
+            m_toolList->addItem(createToolItem(*tool));
+        }
+    }
+    if (isSearching())
+    {
+        refreshSearch();
+    }
+    updateSummary();
+}
+
+void MainWindow::handleScanCompleted(int toolCount, const QString &errors)
+{
+    Q_UNUSED(toolCount);
+
+    if (m_streamPending)
+    {
+        m_streamPending = false;
+        m_toolList->clear();
+        m_searchIndex.clear();
+        m_searchResults.clear();
+    }
+
+    // Drop categories left over from the catalog shown before this scan.
+    QStringList shown;
+    for (int row = 0; row < m_categoryList->count(); ++row)
+    {
+        shown << m_categoryList->item(row)->text();
+    }
+    for (const auto &category : std::as_const(shown))
+    {
+        removeCategoryIfUnused(category);
+    }
+    addCategoryIfMissing(kAllCategory);
+    if (!m_categoryList->currentItem())
+    {
+        m_categoryList->setCurrentItem(m_categoryList->findItems(kAllCategory, Qt::MatchExactly).value(0));
+    }
+    updateSummary();
+    m_refreshBtn->setEnabled(true);
+
+    if (!errors.isEmpty())
+    {
+        QMessageBox::warning(this, tr("扫描失败"), errors);
+    }
+}
+
+void MainWindow::handleToolAdded(const ToolHandle &tool)
+{
+    m_searchIndex.upsert(tool);
+    addCategoryIfMissing(tool->category);
+    if (isSearching())
+    {
+        refreshSearch();
         return;
     }
-    m_tools = result.tools;
-    rebuildCategories();
-    rebuildToolList();
+    if (matchesFilter(*tool))
+    {
+        m_toolList->addItem(createToolItem(*tool));
+    }
+    updateSummary();
+}
+
+void MainWindow::handleToolUpdated(const ToolHandle &tool, const ToolHandle &previous)
+{
+    if (!previous)
+    {
+        handleToolAdded(tool);
+        return;
+    }
+
+    m_searchIndex.upsert(tool);
+    m_iconCache.remove(tool->toolDir + QLatin1Char('/') + previous->thumbnail);
+    addCategoryIfMissing(tool->category);
+    if (isSearching())
+    {
+        if (previous->category != tool->category)
+        {
+            removeCategoryIfUnused(previous->category);
+        }
+        refreshSearch();
+        return;
+    }
+
+    QListWidgetItem *existing = findToolItem(tool->id);
+    if (matchesFilter(*tool))
+    {
+        auto *fresh = createToolItem(*tool);
+        if (existing)
+        {
+            const int row = m_toolList->row(existing);
+            delete m_toolList->takeItem(row);
+            m_toolList->insertItem(row, fresh);
+        }
+        else
+        {
+            m_toolList->addItem(fresh);
+        }
+    }
+    else if (existing)
+    {
+        delete m_toolList->takeItem(m_toolList->row(existing));
+    }
+
+    if (previous->category != tool->category)
+    {
+        removeCategoryIfUnused(previous->category);
+    }
+    updateSummary();
+}
+
+void MainWindow::handleToolRemoved(const ToolHandle &tool)
+{
+    m_searchIndex.remove(tool->id);
+    if (auto *item = findToolItem(tool->id))
+    {
+        delete m_toolList->takeItem(m_toolList->row(item));
+    }
+    removeCategoryIfUnused(tool->category);
+    updateSummary();
 }
 
 void MainWindow::handleRefreshClicked()
 {
-    m_core->startScan(m_toolsRoot);
+    m_streamPending = true;
+    m_refreshBtn->setEnabled(false);
+    m_core->startStreamingScan(m_scanOptions);
 }
 
 void MainWindow::handleCategoryChanged()
@@ -124,18 +291,26 @@ void MainWindow::handleCategoryChanged()
     rebuildToolList();
 }
 
+void MainWindow::handleSearchChanged(const QString &text)
+{
+    m_searchText = text.trimmed();
+    refreshSearch();
+}
+
+void MainWindow::refreshSearch()
+{
+    m_searchResults = isSearching() ? m_searchIndex.search(m_searchText) : QList<ToolSearchIndex::Hit>();
+    rebuildToolList();
+}
+
 void MainWindow::handleToolActivated(QListWidgetItem *item)
 {
     if (!item)
         return;
-    const QString toolId = item->data(Qt::UserRole).toString();
-    for (const auto &tool : m_tools)
+    const ToolHandle tool = m_core->catalog().find(item->data(Qt::UserRole).toString());
+    if (tool)
     {
-        if (tool.id == toolId)
-        {
-            openToolWindow(tool);
-            break;
-        }
+        openToolWindow(tool);
     }
 }
 
@@ -370,15 +545,13 @@ bool MainWindow::launchUpdater(const QString &zipPath, const QString &logPath)
 void MainWindow::rebuildCategories()
 {
     m_categoryList->clear();
-    QStringList categories;
-    categories << kAllCategory;
-    for (const auto &tool : m_tools)
+    QSet<QString> unique{kAllCategory};
+    const ToolCatalog catalog = m_core->catalog();
+    for (const auto &tool : catalog.tools())
     {
-        if (!categories.contains(tool.category))
-        {
-            categories << tool.category;
-        }
+        unique.insert(tool->category);
     }
+    QStringList categories(unique.cbegin(), unique.cend());
     categories.sort();
     for (const auto &c : categories)
     {
@@ -387,17 +560,26 @@ void MainWindow::rebuildCategories()
     m_categoryList->setCurrentRow(0);
 }
 
-QList<ToolDTO> MainWindow::filteredTools() const
+QList<ToolHandle> MainWindow::filteredTools() const
 {
-    const QString selected = m_categoryList->currentItem() ? m_categoryList->currentItem()->text() : kAllCategory;
-    if (selected == kAllCategory)
+    QList<ToolHandle> filtered;
+    const ToolCatalog catalog = m_core->catalog();
+    if (isSearching())
     {
-        return m_tools;
+        // Search results are already ranked; only the category still applies.
+        for (const auto &hit : m_searchResults)
+        {
+            const ToolHandle tool = catalog.find(hit.toolId);
+            if (tool && matchesFilter(*tool))
+            {
+                filtered.append(tool);
+            }
+        }
+        return filtered;
     }
-    QList<ToolDTO> filtered;
-    for (const auto &tool : m_tools)
+    for (const auto &tool : catalog.tools())
     {
-        if (tool.category == selected)
+        if (matchesFilter(*tool))
         {
             filtered.append(tool);
         }
@@ -407,22 +589,34 @@ QList<ToolDTO> MainWindow::filteredTools() const
 
 QIcon MainWindow::loadIconFor(const ToolDTO &tool) const
 {
+    // Search rebuilds the list on every keystroke; stat + decode once per tool.
+    const QString cacheKey = tool.toolDir + QLatin1Char('/') + tool.thumbnail;
+    const auto cached = m_iconCache.constFind(cacheKey);
+    if (cached != m_iconCache.cend())
+    {
+        return cached.value();
+    }
+
     QString iconPath;
     if (!tool.thumbnail.isEmpty())
     {
-        iconPath = QDir(QDir(m_toolsRoot).filePath(tool.id)).filePath(tool.thumbnail);
+        const QString toolDir = tool.toolDir.isEmpty() ? QDir(m_toolsRoot).filePath(tool.id) : tool.toolDir;
+        iconPath = QDir(toolDir).filePath(tool.thumbnail);
     }
     if (iconPath.isEmpty() || !QFileInfo::exists(iconPath))
     {
         iconPath = QDir(m_toolsRoot).absoluteFilePath(QStringLiteral("../assets/tool_placeholder.png"));
     }
-    return QIcon(iconPath);
+    const QIcon icon(iconPath);
+    m_iconCache.insert(cacheKey, icon);
+    return icon;
 }
 
 void MainWindow::rebuildToolList()
 {
+    m_toolList->setUpdatesEnabled(false);
     m_toolList->clear();
-    const QList<ToolDTO> display = filteredTools();
+    const QList<ToolHandle> display = filteredTools();
 
     m_toolList->setViewMode(m_cardMode ? QListView::IconMode : QListView::ListMode);
     if (m_cardMode)
@@ -438,18 +632,96 @@ void MainWindow::rebuildToolList()
 
     for (const auto &tool : display)
     {
-        auto *item = new QListWidgetItem(loadIconFor(tool), QStringLiteral("%1\n%2").arg(tool.name, tool.description));
-        item->setData(Qt::UserRole, tool.id);
-        item->setToolTip(QStringLiteral("%1\n%2").arg(tool.name, tool.description));
-        m_toolList->addItem(item);
+        m_toolList->addItem(createToolItem(*tool));
+    }
+    m_toolList->setUpdatesEnabled(true);
+
+    updateSummary();
+}
+
+void MainWindow::addCategoryIfMissing(const QString &category)
+{
+    if (!m_categoryList->findItems(category, Qt::MatchExactly).isEmpty())
+    {
+        return;
+    }
+    int row = 0;
+    while (row < m_categoryList->count() && m_categoryList->item(row)->text() < category)
+    {
+        ++row;
     }
+    const QSignalBlocker blocker(m_categoryList);
+    m_categoryList->insertItem(row, category);
+}
+
+void MainWindow::removeCategoryIfUnused(const QString &category)
+{
+    if (category == kAllCategory)
+    {
+        return;
+    }
+    const ToolCatalog catalog = m_core->catalog();
+    for (const auto &tool : catalog.tools())
+    {
+        if (tool->category == category)
+        {
+            return;
+        }
+    }
+    const auto items = m_categoryList->findItems(category, Qt::MatchExactly);
+    for (auto *item : items)
+    {
+        const bool wasCurrent = item == m_categoryList->currentItem();
+        delete m_categoryList->takeItem(m_categoryList->row(item));
+        if (wasCurrent)
+        {
+            m_categoryList->setCurrentRow(m_categoryList->row(m_categoryList->findItems(kAllCategory, Qt::MatchExactly).value(0)));
+        }
+    }
+}
+
+bool MainWindow::matchesFilter(const ToolDTO &tool) const
+{
+    const QString selected = m_categoryList->currentItem() ? m_categoryList->currentItem()->text() : kAllCategory;
+    return selected == kAllCategory || tool.category == selected;
+}
 
-    m_summaryLabel->setText(tr("工具：%1").arg(display.size()));
+QListWidgetItem *MainWindow::createToolItem(const ToolDTO &tool) const
+{
+    auto *item = new QListWidgetItem(loadIconFor(tool), QStringLiteral("%1\n%2").arg(tool.name, tool.description));
+    item->setData(Qt::UserRole, tool.id);
+    item->setToolTip(QStringLiteral("%1\n%2").arg(tool.name, tool.description));
+    return item;
 }
 
-void MainWindow::openToolWindow(const ToolDTO &tool)
+QListWidgetItem *MainWindow::findToolItem(const QString &toolId) const
 {
-    auto *win = new ToolWindow(m_core, m_toolsRoot, tool, this);
+    for (int row = 0; row < m_toolList->count(); ++row)
+    {
+        auto *item = m_toolList->item(row);
+        if (item->data(Qt::UserRole).toString() == toolId)
+        {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+void MainWindow::updateSummary()
+{
+    m_summaryLabel->setText(tr("工具：%1").arg(m_toolList->count()));
+}
+
+void MainWindow::openToolWindow(const ToolHandle &tool)
+{
+    QString error;
+    const ToolHandle details = m_core->loadToolDetails(m_toolsRoot, tool, error);
+    if (!error.isEmpty())
+    {
+        QMessageBox::warning(this, tr("工具配置错误"), error);
+    }
+
+    auto *win = new ToolWindow(m_core, m_toolsRoot, details, this);
     win->setAttribute(Qt::WA_DeleteOnClose, true);
     win->show();
     win->raise();
@@ -3,7 +3,10 @@
 #pragma once
 
 #include "common/Dto.h"
+#include "core/ToolSearchIndex.h"
 
+#include <QHash>
+#include <QIcon>
 #include <QMainWindow>
 #include <QNetworkAccessManager>
 #include <QUrl>
@@ -22,12 +25,19 @@ class MainWindow : public QMainWindow
 {
     Q_OBJECT
 public:
-    explicit MainWindow(CoreService *core, const QString &toolsRoot, QWidget *parent = nullptr);
+    explicit MainWindow(CoreService *core, const ScanOptionsDTO &scanOptions, QWidget *parent = nullptr);
 
 private slots:
+    void handleCatalogRestored(const ScanResultDTO &result);
     void handleScanFinished(const ScanResultDTO &result);
+    void handleScanBatchReady(const QList<ToolHandle> &tools);
+    void handleScanCompleted(int toolCount, const QString &errors);
+    void handleToolAdded(const ToolHandle &tool);
+    void handleToolUpdated(const ToolHandle &tool, const ToolHandle &previous);
+    void handleToolRemoved(const ToolHandle &tool);
     void handleRefreshClicked();
     void handleCategoryChanged();
+    void handleSearchChanged(const QString &text);
     void handleToolActivated(QListWidgetItem *item);
     void handleToggleView();
     void handleUpdateClicked();
@@ -36,9 +46,17 @@ private:
     void buildUi();
     void rebuildCategories();
     void rebuildToolList();
+    void addCategoryIfMissing(const QString &category);
+    void removeCategoryIfUnused(const QString &category);
+    bool matchesFilter(const ToolDTO &tool) const;
+    QListWidgetItem *createToolItem(const ToolDTO &tool) const;
+    QListWidgetItem *findToolItem(const QString &toolId) const;
+    void updateSummary();
     QIcon loadIconFor(const ToolDTO &tool) const;
-    QList<ToolDTO> filteredTools() const;
-    void openToolWindow(const ToolDTO &tool);
+    QList<ToolHandle> filteredTools() const;
+    bool isSearching() const { return !m_searchText.isEmpty(); }
+    void refreshSearch();
+    void openToolWindow(const ToolHandle &tool);
     void checkForUpdates(bool manual);
     void downloadUpdate(const QUrl &url, const QVersionNumber &remoteVersion);
     bool launchUpdater(const QString &zipPath, const QString &logPath);
@@ -56,7 +74,8 @@ private:
     };
 
     CoreService *m_core{nullptr};
-    QString m_toolsRoot;
+    ScanOptionsDTO m_scanOptions;
+    QString m_toolsRoot; // primary root, hosts the placeholder assets
 
     QListWidget *m_categoryList{nullptr};
     QListWidget *m_toolList{nullptr};
@@ -64,9 +83,15 @@ private:
     QPushButton *m_toggleViewBtn{nullptr};
     QPushButton *m_updateBtn{nullptr};
     QLabel *m_summaryLabel{nullptr};
+    QLineEdit *m_searchEdit{nullptr};
+
+    ToolSearchIndex m_searchIndex;
+    QString m_searchText;
+    QList<ToolSearchIndex::Hit> m_searchResults;
+    mutable QHash<QString, QIcon> m_iconCache; // keyed by tool dir + thumbnail
 
-    QList<ToolDTO> m_tools;
     bool m_cardMode{true};
+    bool m_streamPending{false};
     QNetworkAccessManager m_network;
     UpdateMeta m_latestMeta;
 };
@@ -1,30 +1,52 @@
 #include "ToolWindow.h"
 
 #include "core/CoreService.h"
+#include "core/ParamSweep.h"
 #include "ui/DynamicForm.h"
 
 #include <QCoreApplication>
 #include <QDialog>
 #include <QDialogButtonBox>
+#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
 #include <QListWidget>
+#include <QLocale>
+#include <QPlainTextEdit>
+#include <QProgressBar>
 #include <QPushButton>
-#include <QTextEdit>
+#include <QScrollBar>
+#include <QSpinBox>
+#include <QTextCharFormat>
+#include <QTextCursor>
 #include <QVBoxLayout>
 #include <QWidget>
 
-ToolWindow::ToolWindow(CoreService *core, const QString &toolsRoot, const ToolDTO &tool, QWidget *parent)
+namespace
+{
+// Older lines scroll out of the view; the complete output stays in the run's
+// logs/ directory.
+constexpr int kMaxLogLines = 10000;
+} // namespace
+
+ToolWindow::ToolWindow(CoreService *core, const QString &toolsRoot, const ToolHandle &tool, QWidget *parent)
     : QMainWindow(parent), m_core(core), m_toolsRoot(toolsRoot), m_tool(tool), m_settings(QCoreApplication::organizationName(), QCoreApplication::applicationName())
 {
     m_override = loadOverride();
     buildUi();
 
+    connect(m_core, &CoreService::jobQueued, this, &ToolWindow::handleJobQueued);
     connect(m_core, &CoreService::jobStarted, this, &ToolWindow::handleJobStarted);
     connect(m_core, &CoreService::jobOutput, this, &ToolWindow::handleJobOutput);
+    connect(m_core, &CoreService::jobMetrics, this, &ToolWindow::handleJobMetrics);
+    connect(m_core, &CoreService::jobProgress, this, &ToolWindow::handleJobProgress);
     connect(m_core, &CoreService::jobFinished, this, &ToolWindow::handleJobFinished);
+    connect(m_core, &CoreService::batchProgress, this, &ToolWindow::handleBatchProgress);
+    connect(m_core, &CoreService::batchFinished, this, &ToolWindow::handleBatchFinished);
     connect(m_core, &CoreService::envPreparing, this, &ToolWindow::handleEnvPreparing);
     connect(m_core, &CoreService::envFailed, this, &ToolWindow::handleEnvFailed);
     connect(m_core, &CoreService::envReady, this, &ToolWindow::handleEnvReady);
@@ -37,20 +59,20 @@ void ToolWindow::buildUi()
     layout->setContentsMargins(8, 8, 8, 8);
     layout->setSpacing(6);
 
-    auto *title = new QLabel(QStringLiteral("%1 (%2)").arg(m_tool.name, m_tool.id), central);
+    auto *title = new QLabel(QStringLiteral("%1 (%2)").arg(m_tool->name, m_tool->id), central);
     title->setStyleSheet(QStringLiteral("font-size:18px;font-weight:bold;"));
     layout->addWidget(title);
 
-    if (!m_tool.description.isEmpty())
+    if (!m_tool->description.isEmpty())
     {
-        auto *desc = new QLabel(m_tool.description, central);
+        auto *desc = new QLabel(m_tool->description, central);
         desc->setWordWrap(true);
         desc->setStyleSheet(QStringLiteral("color:#555;"));
         layout->addWidget(desc);
     }
 
     m_form = new DynamicForm(central);
-    m_form->setParams(m_tool.params);
+    m_form->setParams(m_tool->params);
     layout->addWidget(m_form, 0);
 
     auto *advRow = new QWidget(central);
@@ -85,12 +107,32 @@ void ToolWindow::buildUi()
     btnLayout->setContentsMargins(0, 0, 0, 0);
     btnLayout->addStretch(1);
     m_runBtn = new QPushButton(tr("运行"), btnRow);
+    m_batchBtn = new QPushButton(tr("批量运行"), btnRow);
+    m_stopBtn = new QPushButton(tr("停止"), btnRow);
+    m_stopBtn->setEnabled(false);
+    btnLayout->addWidget(m_batchBtn);
     btnLayout->addWidget(m_runBtn);
+    btnLayout->addWidget(m_stopBtn);
     btnRow->setLayout(btnLayout);
     layout->addWidget(btnRow);
 
-    m_log = new QTextEdit(central);
+    // Shown while a run reports progress (see RunProgress); hidden otherwise.
+    m_progressRow = new QWidget(central);
+    auto *progressLayout = new QHBoxLayout(m_progressRow);
+    progressLayout->setContentsMargins(0, 0, 0, 0);
+    m_progressBar = new QProgressBar(m_progressRow);
+    m_progressBar->setRange(0, 1000);
+    m_progressBar->setTextVisible(false);
+    m_progressLabel = new QLabel(m_progressRow);
+    m_progressLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    progressLayout->addWidget(m_progressBar, 1);
+    progressLayout->addWidget(m_progressLabel, 2);
+    m_progressRow->setVisible(false);
+    layout->addWidget(m_progressRow);
+
+    m_log = new QPlainTextEdit(central);
     m_log->setReadOnly(true);
+    m_log->setMaximumBlockCount(kMaxLogLines);
     m_log->setMinimumHeight(200);
     layout->addWidget(m_log, 1);
 
@@ -99,20 +141,215 @@ void ToolWindow::buildUi()
     updateAdvSummary(m_override);
 
     connect(m_runBtn, &QPushButton::clicked, this, &ToolWindow::handleRunClicked);
+    connect(m_batchBtn, &QPushButton::clicked, this, &ToolWindow::handleBatchClicked);
+    connect(m_stopBtn, &QPushButton::clicked, this, &ToolWindow::handleStopClicked);
     connect(m_advBtn, &QPushButton::clicked, this, &ToolWindow::handleAdvancedClicked);
 }
 
-void ToolWindow::handleRunClicked()
+RunRequestDTO ToolWindow::buildRequest() const
 {
     RunRequestDTO req;
-    req.toolId = m_tool.id;
-    req.toolVersion = m_tool.version;
+    req.toolId = m_tool->id;
+    req.toolVersion = m_tool->version;
     req.params = m_form->collectValues();
     req.runDirectory = m_outputDirEdit->text();
     req.interpreterOverride = m_override.program;
+    return req;
+}
+
+void ToolWindow::handleRunClicked()
+{
+    const QString runId = m_core->runTool(m_toolsRoot, m_tool, buildRequest());
+    if (runId.isEmpty())
+    {
+        appendLog(tr("无法启动运行"), true);
+        return;
+    }
+    m_runIds.insert(runId);
+    updateStopButton();
+    appendRunLog(runId, tr("开始运行..."));
+}
+
+void ToolWindow::handleBatchClicked()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("批量运行"));
+    auto *layout = new QVBoxLayout(&dialog);
+
+    auto *hint = new QLabel(tr("为要扫描的参数填写取值：逗号分隔；数值参数可写范围 16..360:8；选项/开关参数可写 * 表示全部。"
+                               "留空的参数使用表单当前值。"),
+                            &dialog);
+    hint->setWordWrap(true);
+    layout->addWidget(hint);
+
+    auto *axisForm = new QFormLayout();
+    QList<QPair<ParamDTO, QLineEdit *>> axisEdits;
+    for (const ParamDTO &param : m_tool->params)
+    {
+        auto *edit = new QLineEdit(&dialog);
+        switch (param.type)
+        {
+        case ParamType::Int:
+        case ParamType::Float:
+            edit->setPlaceholderText(tr("如 16..360:8 或 16,32,64"));
+            break;
+        case ParamType::Select:
+        case ParamType::Bool:
+            edit->setPlaceholderText(tr("* 或 a,b,c"));
+            break;
+        default:
+            edit->setPlaceholderText(tr("a,b,c"));
+            break;
+        }
+        axisForm->addRow(param.label.isEmpty() ? param.key : param.label, edit);
+        axisEdits.append({param, edit});
+    }
+    layout->addLayout(axisForm);
+
+    auto *csvRow = new QWidget(&dialog);
+    auto *csvLayout = new QHBoxLayout(csvRow);
+    csvLayout->setContentsMargins(0, 0, 0, 0);
+    auto *csvLabel = new QLabel(tr("CSV：未使用"), csvRow);
+    auto *csvBtn = new QPushButton(tr("从 CSV 导入"), csvRow);
+    auto *csvClearBtn = new QPushButton(tr("清除"), csvRow);
+    csvLayout->addWidget(csvLabel, 1);
+    csvLayout->addWidget(csvBtn);
+    csvLayout->addWidget(csvClearBtn);
+    layout->addWidget(csvRow);
+
+    auto *limitRow = new QWidget(&dialog);
+    auto *limitLayout = new QHBoxLayout(limitRow);
+    limitLayout->setContentsMargins(0, 0, 0, 0);
+    auto *limitSpin = new QSpinBox(limitRow);
+    limitSpin->setRange(1, 1024);
+    limitSpin->setValue(m_core->maxConcurrentJobs());
+    limitLayout->addWidget(new QLabel(tr("并发数"), limitRow));
+    limitLayout->addWidget(limitSpin);
+    limitLayout->addStretch(1);
+    layout->addWidget(limitRow);
+
+    auto *countLabel = new QLabel(&dialog);
+    layout->addWidget(countLabel);
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    layout->addWidget(buttons);
+
+    QList<QList<RunParamValueDTO>> csvRows;
+    auto buildBatch = [&](BatchRequestDTO &batch, QString &error) {
+        batch.base = buildRequest();
+        batch.maxConcurrent = limitSpin->value();
+        if (!csvRows.isEmpty())
+        {
+            batch.rows = csvRows;
+            return true;
+        }
+        for (const auto &[param, edit] : axisEdits)
+        {
+            if (edit->text().trimmed().isEmpty())
+            {
+                continue;
+            }
+            SweepAxisDTO axis;
+            axis.key = param.key;
+            if (!ParamSweep::parseAxis(param, edit->text(), axis.values, error))
+            {
+                return false;
+            }
+            batch.axes.append(axis);
+        }
+        return true;
+    };
+    auto refresh = [&]() {
+        BatchRequestDTO batch;
+        QString error;
+        bool ok = buildBatch(batch, error);
+        const qint64 count = ok ? ParamSweep::runCount(batch) : 0;
+        if (ok && count > ParamSweep::kMaxRuns)
+        {
+            ok = false;
+            error = tr("运行次数超过上限 %1").arg(ParamSweep::kMaxRuns);
+        }
+        countLabel->setText(ok ? tr("共 %1 次运行").arg(count) : error);
+        countLabel->setStyleSheet(ok ? QString() : QStringLiteral("color:red;"));
+        buttons->button(QDialogButtonBox::Ok)->setEnabled(ok);
+    };
+
+    for (const auto &entry : axisEdits)
+    {
+        connect(entry.second, &QLineEdit::textChanged, &dialog, refresh);
+    }
+    connect(limitSpin, qOverload<int>(&QSpinBox::valueChanged), &dialog, refresh);
+    connect(csvBtn, &QPushButton::clicked, &dialog, [&]()
+            {
+        const QString path = QFileDialog::getOpenFileName(&dialog, tr("选择参数 CSV"), QString(), tr("CSV 文件 (*.csv);;所有文件 (*)"));
+        if (path.isEmpty())
+        {
+            return;
+        }
+        QFile file(path);
+        QString error;
+        QList<QList<RunParamValueDTO>> rows;
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            error = file.errorString();
+        }
+        else if (ParamSweep::parseCsv(QString::fromUtf8(file.readAll()), m_tool->params, rows, error))
+        {
+            csvRows = rows;
+            csvLabel->setText(tr("CSV：%1（%2 行）").arg(QFileInfo(path).fileName()).arg(rows.size()));
+            for (const auto &entry : axisEdits)
+            {
+                entry.second->setEnabled(false);
+            }
+            refresh();
+            return;
+        }
+        csvLabel->setText(tr("CSV 无效：%1").arg(error)); });
+    connect(csvClearBtn, &QPushButton::clicked, &dialog, [&]()
+            {
+        csvRows.clear();
+        csvLabel->setText(tr("CSV：未使用"));
+        for (const auto &entry : axisEdits)
+        {
+            entry.second->setEnabled(true);
+        }
+        refresh(); });
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    refresh();
+
+    if (dialog.exec() != QDialog::Accepted)
+    {
+        return;
+    }
 
-    appendLog(tr("开始运行..."));
-    m_core->runTool(m_toolsRoot, m_tool, req);
+    BatchRequestDTO batch;
+    QString error;
+    QString batchId;
+    if (buildBatch(batch, error))
+    {
+        batchId = m_core->runBatch(m_toolsRoot, m_tool, batch, error);
+    }
+    if (batchId.isEmpty())
+    {
+        appendLog(tr("批量运行失败：%1").arg(error), true);
+        return;
+    }
+    m_batchIds.insert(batchId);
+    updateStopButton();
+    appendLog(tr("批量 %1 已提交：共 %2 次运行，并发 %3").arg(batchId).arg(ParamSweep::runCount(batch)).arg(batch.maxConcurrent));
+}
+
+void ToolWindow::handleStopClicked()
+{
+    for (const QString &batchId : QSet<QString>(m_batchIds))
+    {
+        m_core->cancelBatch(batchId);
+    }
+    for (const QString &runId : QSet<QString>(m_runIds))
+    {
+        m_core->cancelRun(runId);
+    }
 }
 
 void ToolWindow::handleAdvancedClicked()
@@ -157,52 +394,217 @@ void ToolWindow::handleAdvancedClicked()
     }
 }
 
-void ToolWindow::handleJobStarted(const QString &toolId, const QString &runDirectory)
+void ToolWindow::handleJobQueued(const QString &runId, const QString &toolId, int position)
+{
+    Q_UNUSED(toolId);
+    if (!m_runIds.contains(runId))
+        return;
+    appendRunLog(runId, tr("排队中，前方还有 %1 个任务").arg(position - 1));
+}
+
+void ToolWindow::handleJobStarted(const QString &runId, const QString &toolId, const QString &runDirectory)
 {
-    if (toolId != m_tool.id)
+    Q_UNUSED(toolId);
+    if (!m_runIds.contains(runId))
         return;
-    appendLog(tr("已启动，运行目录：%1").arg(runDirectory));
+    appendRunLog(runId, tr("已启动，运行目录：%1").arg(runDirectory));
 }
 
-void ToolWindow::handleJobOutput(const QString &toolId, const QString &line, bool isError)
+void ToolWindow::handleJobOutput(const QString &runId, const QString &toolId, const QStringList &lines, bool isError)
 {
-    if (toolId != m_tool.id)
+    Q_UNUSED(toolId);
+    if (!m_runIds.contains(runId))
         return;
-    appendLog(line, isError);
+    for (const QString &line : lines)
+        appendRunLog(runId, line, isError);
+}
+
+void ToolWindow::handleJobMetrics(const QString &runId, const QString &toolId, const RunMetricsDTO &metrics)
+{
+    Q_UNUSED(toolId);
+    if (!m_runIds.contains(runId))
+        return;
+    const QLocale locale;
+    QString text = tr("耗时 %1 秒").arg(metrics.wallMs / 1000.0, 0, 'f', 1);
+    if (metrics.sampled)
+    {
+        text += tr("，CPU 用户 %1 秒 / 系统 %2 秒，峰值内存 %3，读 %4 / 写 %5，上下文切换 %6 / %7（主动/被动），进程 %8 个")
+                    .arg(metrics.userCpuMs / 1000.0, 0, 'f', 1)
+                    .arg(metrics.systemCpuMs / 1000.0, 0, 'f', 1)
+                    .arg(locale.formattedDataSize(metrics.peakRssBytes))
+                    .arg(locale.formattedDataSize(metrics.readBytes))
+                    .arg(locale.formattedDataSize(metrics.writeBytes))
+                    .arg(metrics.voluntaryCtxSwitches)
+                    .arg(metrics.involuntaryCtxSwitches)
+                    .arg(metrics.processes);
+    }
+    appendRunLog(runId, text);
 }
 
-void ToolWindow::handleJobFinished(const QString &toolId, int exitCode, const QString &message)
+void ToolWindow::handleJobProgress(const QString &runId, const QString &toolId, const RunProgressDTO &progress)
 {
-    if (toolId != m_tool.id)
+    Q_UNUSED(toolId);
+    if (!m_runIds.contains(runId))
         return;
-    appendLog(tr("完成：%1 (%2)").arg(exitCode).arg(message), exitCode != 0);
+    // One row for the window: it follows whichever run reported last.
+    if (runId != m_progressRunId)
+    {
+        m_progressRunId = runId;
+        m_progressClock.start();
+        m_progressStart = qMax(0.0, progress.fraction);
+    }
+
+    if (progress.fraction >= 0)
+    {
+        m_progressBar->setRange(0, 1000);
+        m_progressBar->setValue(qRound(progress.fraction * 1000));
+    }
+    else
+    {
+        m_progressBar->setRange(0, 0); // busy indicator
+    }
+
+    QStringList parts;
+    if (m_runIds.size() > 1)
+        parts << QStringLiteral("[%1]").arg(runId);
+    if (!progress.stage.isEmpty())
+        parts << tr("阶段：%1").arg(progress.stage);
+    if (progress.fraction >= 0)
+        parts << QStringLiteral("%1%").arg(progress.fraction * 100, 0, 'f', 1);
+    if (progress.done >= 0)
+        parts << (progress.total > 0 ? QStringLiteral("%1/%2").arg(progress.done).arg(progress.total) : QString::number(progress.done));
+    for (auto it = progress.counters.cbegin(); it != progress.counters.cend(); ++it)
+        parts << QStringLiteral("%1=%2").arg(it.key()).arg(it.value(), 0, 'g', 6);
+    // Linear extrapolation from what was done since the first report.
+    const double advanced = progress.fraction - m_progressStart;
+    if (progress.fraction > 0 && progress.fraction < 1 && advanced > 0 && m_progressClock.elapsed() >= 2000)
+    {
+        const qint64 remainingSeconds = qRound64(m_progressClock.elapsed() * (1.0 - progress.fraction) / advanced / 1000.0);
+        parts << tr("预计剩余 %1").arg(QStringLiteral("%1:%2").arg(remainingSeconds / 60).arg(remainingSeconds % 60, 2, 10, QLatin1Char('0')));
+    }
+    if (!progress.message.isEmpty())
+        parts << progress.message;
+    m_progressLabel->setText(parts.join(QStringLiteral("  ")));
+    m_progressRow->setVisible(true);
+}
+
+void ToolWindow::handleJobFinished(const QString &runId, const QString &toolId, int exitCode, const QString &message)
+{
+    Q_UNUSED(toolId);
+    if (!m_runIds.contains(runId))
+        return;
+    appendRunLog(runId, tr("完成：%1 (%2)").arg(exitCode).arg(message), exitCode != 0);
+    m_runIds.remove(runId);
+    if (runId == m_progressRunId)
+        resetProgress();
+    updateStopButton();
+}
+
+void ToolWindow::handleBatchProgress(const QString &batchId, int finished, int total)
+{
+    if (!m_batchIds.contains(batchId))
+        return;
+    // Report roughly every 5% so large sweeps do not drown the log.
+    const int step = qMax(1, total / 20);
+    if (finished % step == 0 && finished != total)
+    {
+        appendLog(tr("批量 %1：%2/%3 已完成").arg(batchId).arg(finished).arg(total));
+    }
+}
+
+void ToolWindow::handleBatchFinished(const BatchSummaryDTO &summary)
+{
+    if (!m_batchIds.remove(summary.batchId))
+        return;
+    updateStopButton();
+
+    appendLog(tr("批量 %1 完成：成功 %2，失败 %3，取消 %4，用时 %5 秒")
+                  .arg(summary.batchId)
+                  .arg(summary.succeeded)
+                  .arg(summary.failed)
+                  .arg(summary.cancelled)
+                  .arg(summary.wallMs / 1000.0, 0, 'f', 1),
+              summary.failed > 0);
+    int listed = 0;
+    for (const BatchRunResultDTO &run : summary.runs)
+    {
+        if (run.status != QStringLiteral("failed"))
+            continue;
+        if (++listed > 10)
+        {
+            appendLog(tr("……其余失败记录见汇总文件"), true);
+            break;
+        }
+        QStringList values;
+        for (const RunParamValueDTO &param : run.params)
+        {
+            values << QStringLiteral("%1=%2").arg(param.key, param.values.join(QLatin1Char(';')));
+        }
+        appendLog(tr("失败：%1 (%2)").arg(values.join(QStringLiteral(", ")), run.message), true);
+    }
+    if (!summary.summaryPath.isEmpty())
+    {
+        appendLog(tr("汇总：%1").arg(summary.summaryPath));
+    }
 }
 
 void ToolWindow::handleEnvPreparing(const QString &toolId)
 {
-    if (toolId != m_tool.id)
+    if (toolId != m_tool->id)
         return;
     appendLog(tr("环境准备中..."));
 }
 
 void ToolWindow::handleEnvFailed(const QString &toolId, const QString &message)
 {
-    if (toolId != m_tool.id)
+    if (toolId != m_tool->id)
         return;
     appendLog(tr("环境失败：%1").arg(message), true);
 }
 
 void ToolWindow::handleEnvReady(const QString &toolId, const QString &envPath)
 {
-    if (toolId != m_tool.id)
+    if (toolId != m_tool->id)
         return;
     appendLog(tr("环境就绪：%1").arg(envPath));
 }
 
 void ToolWindow::appendLog(const QString &text, bool isError)
 {
-    const QString line = isError ? QStringLiteral("<span style='color:red;'>%1</span>").arg(text) : text;
-    m_log->append(line);
+    // Tool output is plain text: inserting it with a char format keeps markup
+    // in it from being rendered and keeps error colouring off later lines.
+    QScrollBar *bar = m_log->verticalScrollBar();
+    const bool atBottom = bar->value() == bar->maximum();
+    QTextCharFormat format;
+    if (isError)
+        format.setForeground(Qt::red);
+    QTextCursor cursor(m_log->document());
+    cursor.movePosition(QTextCursor::End);
+    if (!m_log->document()->isEmpty())
+        cursor.insertBlock(QTextBlockFormat(), format);
+    cursor.insertText(text, format);
+    if (atBottom)
+        bar->setValue(bar->maximum());
+}
+
+void ToolWindow::appendRunLog(const QString &runId, const QString &text, bool isError)
+{
+    // Tag lines only while several runs of this window interleave their output.
+    appendLog(m_runIds.size() > 1 ? QStringLiteral("[%1] %2").arg(runId, text) : text, isError);
+}
+
+void ToolWindow::updateStopButton()
+{
+    m_stopBtn->setEnabled(!m_runIds.isEmpty() || !m_batchIds.isEmpty());
+}
+
+void ToolWindow::resetProgress()
+{
+    m_progressRunId.clear();
+    m_progressRow->setVisible(false);
+    m_progressBar->setRange(0, 1000);
+    m_progressBar->setValue(0);
+    m_progressLabel->clear();
 }
 
 void ToolWindow::updateAdvSummary(const AdvOverride &ov)
@@ -214,7 +616,7 @@ void ToolWindow::updateAdvSummary(const AdvOverride &ov)
 ToolWindow::AdvOverride ToolWindow::loadOverride()
 {
     AdvOverride ov;
-    m_settings.beginGroup(QStringLiteral("toolOverrides/%1").arg(m_tool.id));
+    m_settings.beginGroup(QStringLiteral("toolOverrides/%1").arg(m_tool->id));
     ov.program = m_settings.value(QStringLiteral("program")).toString();
     m_settings.endGroup();
     return ov;
@@ -222,7 +624,7 @@ ToolWindow::AdvOverride ToolWindow::loadOverride()
 
 void ToolWindow::saveOverride(const AdvOverride &ov)
 {
-    m_settings.beginGroup(QStringLiteral("toolOverrides/%1").arg(m_tool.id));
+    m_settings.beginGroup(QStringLiteral("toolOverrides/%1").arg(m_tool->id));
     m_settings.setValue(QStringLiteral("program"), ov.program);
     m_settings.endGroup();
 }
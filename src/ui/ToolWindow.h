@@ -2,13 +2,16 @@
 
 #include "common/Dto.h"
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QMap>
+#include <QSet>
 #include <QSettings>
 
 class CoreService;
 class DynamicForm;
-class QTextEdit;
+class QPlainTextEdit;
+class QProgressBar;
 class QPushButton;
 class QLineEdit;
 class QLabel;
@@ -17,14 +20,21 @@ class ToolWindow : public QMainWindow
 {
     Q_OBJECT
 public:
-    ToolWindow(CoreService *core, const QString &toolsRoot, const ToolDTO &tool, QWidget *parent = nullptr);
+    ToolWindow(CoreService *core, const QString &toolsRoot, const ToolHandle &tool, QWidget *parent = nullptr);
 
 private slots:
     void handleRunClicked();
+    void handleBatchClicked();
+    void handleStopClicked();
     void handleAdvancedClicked();
-    void handleJobStarted(const QString &toolId, const QString &runDirectory);
-    void handleJobOutput(const QString &toolId, const QString &line, bool isError);
-    void handleJobFinished(const QString &toolId, int exitCode, const QString &message);
+    void handleJobQueued(const QString &runId, const QString &toolId, int position);
+    void handleJobStarted(const QString &runId, const QString &toolId, const QString &runDirectory);
+    void handleJobOutput(const QString &runId, const QString &toolId, const QStringList &lines, bool isError);
+    void handleJobMetrics(const QString &runId, const QString &toolId, const RunMetricsDTO &metrics);
+    void handleJobProgress(const QString &runId, const QString &toolId, const RunProgressDTO &progress);
+    void handleJobFinished(const QString &runId, const QString &toolId, int exitCode, const QString &message);
+    void handleBatchProgress(const QString &batchId, int finished, int total);
+    void handleBatchFinished(const BatchSummaryDTO &summary);
     void handleEnvPreparing(const QString &toolId);
     void handleEnvFailed(const QString &toolId, const QString &message);
     void handleEnvReady(const QString &toolId, const QString &envPath);
@@ -36,22 +46,36 @@ private:
     };
 
     void buildUi();
+    RunRequestDTO buildRequest() const;
+    void updateStopButton();
+    void resetProgress();
     void appendLog(const QString &text, bool isError = false);
+    void appendRunLog(const QString &runId, const QString &text, bool isError = false);
     void updateAdvSummary(const AdvOverride &ov);
     AdvOverride loadOverride();
     void saveOverride(const AdvOverride &ov);
 
     CoreService *m_core{nullptr};
     QString m_toolsRoot;
-    ToolDTO m_tool;
+    ToolHandle m_tool;
 
     DynamicForm *m_form{nullptr};
-    QTextEdit *m_log{nullptr};
+    QPlainTextEdit *m_log{nullptr};
+    QWidget *m_progressRow{nullptr};
+    QProgressBar *m_progressBar{nullptr};
+    QLabel *m_progressLabel{nullptr};
     QPushButton *m_runBtn{nullptr};
+    QPushButton *m_batchBtn{nullptr};
+    QPushButton *m_stopBtn{nullptr};
     QPushButton *m_advBtn{nullptr};
     QLabel *m_advSummary{nullptr};
     QLineEdit *m_outputDirEdit{nullptr};
 
+    QSet<QString> m_runIds;   // runs started from this window and not yet finished
+    QSet<QString> m_batchIds; // likewise for batches
+    QString m_progressRunId;  // run shown in the progress row
+    QElapsedTimer m_progressClock; // since its first report, for the ETA
+    double m_progressStart{0.0};   // fraction at that report
     AdvOverride m_override;
     QSettings m_settings;
 };
@@ -0,0 +1,86 @@
+"""Progress reporting for Script Toolbox tools.
+
+The toolbox reads progress from lines of the run's output that start with
+"##toolbox:" followed by a JSON object. It shows them as a progress bar and
+records the last state in metadata.json, and it keeps them out of the output
+view. This module writes those lines::
+
+    import os
+    import sys
+
+    sys.path.insert(0, os.environ["TOOLBOX_LIB"])
+    from toolbox_progress import counters, progress, stage, track
+
+    stage("load")
+    rows = load()
+    stage("fit")
+    for row in track(rows):  # done/total, throttled
+        fit(row)
+    counters(loss=0.31, skipped=4)
+    progress(1.0, message="done")
+
+Nothing is written unless TOOLBOX_PROGRESS=1, which the toolbox sets for
+every run, so the same script stays quiet when it is run by hand. Reports go
+to stdout, so they also work in warm interpreters and runtime.mode: server
+handlers.
+"""
+from __future__ import annotations
+
+import json
+import os
+import sys
+import time
+from typing import Iterable, Iterator, Optional, TypeVar
+
+PREFIX = "##toolbox:"
+
+T = TypeVar("T")
+
+
+def enabled() -> bool:
+    return os.environ.get("TOOLBOX_PROGRESS") == "1"
+
+
+def report(**fields) -> None:
+    """Send one report; fields as in the protocol, None values are left out."""
+    if not enabled():
+        return
+    fields = {key: value for key, value in fields.items() if value is not None}
+    if not fields:
+        return
+    # sys.stdout is looked up on every call: a server handler's stdout is
+    # replaced per request.
+    sys.stdout.write(PREFIX + json.dumps(fields) + "\n")
+    sys.stdout.flush()
+
+
+def progress(fraction: Optional[float] = None, done: Optional[int] = None, total: Optional[int] = None,
+             message: Optional[str] = None) -> None:
+    report(progress=fraction, done=done, total=total, message=message)
+
+
+def stage(name: str, message: Optional[str] = None) -> None:
+    report(stage=name, message=message)
+
+
+def counters(**values: float) -> None:
+    report(counters=values)
+
+
+def track(items: Iterable[T], total: Optional[int] = None, interval: float = 0.5) -> Iterator[T]:
+    """Yield from items, reporting done/total at most every interval seconds."""
+    if total is None:
+        try:
+            total = len(items)  # type: ignore[arg-type]
+        except TypeError:
+            total = None
+    last = 0.0
+    done = 0
+    for item in items:
+        now = time.monotonic()
+        if now - last >= interval:
+            report(done=done, total=total)
+            last = now
+        yield item
+        done += 1
+    report(done=done, total=total if total is not None else done)
@@ -0,0 +1,153 @@
+"""Helper for runtime.mode: server tools.
+
+The toolbox starts a server-mode tool once and sends each run to it as a
+JSON line on stdin. This module speaks that protocol::
+
+    import os
+    import sys
+
+    sys.path.insert(0, os.environ["TOOLBOX_LIB"])
+    from toolbox_server import serve
+
+    model = load_model()  # once, before serve()
+
+    def handle(request):
+        # request.args, request.params, request.run_dir, request.output_dir
+        print("scored", len(request.args))  # the run's stdout
+        return 0  # exit code; None counts as 0
+
+    serve(handle)
+
+While a request is handled, TOOL_OUTPUT_DIR and TOOL_RUN_DIR are set and the
+working directory is the run directory, as for a normal run. print() and
+sys.stderr become the run's output. An uncaught exception fails the run with
+exit code 1 and its traceback in stderr.
+"""
+from __future__ import annotations
+
+import json
+import os
+import sys
+import traceback
+from dataclasses import dataclass, field
+from typing import Callable, Optional
+
+
+@dataclass
+class Request:
+    id: str
+    args: list = field(default_factory=list)
+    params: dict = field(default_factory=dict)  # key -> str, or list for multi-value params
+    run_dir: str = ""
+    output_dir: str = ""
+    env: dict = field(default_factory=dict)
+
+
+class _RunStream:
+    """Text stream that turns writes into log messages of one request."""
+
+    encoding = "utf-8"
+
+    def __init__(self, send: Callable[[dict], None], run_id: str, stream: str) -> None:
+        self._send = send
+        self._run_id = run_id
+        self._stream = stream
+        self._pending = ""
+
+    def write(self, text: str) -> int:
+        self._pending += text
+        *lines, self._pending = self._pending.split("\n")
+        for line in lines:
+            self._emit(line)
+        return len(text)
+
+    def flush(self) -> None:
+        if self._pending:
+            self._emit(self._pending)
+            self._pending = ""
+
+    def isatty(self) -> bool:
+        return False
+
+    def _emit(self, line: str) -> None:
+        self._send({"type": "log", "id": self._run_id, "stream": self._stream, "text": line})
+
+
+def _exit_code(exc: SystemExit) -> int:
+    if exc.code is None:
+        return 0
+    if isinstance(exc.code, int):
+        return exc.code
+    print(exc.code, file=sys.stderr)
+    return 1
+
+
+def _run(handler: Callable[[Request], Optional[int]], message: dict, send: Callable[[dict], None], home: str) -> dict:
+    request = Request(
+        id=str(message.get("id", "")),
+        args=[str(arg) for arg in message.get("args", [])],
+        params=dict(message.get("params", {})),
+        run_dir=message.get("runDir", ""),
+        output_dir=message.get("outputDir", ""),
+        env={str(k): str(v) for k, v in message.get("env", {}).items()},
+    )
+    saved_env = {name: os.environ.get(name) for name in request.env}
+    saved_streams = sys.stdout, sys.stderr
+    out = _RunStream(send, request.id, "stdout")
+    err = _RunStream(send, request.id, "stderr")
+    exit_code = 0
+    try:
+        os.environ.update(request.env)
+        if request.run_dir:
+            os.chdir(request.run_dir)
+        sys.stdout, sys.stderr = out, err
+        try:
+            result = handler(request)
+            exit_code = 0 if result is None else int(result)
+        except SystemExit as exc:
+            exit_code = _exit_code(exc)
+        except Exception:
+            traceback.print_exc()
+            exit_code = 1
+    finally:
+        out.flush()
+        err.flush()
+        sys.stdout, sys.stderr = saved_streams
+        os.chdir(home)
+        for name, value in saved_env.items():
+            if value is None:
+                os.environ.pop(name, None)
+            else:
+                os.environ[name] = value
+    return {"type": "result", "id": request.id, "exitCode": exit_code}
+
+
+def serve(handler: Callable[[Request], Optional[int]]) -> None:
+    """Answer requests until the toolbox shuts the server down."""
+    protocol = sys.stdout
+    # stdout carries the protocol; anything printed outside a request goes to
+    # stderr, which the toolbox logs.
+    sys.stdout = sys.stderr
+
+    def send(message: dict) -> None:
+        # ASCII-only JSON is safe whatever encoding the console uses.
+        protocol.write(json.dumps(message) + "\n")
+        protocol.flush()
+
+    home = os.getcwd()
+    send({"type": "ready"})
+    for raw in sys.stdin.buffer:
+        line = raw.decode("utf-8", errors="replace").strip()
+        if not line:
+            continue
+        try:
+            message = json.loads(line)
+        except ValueError:
+            continue
+        kind = message.get("type")
+        if kind == "ping":
+            send({"type": "pong", "id": message.get("id")})
+        elif kind == "shutdown":
+            break
+        elif kind == "run":
+            send(_run(handler, message, send, home))
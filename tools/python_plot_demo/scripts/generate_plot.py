@@ -5,10 +5,21 @@ from __future__ import annotations
 import argparse
 import os
 import pathlib
+import sys
 
 import matplotlib.pyplot as plt
 import numpy as np
 
+try:
+    sys.path.insert(0, os.environ["TOOLBOX_LIB"])
+    from toolbox_progress import counters, stage
+except (KeyError, ImportError):  # run outside the toolbox
+    def stage(name, message=None):
+        pass
+
+    def counters(**values):
+        pass
+
 
 def parse_args() -> argparse.Namespace:
     parser = argparse.ArgumentParser(description="Python plot demo tool")
@@ -39,8 +50,10 @@ def build_series(points: int) -> tuple[np.ndarray, np.ndarray, np.ndarray]:
 def main() -> int:
     args = parse_args()
     points = max(16, min(args.points, 720))
+    stage("data")
     x_axis, signal_a, signal_b = build_series(points)
 
+    stage("plot")
     fig, ax = plt.subplots(figsize=(8, 4.5), dpi=120)
     ax.plot(x_axis, signal_a, label="Sensor A", color="#2B6CB0", linewidth=2.2)
     ax.plot(x_axis, signal_b, label="Sensor B", color="#C53030", linewidth=2.0)
@@ -53,11 +66,13 @@ def main() -> int:
     ax.grid(alpha=0.25, linestyle="--")
     ax.legend(loc="upper right")
 
+    stage("save")
     output_dir = resolve_output_dir()
     figure_path = output_dir / "python_plot_demo.png"
     fig.tight_layout()
     fig.savefig(figure_path)
     plt.close(fig)
+    counters(points=points, bytes=figure_path.stat().st_size)
 
     print(f"[python_plot_demo] Plot saved to {figure_path}")
     print(f"[python_plot_demo] Rendered with {points} points per series")